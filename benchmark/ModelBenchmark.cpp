@@ -0,0 +1,155 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <deque>
+#include <execution>
+#include <vector>
+
+#include "../include/model/Model.hpp"
+#include "../include/utilities/Random.hpp"
+
+namespace bench::model {
+struct Agent {
+    explicit Agent(const int pValue) : value(pValue) {}
+    int value;
+    bool active{true};
+    double payload[6]{};
+
+    [[nodiscard]] bool isActive() const {
+        return active;
+    }
+};
+
+struct Model : agh::Model<Agent> {};
+
+struct Body {
+    double x{};
+    double y{};
+    double vx{};
+    double vy{};
+    double energy{1.};
+    double mass{1.};
+    int id{};
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+};
+
+struct SoaBody : Body {
+    static constexpr auto members = std::tuple{&SoaBody::x, &SoaBody::y, &SoaBody::vx, &SoaBody::vy,
+                                               &SoaBody::energy, &SoaBody::mass, &SoaBody::id};
+};
+
+struct BodyModel : agh::Model<Body, SoaBody> {};
+
+// Every iteration one percent of the agents die and the same number is born, after which all agents are visited.
+void churnPool(benchmark::State& state) {
+    Model model;
+    std::vector<Agent*> alive;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        alive.push_back(&model.emplaceAgent<Agent>(static_cast<int>(i)));
+    }
+
+    auto random = agh::Random(1).stream(0, 0);
+    const size_t turnover = alive.size() / 100;
+    for (auto _ : state) {
+        for (size_t i = 0; i < turnover; ++i) {
+            const size_t victim = random.below(static_cast<uint32_t>(alive.size()));
+            model.removeAgent(*alive[victim]);
+            alive[victim] = alive.back();
+            alive.pop_back();
+        }
+        for (size_t i = 0; i < turnover; ++i) {
+            alive.push_back(&model.emplaceAgent<Agent>(static_cast<int>(i)));
+        }
+
+        int64_t sum = 0;
+        for (const auto& agent : model.getAgents<Agent>()) {
+            sum += agent.value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.counters["slots"] = static_cast<double>(model.getAgents<Agent>().slots());
+}
+
+// The same workload with agents which can't be removed, so dead ones are only marked inactive and skipped.
+void churnDeque(benchmark::State& state) {
+    std::deque<Agent> agents;
+    std::vector<Agent*> alive;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        alive.push_back(&agents.emplace_back(static_cast<int>(i)));
+    }
+
+    auto random = agh::Random(1).stream(0, 0);
+    const size_t turnover = alive.size() / 100;
+    for (auto _ : state) {
+        for (size_t i = 0; i < turnover; ++i) {
+            const size_t victim = random.below(static_cast<uint32_t>(alive.size()));
+            alive[victim]->active = false;
+            alive[victim] = alive.back();
+            alive.pop_back();
+        }
+        for (size_t i = 0; i < turnover; ++i) {
+            alive.push_back(&agents.emplace_back(static_cast<int>(i)));
+        }
+
+        int64_t sum = 0;
+        for (const auto& agent : agents) {
+            if (agent.isActive()) {
+                sum += agent.value;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.counters["slots"] = static_cast<double>(agents.size());
+}
+
+// Every iteration drains energy of all agents, touching one member of the whole agent.
+void energyAos(benchmark::State& state) {
+    BodyModel model;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        model.emplaceAgent<Body>();
+    }
+    for (auto _ : state) {
+        for (auto& body : model.getAgents<Body>()) {
+            body.energy *= 0.99;
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+void energySoa(benchmark::State& state) {
+    BodyModel model;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        model.emplaceAgent<SoaBody>();
+    }
+    for (auto _ : state) {
+        for (double& energy : model.getAgents<SoaBody>().column<&SoaBody::energy>()) {
+            energy *= 0.99;
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+// Sums a function of every agent, sequentially and across the model's thread pool given by the second argument.
+void reduceBodies(benchmark::State& state) {
+    BodyModel model;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        model.emplaceAgent<Body>().x = static_cast<double>(i);
+    }
+    model.setThreads(state.range(1));
+    for (auto _ : state) {
+        const double sum = model.transformReduce<Body>(std::execution::par, 0., std::plus<>(), [](const Body& body) {
+            return std::sqrt(body.x * body.x + body.y * body.y);
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+BENCHMARK(churnPool)->Arg(1 << 14)->Arg(1 << 18)->Unit(benchmark::kMicrosecond);
+BENCHMARK(churnDeque)->Arg(1 << 14)->Arg(1 << 18)->Unit(benchmark::kMicrosecond);
+BENCHMARK(reduceBodies)->Args({1 << 20, 1})->Args({1 << 20, 4})->Unit(benchmark::kMicrosecond);
+BENCHMARK(energyAos)->Arg(1 << 14)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+BENCHMARK(energySoa)->Arg(1 << 14)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+}
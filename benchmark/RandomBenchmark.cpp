@@ -0,0 +1,43 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "../include/utilities/Random.hpp"
+
+namespace bench::random {
+void scalarDraws(benchmark::State& state) {
+    std::vector<uint32_t> values(static_cast<size_t>(state.range(0)));
+    auto stream = agh::Random(1).stream(0, 0);
+    for (auto _ : state) {
+        for (auto& value : values) {
+            value = stream();
+        }
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void batchDraws(benchmark::State& state) {
+    std::vector<uint32_t> values(static_cast<size_t>(state.range(0)));
+    auto stream = agh::Random(1).stream(0, 0);
+    for (auto _ : state) {
+        stream.fill(values);
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void batchUniform(benchmark::State& state) {
+    std::vector<double> values(static_cast<size_t>(state.range(0)));
+    auto stream = agh::Random(1).stream(0, 0);
+    for (auto _ : state) {
+        stream.fillUniform(values);
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(scalarDraws)->Arg(1 << 12)->Arg(1 << 20);
+BENCHMARK(batchDraws)->Arg(1 << 12)->Arg(1 << 20);
+BENCHMARK(batchUniform)->Arg(1 << 12)->Arg(1 << 20);
+}
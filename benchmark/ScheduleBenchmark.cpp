@@ -0,0 +1,135 @@
+#include <benchmark/benchmark.h>
+
+#include "../include/model/Model.hpp"
+#include "../include/schedule/Schedule.hpp"
+
+namespace bench::schedule {
+struct Agent {
+    bool active{true};
+    int run{};
+
+    [[nodiscard]] bool isActive() const {
+        return active;
+    }
+
+    template<typename T>
+    void step(T&) {
+        run += 1;
+    }
+};
+
+struct Model : agh::Model<Agent> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(int) const {
+        return false;
+    }
+};
+
+template<typename ScheduleT>
+void repeatingEveryStep(benchmark::State& state) {
+    Model model;
+    ScheduleT schedule(model);
+    const auto agents = static_cast<size_t>(state.range(0));
+    for (size_t i = 0; i < agents; ++i) {
+        schedule.scheduleRepeating(model.emplaceAgent<Agent>(), 0, i % 4, 1);
+    }
+
+    for (auto _ : state) {
+        schedule.step();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template<typename ScheduleT>
+void repeatingMixedIntervals(benchmark::State& state) {
+    Model model;
+    ScheduleT schedule(model);
+    const auto agents = static_cast<size_t>(state.range(0));
+    for (size_t i = 0; i < agents; ++i) {
+        schedule.scheduleRepeating(model.emplaceAgent<Agent>(), i % 16, i % 4, 1 + i % 16);
+    }
+
+    for (auto _ : state) {
+        schedule.step();
+    }
+}
+
+using Heap = agh::Schedule<Model, Agent>;
+using Calendar = agh::CalendarSchedule<Model, Agent>;
+
+// Agents which act once every 16 steps, written as a state machine stepped every time step.
+struct WaitingAgent {
+    int wait{};
+    int acted{};
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+
+    template<typename T>
+    void step(T&) {
+        if (++wait == 16) {
+            wait = 0;
+            acted += 1;
+        }
+    }
+};
+
+struct WaitingModel : agh::Model<WaitingAgent> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(int) const {
+        return false;
+    }
+};
+
+using WaitingSchedule = agh::Schedule<WaitingModel, WaitingAgent>;
+using WaitingCalendar = agh::CalendarSchedule<WaitingModel, WaitingAgent>;
+
+void sparseStateMachine(benchmark::State& state) {
+    WaitingModel model;
+    WaitingSchedule schedule(model);
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        schedule.scheduleRepeating(model.emplaceAgent<WaitingAgent>(), 0, 0, 1);
+    }
+
+    for (auto _ : state) {
+        schedule.step();
+    }
+}
+
+// The same agents written as coroutines, which are resumed only when they act.
+template<typename ScheduleT>
+agh::Behavior waiting(ScheduleT& schedule, WaitingAgent& agent) {
+    while (true) {
+        co_await schedule.delay(16);
+        agent.acted += 1;
+    }
+}
+
+template<typename ScheduleT>
+void sparseBehaviors(benchmark::State& state) {
+    WaitingModel model;
+    ScheduleT schedule(model);
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        schedule.spawn(waiting(schedule, model.emplaceAgent<WaitingAgent>()), i % 16, 0);
+    }
+
+    for (auto _ : state) {
+        schedule.step();
+    }
+}
+
+BENCHMARK(repeatingEveryStep<Heap>)->Arg(1 << 10)->Arg(1 << 16)->Arg(500'000)->Unit(benchmark::kMillisecond);
+BENCHMARK(repeatingEveryStep<Calendar>)->Arg(1 << 10)->Arg(1 << 16)->Arg(500'000)->Unit(benchmark::kMillisecond);
+BENCHMARK(repeatingMixedIntervals<Heap>)->Arg(1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK(repeatingMixedIntervals<Calendar>)->Arg(1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK(sparseStateMachine)->Arg(1 << 10)->Arg(1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK(sparseBehaviors<WaitingSchedule>)->Arg(1 << 10)->Arg(1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK(sparseBehaviors<WaitingCalendar>)->Arg(1 << 10)->Arg(1 << 16)->Unit(benchmark::kMillisecond);
+}
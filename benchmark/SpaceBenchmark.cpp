@@ -0,0 +1,227 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <deque>
+#include <execution>
+#include <optional>
+
+#include "../include/space/Field.hpp"
+#include "../include/space/ValueLayer.hpp"
+#include "../include/utilities/Random.hpp"
+
+namespace bench::space {
+struct Agent {
+    std::optional<agh::Point> pos;
+    int value{1};
+};
+
+// Field of the given side, where every cell is occupied with the given probability in percents.
+struct SparseField {
+    SparseField(const int side, const int density) : field(side, side) {
+        auto random = agh::Random(1).stream(0, 0);
+        for (int y = 0; y < side; ++y) {
+            for (int x = 0; x < side; ++x) {
+                if (random.below(100) < static_cast<uint32_t>(density)) {
+                    field.addAgent(agents.emplace_back(), {x, y});
+                }
+            }
+        }
+    }
+
+    std::deque<Agent> agents;
+    agh::Field<Agent> field;
+};
+
+void fieldIsEmpty(benchmark::State& state) {
+    const int side = static_cast<int>(state.range(0));
+    SparseField sparse(side, static_cast<int>(state.range(1)));
+    for (auto _ : state) {
+        size_t empty = 0;
+        for (int y = 0; y < side; ++y) {
+            for (int x = 0; x < side; ++x) {
+                empty += sparse.field.isEmpty({x, y});
+            }
+        }
+        benchmark::DoNotOptimize(empty);
+    }
+}
+
+void fieldGetEmpty(benchmark::State& state) {
+    SparseField sparse(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sparse.field.getEmpty());
+    }
+}
+
+void fieldApply(benchmark::State& state) {
+    SparseField sparse(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    for (auto _ : state) {
+        long sum = 0;
+        sparse.field.apply([&](const Agent& agent) { sum += agent.value; });
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+// Every iteration one agent moves to a random empty cell, as in Schelling's segregation model.
+void fieldRelocateRandom(benchmark::State& state) {
+    SparseField sparse(static_cast<int>(state.range(0)), 50);
+    auto random = agh::Random(2).stream(0, 0);
+    size_t next = 0;
+    for (auto _ : state) {
+        Agent& agent = sparse.agents[next++ % sparse.agents.size()];
+        if (state.range(1)) {
+            sparse.field.moveAgent(agent, *sparse.field.randomEmpty(random));
+        }
+        else {
+            const std::vector<agh::Point> empty = sparse.field.getEmpty();
+            sparse.field.moveAgent(agent, empty[random.below(static_cast<uint32_t>(empty.size()))]);
+        }
+    }
+}
+
+// Every agent sums values of its Moore neighbors, either collected into a vector or visited with a stencil.
+void fieldNeighbors(benchmark::State& state) {
+    SparseField sparse(static_cast<int>(state.range(0)), 30);
+    const agh::Stencil moore = agh::Stencil::moore();
+    for (auto _ : state) {
+        long sum = 0;
+        for (const Agent& agent : sparse.agents) {
+            if (state.range(1)) {
+                sparse.field.forEachNeighbor(*agent.pos, moore, [&](const Agent& neighbor) { sum += neighbor.value; });
+            }
+            else {
+                for (const auto neighbor : sparse.field.getNeighbors(*agent.pos)) {
+                    sum += std::get<Agent*>(neighbor)->value;
+                }
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+// Every cell of the layer sums values of its Moore neighbors, as in a diffusion step. Second argument selects bounded
+// (0) or toroidal (1) layer, and the third one selects getNeighbors (0) or forEachNeighbor (1).
+void layerNeighbors(benchmark::State& state) {
+    const int side = static_cast<int>(state.range(0));
+    agh::IntValueLayer layer(side, side, state.range(1), 1);
+    const agh::Stencil moore = agh::Stencil::moore();
+    for (auto _ : state) {
+        long sum = 0;
+        for (int y = 0; y < side; ++y) {
+            for (int x = 0; x < side; ++x) {
+                if (state.range(2)) {
+                    layer.forEachNeighbor({x, y}, moore, [&](agh::Point, const int value) { sum += value; });
+                }
+                else {
+                    for (const int value : layer.getNeighbors({x, y}, 1, true, false)) {
+                        sum += value;
+                    }
+                }
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+// Same as layerNeighbors with forEachNeighbor, but on a layer of the static extent and topology with a fixed stencil.
+template<typename Topology>
+void staticLayerNeighbors(benchmark::State& state) {
+    constexpr int side = 4096;
+    const agh::ValueLayer<int, agh::Extent<side, side>, Topology> layer(1);
+    constexpr auto moore = agh::Stencil::fixedMoore<1>();
+    for (auto _ : state) {
+        long sum = 0;
+        for (int y = 0; y < side; ++y) {
+            for (int x = 0; x < side; ++x) {
+                layer.forEachNeighbor({x, y}, moore, [&](agh::Point, const int value) { sum += value; });
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+// Diffusion step on the 4096x4096 layer with the given memory layout: every cell of the write layer becomes the sum of
+// the read layer within its radius 3 Moore neighborhood. Cells are visited by transform, i.e. in the layout order.
+template<typename Layout>
+void layoutLayerNeighbors(benchmark::State& state) {
+    constexpr int side = 4096;
+    agh::ValueLayer<int, agh::DynamicExtent, agh::Bounded, Layout> layer(side, side, false, 1);
+    const agh::Stencil moore = agh::Stencil::moore(3);
+    for (auto _ : state) {
+        layer.transform([&](const agh::Point p, int& value) {
+            value = 0;
+            layer.forEachNeighbor(p, moore, [&](agh::Point, const int neighbor) { value += neighbor; });
+        });
+        benchmark::DoNotOptimize(layer.getFromWrite({0, 0}));
+    }
+}
+
+// Every agent of the 2048x2048 field with the given memory layout, occupied in 30%, sums values of agents within its
+// radius 3 Moore neighborhood. Agents are visited either by apply, i.e. in the order of the layout (0), or in random
+// order, as with a shuffled schedule (1).
+template<typename Layout>
+void layoutFieldNeighbors(benchmark::State& state) {
+    constexpr int side = 2048;
+    std::vector<Agent> agents(side * side * 3 / 10);
+    agh::BasicField<agh::DynamicExtent, agh::Bounded, Layout, Agent> field(side, side);
+    auto random = agh::Random(1).stream(0, 0);
+    for (Agent& agent : agents) {
+        field.addAgent(agent, *field.randomEmpty(random));
+    }
+    std::vector<Agent*> order;
+    for (Agent& agent : agents) {
+        order.push_back(&agent);
+    }
+    std::ranges::shuffle(order, random);
+
+    const agh::Stencil moore = agh::Stencil::moore(3);
+    for (auto _ : state) {
+        long sum = 0;
+        auto visit = [&](const Agent& agent) {
+            field.forEachNeighbor(*agent.pos, moore, [&](const Agent& neighbor) { sum += neighbor.value; });
+        };
+        if (state.range(0)) {
+            for (const Agent* agent : order) {
+                visit(*agent);
+            }
+        }
+        else {
+            field.apply(visit);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+// Diffusion step of layoutLayerNeighbors on the row-major layer, executed by transform with std::execution::par on the
+// given number of threads (1 means the calling thread only).
+void parallelLayerNeighbors(benchmark::State& state) {
+    constexpr int side = 4096;
+    agh::IntValueLayer layer(side, side, false, 1);
+    agh::ThreadPool pool(state.range(0));
+    layer.setThreadPool(state.range(0) > 1 ? &pool : nullptr);
+    const agh::Stencil moore = agh::Stencil::moore(3);
+    for (auto _ : state) {
+        layer.transform(std::execution::par, [&](const agh::Point p, int& value) {
+            value = 0;
+            layer.forEachNeighbor(p, moore, [&](agh::Point, const int neighbor) { value += neighbor; });
+        });
+        benchmark::DoNotOptimize(layer.getFromWrite({0, 0}));
+    }
+}
+
+BENCHMARK(fieldIsEmpty)->Args({1000, 5})->Args({4000, 5})->Unit(benchmark::kMicrosecond);
+BENCHMARK(fieldGetEmpty)->Args({1000, 5})->Args({4000, 95})->Unit(benchmark::kMicrosecond);
+BENCHMARK(fieldApply)->Args({1000, 5})->Args({4000, 5})->Unit(benchmark::kMicrosecond);
+BENCHMARK(fieldRelocateRandom)->Args({1000, 0})->Args({1000, 1})->Unit(benchmark::kMicrosecond);
+BENCHMARK(fieldNeighbors)->Args({500, 0})->Args({500, 1})->Unit(benchmark::kMicrosecond);
+BENCHMARK(layerNeighbors)->ArgsProduct({{4096}, {0, 1}, {0, 1}})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(staticLayerNeighbors, agh::Bounded)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(staticLayerNeighbors, agh::Torus)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(layoutLayerNeighbors, agh::RowMajor)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(layoutLayerNeighbors, agh::Tiled<8>)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(layoutLayerNeighbors, agh::Morton)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(layoutFieldNeighbors, agh::RowMajor)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(layoutFieldNeighbors, agh::Tiled<8>)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(layoutFieldNeighbors, agh::Morton)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(parallelLayerNeighbors)->Arg(1)->Arg(2)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+}
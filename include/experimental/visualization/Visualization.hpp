@@ -12,8 +12,8 @@ class Visualization {
 public:
     Visualization(unsigned spaceWidth, unsigned spaceHeight, const std::string& title, unsigned itPerSec);
 
-    template<SimState M, Schedulable<M>... Agents>
-    void run(Schedule<M, Agents...> schedule) {
+    template<typename Backend, SimState M, Schedulable<M>... Agents>
+    void run(BasicSchedule<Backend, M, Agents...>& schedule) {
         while (window.isOpen()) {
             controlEvents();
 
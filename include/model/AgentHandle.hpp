@@ -0,0 +1,72 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <functional>
+
+namespace agh {
+/**
+ * Compact reference to an agent stored in a Model. It packs index of the agent's type in the model, index of its slot
+ * and generation of the slot into 64 bits. Generation changes whenever the agent in the slot is removed, so a handle to
+ * a removed agent is detected as stale instead of referring to the agent which took its slot. Default constructed
+ * handle doesn't refer to any agent.
+ */
+class AgentHandle {
+public:
+    static constexpr uint32_t generationMask = (1u << 24) - 1;
+
+    constexpr AgentHandle() = default;
+
+    constexpr AgentHandle(const size_t type, const size_t slot, const uint32_t generation)
+        : value(static_cast<uint64_t>(type) << 56 | static_cast<uint64_t>(generation & generationMask) << 32 |
+                static_cast<uint32_t>(slot)) {}
+
+    /**
+     * Returns index of the agent's type in the model.
+     * @return Type index.
+     */
+    [[nodiscard]] constexpr size_t type() const { return value >> 56; }
+
+    /**
+     * Returns index of the agent's slot in the pool of its type.
+     * @return Slot index.
+     */
+    [[nodiscard]] constexpr size_t slot() const { return static_cast<uint32_t>(value); }
+
+    /**
+     * Returns generation of the slot at the time the handle was issued.
+     * @return Generation, never zero for handles issued by a model.
+     */
+    [[nodiscard]] constexpr uint32_t generation() const { return value >> 32 & generationMask; }
+
+    /**
+     * Returns raw 64-bit representation of the handle.
+     * @return Packed type, generation and slot.
+     */
+    [[nodiscard]] constexpr uint64_t raw() const { return value; }
+
+    constexpr explicit operator bool() const { return value != 0; }
+
+    constexpr bool operator==(const AgentHandle&) const = default;
+
+private:
+    uint64_t value{};
+};
+
+/**
+ * Model which resolves handles to agents of type A, and issues handles of its agents.
+ */
+template<typename M, typename A>
+concept AgentResolver = requires(M m, AgentHandle h) {
+    static_cast<bool>(m.template get<A>(h));
+    m.template get<A>(h)->isActive();
+    { m.handleOf(*m.template get<A>(h)) } -> std::same_as<AgentHandle>;
+};
+}
+
+template<>
+struct std::hash<agh::AgentHandle> {
+    size_t operator()(const agh::AgentHandle& handle) const noexcept {
+        return std::hash<uint64_t>{}(handle.raw());
+    }
+};
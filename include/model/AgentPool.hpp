@@ -0,0 +1,216 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "Relocations.hpp"
+
+namespace agh {
+/**
+ * Container storing agents of one type in pages of slots. Pages are never moved, so the address of an agent is
+ * invariant until it is removed. Removed slots are put on a free list and reused by subsequently added agents, which
+ * also reuse their addresses. Every chunk of 64 slots has a bitmask of occupied slots, so iteration skips free slots a
+ * whole word at a time. Pages are aligned to their size, which lets the pool find the slot of an agent from its address
+ * in O(1). Adding agents may invalidate iterators, but never references to agents.
+ * @tparam T Type of the stored agents.
+ */
+template<typename T>
+class AgentPool {
+    static constexpr size_t chunkSize = 64;
+    static constexpr size_t pageSize = std::bit_ceil(sizeof(T) * chunkSize * 16);
+    static constexpr size_t pageChunks = (pageSize - 64 - alignof(T)) / (sizeof(T) * chunkSize + sizeof(uint64_t));
+    static constexpr size_t pageSlots = pageChunks * chunkSize;
+
+    struct alignas(pageSize) Page {
+        std::array<uint64_t, pageChunks> occupied{};
+        size_t index{};
+        alignas(T) std::byte storage[sizeof(T) * pageSlots];
+
+        T* slot(const size_t i) { return std::launder(reinterpret_cast<T*>(storage) + i); }
+    };
+
+    static_assert(sizeof(Page) == pageSize);
+
+public:
+    template<bool Const>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        Iterator() = default;
+
+        reference operator*() const { return *pages[page]->slot(chunk * chunkSize + std::countr_zero(bits)); }
+        pointer operator->() const { return &**this; }
+
+        Iterator& operator++();
+        Iterator operator++(int);
+
+        bool operator==(const Iterator& rhs) const {
+            return page == rhs.page && chunk == rhs.chunk && bits == rhs.bits;
+        }
+
+    private:
+        friend AgentPool;
+
+        Iterator(const std::unique_ptr<Page>* pPages, size_t pPage, size_t pCount);
+
+        const std::unique_ptr<Page>* pages{};
+        size_t page{};
+        size_t chunk{};
+        size_t count{};
+        uint64_t bits{};
+
+        void skipEmpty();
+    };
+
+    using reference = T&;
+    using pointer = T*;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    AgentPool() = default;
+    AgentPool(const AgentPool&) = delete;
+    AgentPool(AgentPool&&) noexcept = default;
+    AgentPool& operator=(const AgentPool&) = delete;
+    AgentPool& operator=(AgentPool&& other) noexcept;
+    ~AgentPool();
+
+    /**
+     * Creates agent in a free slot, or in a new one if there are no free slots.
+     * @tparam Args Types of the constructor's arguments for type T.
+     * @param args Arguments passed to the agent's constructor.
+     * @return Reference to the created agent.
+     */
+    template<typename... Args>
+    T& emplace(Args&&... args);
+
+    /**
+     * Destroys the agent and frees its slot in O(1).
+     * @param agent Reference to an agent stored in this pool.
+     */
+    void erase(const T& agent);
+
+    /**
+     * Destroys the agent in the given slot and frees the slot in O(1).
+     * @param slot Index of an occupied slot.
+     */
+    void eraseAt(size_t slot);
+
+    /**
+     * Destroys the agent in the given slot in O(1), but keeps the slot from being reused until releaseHeld is called,
+     * so that the address of the removed agent doesn't refer to another agent meanwhile.
+     * @param slot Index of an occupied slot.
+     */
+    void eraseHeld(size_t slot);
+
+    /**
+     * Frees the slots of the agents removed by eraseHeld.
+     */
+    void releaseHeld();
+
+    /**
+     * Returns index of the slot occupied by the agent in O(1).
+     * @param agent Reference to an agent stored in this pool.
+     * @return Index of the slot.
+     */
+    [[nodiscard]] size_t slotOf(const T& agent) const;
+
+    /**
+     * Checks if the slot is occupied by an agent.
+     * @param slot Index of the slot.
+     * @return True if there is an agent in the slot, false otherwise.
+     */
+    [[nodiscard]] bool occupied(size_t slot) const;
+
+    /**
+     * Returns generation of the slot. It starts at 1 and changes every time an agent is removed from the slot, so it
+     * tells apart agents which occupied the same slot at different times. It wraps around after 2^24 - 1 removals.
+     * @param slot Index of the slot, lower than slots().
+     * @return Generation of the slot, never zero.
+     */
+    [[nodiscard]] uint32_t generation(const size_t slot) const { return generations[slot]; }
+
+    /**
+     * Returns agent in the given slot. As long as no agent was removed, slots are numbered in the order of adding.
+     * @param slot Index of an occupied slot.
+     * @return Reference to the agent.
+     */
+    T& operator[](size_t slot) { return *pages[slot / pageSlots]->slot(slot % pageSlots); }
+    const T& operator[](size_t slot) const { return *pages[slot / pageSlots]->slot(slot % pageSlots); }
+
+    /**
+     * Returns number of agents stored in the pool.
+     * @return Number of occupied slots.
+     */
+    [[nodiscard]] size_t size() const { return live; }
+
+    /**
+     * Checks if there is any agent in the pool.
+     * @return True if pool is empty, false otherwise.
+     */
+    [[nodiscard]] bool empty() const { return live == 0; }
+
+    /**
+     * Returns number of slots, both occupied and free. Slot indices are lower than this value.
+     * @return Number of slots.
+     */
+    [[nodiscard]] size_t slots() const { return used; }
+
+    /**
+     * Returns occupancy bitmask of the given chunk of 64 slots, starting at slot 64 * chunk.
+     * @param chunk Index of the chunk.
+     * @return Mask whose i-th bit is set if slot 64 * chunk + i is occupied.
+     */
+    [[nodiscard]] uint64_t occupancy(size_t chunk) const {
+        return pages[chunk / pageChunks]->occupied[chunk % pageChunks];
+    }
+
+    /**
+     * Returns number of chunks of 64 slots.
+     * @return Number of chunks.
+     */
+    [[nodiscard]] size_t chunkCount() const { return pages.size() * pageChunks; }
+
+    /**
+     * Destroys all agents which shouldn't be kept and moves the remaining ones to the lowest slots, so that they are
+     * contiguous, then releases unused pages. Agents are moved by their move constructor, so references, iterators and
+     * handles to the moved agents are invalidated, which is described by the appended relocations.
+     * @tparam Keep Type of the predicate.
+     * @param keep Predicate invocable with a reference to an agent, returning false for agents to destroy.
+     * @param relocations Vector to which relocations of the moved and destroyed agents are appended.
+     */
+    template<typename Keep>
+    void compact(Keep&& keep, std::vector<Relocation<T>>& relocations);
+
+    /**
+     * Destroys all agents and releases the memory.
+     */
+    void clear();
+
+    iterator begin() { return {pages.data(), 0, pages.size()}; }
+    iterator end() { return {pages.data(), pages.size(), pages.size()}; }
+    const_iterator begin() const { return {pages.data(), 0, pages.size()}; }
+    const_iterator end() const { return {pages.data(), pages.size(), pages.size()}; }
+
+private:
+    std::vector<std::unique_ptr<Page>> pages;
+    std::vector<size_t> freeSlots;
+    std::vector<size_t> heldSlots;
+    std::vector<uint32_t> generations;
+    size_t used{};
+    size_t live{};
+};
+}
+
+#include "AgentPoolImpl.hpp"
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <new>
+#include <utility>
+
+namespace agh {
+template<typename T>
+template<bool Const>
+AgentPool<T>::Iterator<Const>::Iterator(const std::unique_ptr<Page>* pPages, const size_t pPage, const size_t pCount)
+    : pages(pPages), page(pPage), count(pCount) {
+    bits = page < count ? pages[page]->occupied[0] : 0;
+    skipEmpty();
+}
+
+template<typename T>
+template<bool Const>
+auto AgentPool<T>::Iterator<Const>::operator++() -> Iterator& {
+    bits &= bits - 1;
+    skipEmpty();
+    return *this;
+}
+
+template<typename T>
+template<bool Const>
+auto AgentPool<T>::Iterator<Const>::operator++(int) -> Iterator {
+    Iterator old = *this;
+    ++*this;
+    return old;
+}
+
+template<typename T>
+template<bool Const>
+void AgentPool<T>::Iterator<Const>::skipEmpty() {
+    while (bits == 0 && page < count) {
+        if (++chunk == pageChunks) {
+            chunk = 0;
+            ++page;
+        }
+        bits = page < count ? pages[page]->occupied[chunk] : 0;
+    }
+}
+
+template<typename T>
+AgentPool<T>& AgentPool<T>::operator=(AgentPool&& other) noexcept {
+    if (this != &other) {
+        clear();
+        pages = std::move(other.pages);
+        freeSlots = std::move(other.freeSlots);
+        heldSlots = std::move(other.heldSlots);
+        generations = std::move(other.generations);
+        used = std::exchange(other.used, 0);
+        live = std::exchange(other.live, 0);
+    }
+    return *this;
+}
+
+template<typename T>
+AgentPool<T>::~AgentPool() {
+    clear();
+}
+
+template<typename T>
+template<typename... Args>
+T& AgentPool<T>::emplace(Args&&... args) {
+    size_t slot;
+    if (freeSlots.empty()) {
+        slot = used;
+        if (slot / pageSlots == pages.size()) {
+            pages.push_back(std::make_unique_for_overwrite<Page>());
+            pages.back()->index = pages.size() - 1;
+        }
+        if (slot == generations.size()) {
+            generations.push_back(1);
+        }
+        used += 1;
+    }
+    else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    Page& page = *pages[slot / pageSlots];
+    const size_t index = slot % pageSlots;
+    T* agent;
+    try {
+        agent = ::new(page.storage + sizeof(T) * index) T(std::forward<Args>(args)...);
+    }
+    catch (...) {
+        freeSlots.push_back(slot);
+        throw;
+    }
+    page.occupied[index / chunkSize] |= uint64_t{1} << (index % chunkSize);
+    live += 1;
+    return *agent;
+}
+
+template<typename T>
+void AgentPool<T>::erase(const T& agent) {
+    eraseAt(slotOf(agent));
+}
+
+template<typename T>
+void AgentPool<T>::eraseAt(const size_t slot) {
+    Page& page = *pages[slot / pageSlots];
+    const size_t index = slot % pageSlots;
+    page.slot(index)->~T();
+    page.occupied[index / chunkSize] &= ~(uint64_t{1} << (index % chunkSize));
+    generations[slot] = generations[slot] % ((1u << 24) - 1) + 1;
+    freeSlots.push_back(slot);
+    live -= 1;
+}
+
+template<typename T>
+void AgentPool<T>::eraseHeld(const size_t slot) {
+    eraseAt(slot);
+    freeSlots.pop_back();
+    heldSlots.push_back(slot);
+}
+
+template<typename T>
+void AgentPool<T>::releaseHeld() {
+    freeSlots.insert(freeSlots.end(), heldSlots.begin(), heldSlots.end());
+    heldSlots.clear();
+}
+
+template<typename T>
+size_t AgentPool<T>::slotOf(const T& agent) const {
+    const auto address = reinterpret_cast<uintptr_t>(&agent);
+    const auto* page = reinterpret_cast<const Page*>(address & ~(uintptr_t{pageSize} - 1));
+    return page->index * pageSlots + (address - reinterpret_cast<uintptr_t>(page->storage)) / sizeof(T);
+}
+
+template<typename T>
+bool AgentPool<T>::occupied(const size_t slot) const {
+    return slot < used && (occupancy(slot / chunkSize) >> (slot % chunkSize) & 1);
+}
+
+template<typename T>
+template<typename Keep>
+void AgentPool<T>::compact(Keep&& keep, std::vector<Relocation<T>>& relocations) {
+    auto bump = [&](const size_t slot) { generations[slot] = generations[slot] % ((1u << 24) - 1) + 1; };
+
+    for (size_t slot = 0; slot < used; ++slot) {
+        if (occupied(slot) && !keep((*this)[slot])) {
+            relocations.push_back({&(*this)[slot], nullptr, slot, slot, generations[slot], 0, true});
+            eraseAt(slot);
+        }
+    }
+
+    // Live agents from the highest slots fill the free slots from the lowest ones.
+    size_t low = 0;
+    size_t high = used;
+    while (true) {
+        while (low < high && occupied(low)) {
+            ++low;
+        }
+        while (high > low && !occupied(high - 1)) {
+            --high;
+        }
+        if (low + 1 >= high) {
+            break;
+        }
+
+        const size_t from = high - 1;
+        Page& source = *pages[from / pageSlots];
+        Page& target = *pages[low / pageSlots];
+        T* agent = source.slot(from % pageSlots);
+        T* moved = ::new(target.storage + sizeof(T) * (low % pageSlots)) T(std::move(*agent));
+        agent->~T();
+        source.occupied[from % pageSlots / chunkSize] &= ~(uint64_t{1} << (from % chunkSize));
+        target.occupied[low % pageSlots / chunkSize] |= uint64_t{1} << (low % chunkSize);
+        relocations.push_back({agent, moved, from, low, generations[from], generations[low], false});
+        bump(from);
+    }
+
+    used = live;
+    freeSlots.clear();
+    heldSlots.clear();
+    pages.resize((used + pageSlots - 1) / pageSlots);
+}
+
+template<typename T>
+void AgentPool<T>::clear() {
+    for (auto& page : pages) {
+        for (size_t chunk = 0; chunk < pageChunks; ++chunk) {
+            for (uint64_t bits = page->occupied[chunk]; bits; bits &= bits - 1) {
+                page->slot(chunk * chunkSize + std::countr_zero(bits))->~T();
+            }
+        }
+    }
+    pages.clear();
+    freeSlots.clear();
+    heldSlots.clear();
+    generations.clear();
+    used = 0;
+    live = 0;
+}
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace agh {
+/**
+ * Key of the commands recorded by the current thread. Commands are applied in the order of their keys, and commands
+ * with equal keys in the order they were recorded by one thread. The key should identify a unit of work which is
+ * always executed by a single thread, e.g. a chunk of agents processed by a parallel loop, so that the order doesn't
+ * depend on the threads which executed the work.
+ */
+class CommandKey {
+public:
+    /**
+     * Sets key of the current thread for the lifetime of the scope, and restores the previous one afterward.
+     */
+    class Scope {
+    public:
+        explicit Scope(const uint64_t key) : previousKey(current), previousSequence(sequence) {
+            current = key;
+            sequence = 0;
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope() {
+            current = previousKey;
+            sequence = previousSequence;
+        }
+
+    private:
+        uint64_t previousKey;
+        uint64_t previousSequence;
+    };
+
+    /**
+     * Returns key of the current thread.
+     * @return Current key.
+     */
+    [[nodiscard]] static uint64_t get() { return current; }
+
+private:
+    template<typename Target>
+    friend class CommandBuffer;
+
+    static inline thread_local uint64_t current{0};
+    static inline thread_local uint64_t sequence{0};
+};
+
+/**
+ * Buffer of commands deferred until flush. Every thread records commands into its own buffer, which it registers on
+ * its first command, so recording doesn't take locks and commands can be recorded concurrently, e.g. by agents stepped
+ * in parallel. Only the first command of a thread after it recorded into another CommandBuffer looks up its buffer
+ * under a lock. Commands are stored in per-thread memory blocks, which are reused after the flush. Flush applies the
+ * commands on a single thread, ordered by their CommandKey, so that the result is deterministic.
+ * @tparam Target Type of the object passed to the commands.
+ */
+template<typename Target>
+class CommandBuffer {
+public:
+    CommandBuffer() = default;
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer& operator=(const CommandBuffer&) = delete;
+    ~CommandBuffer();
+
+    /**
+     * Records command in the buffer of the current thread.
+     * @tparam F Type of the command. It must be invocable with Target&.
+     * @param command Command to record.
+     */
+    template<typename F>
+    void push(F&& command);
+
+    /**
+     * Applies all recorded commands in the order of their keys and clears the buffers. Commands recorded while
+     * flushing are applied by the same call, after the commands recorded before it. It must not be called
+     * concurrently with push.
+     * @param target Object passed to the commands.
+     */
+    void flush(Target& target);
+
+    /**
+     * Returns number of recorded commands. It must not be called concurrently with push.
+     * @return Number of commands waiting for flush.
+     */
+    [[nodiscard]] size_t size() const;
+
+    /**
+     * Returns serial number for keys of the commands. Serials increase with every call, so units of work which get
+     * their keys later have their commands applied later. It is thread-safe, but serials are deterministic only if
+     * they are taken by one thread.
+     * @return Serial number.
+     */
+    uint64_t nextSerial() { return serial.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+private:
+    static constexpr size_t blockSize = 4096;
+
+    struct Command {
+        uint64_t key;
+        uint64_t sequence;
+        void* object;
+        void (*invoke)(void*, Target&);
+        void (*destroy)(void*);
+    };
+
+    struct alignas(64) Buffer {
+        std::thread::id thread;
+        std::vector<Command> commands;
+        std::vector<std::unique_ptr<std::byte[]>> blocks;
+        std::vector<std::unique_ptr<std::byte[]>> large;
+        size_t block{};
+        size_t offset{};
+
+        void* allocate(size_t size, size_t alignment);
+        void reset();
+    };
+
+    struct Cache {
+        uint64_t owner;
+        Buffer* buffer;
+    };
+
+    static inline std::atomic<uint64_t> nextId{1};
+    static inline thread_local Cache cache{0, nullptr};
+
+    const uint64_t id{nextId.fetch_add(1, std::memory_order_relaxed)};
+    std::atomic<uint64_t> serial{0};
+    std::mutex registration;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    std::vector<Command> pending;
+
+    Buffer& local();
+};
+}
+
+#include "CommandBufferImpl.hpp"
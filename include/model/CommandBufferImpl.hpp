@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace agh {
+template<typename Target>
+CommandBuffer<Target>::~CommandBuffer() {
+    for (auto& buffer : buffers) {
+        for (const Command& command : buffer->commands) {
+            command.destroy(command.object);
+        }
+    }
+}
+
+template<typename Target>
+template<typename F>
+void CommandBuffer<Target>::push(F&& command) {
+    using Stored = std::decay_t<F>;
+    static_assert(alignof(Stored) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Command is over-aligned.");
+
+    Buffer& buffer = local();
+    void* object = ::new(buffer.allocate(sizeof(Stored), alignof(Stored))) Stored(std::forward<F>(command));
+    buffer.commands.push_back(Command{
+        CommandKey::current,
+        CommandKey::sequence++,
+        object,
+        [](void* pObject, Target& target) { (*static_cast<Stored*>(pObject))(target); },
+        [](void* pObject) { static_cast<Stored*>(pObject)->~Stored(); }
+    });
+}
+
+template<typename Target>
+void CommandBuffer<Target>::flush(Target& target) {
+    while (true) {
+        pending.clear();
+        for (auto& buffer : buffers) {
+            pending.insert(pending.end(), buffer->commands.begin(), buffer->commands.end());
+            buffer->commands.clear();
+        }
+        if (pending.empty()) {
+            break;
+        }
+
+        std::stable_sort(pending.begin(), pending.end(), [](const Command& lhs, const Command& rhs) {
+            return lhs.key != rhs.key ? lhs.key < rhs.key : lhs.sequence < rhs.sequence;
+        });
+        for (size_t i = 0; i < pending.size(); ++i) {
+            try {
+                pending[i].invoke(pending[i].object, target);
+            }
+            catch (...) {
+                for (size_t j = i; j < pending.size(); ++j) {
+                    pending[j].destroy(pending[j].object);
+                }
+                throw;
+            }
+            pending[i].destroy(pending[i].object);
+        }
+    }
+
+    for (auto& buffer : buffers) {
+        buffer->reset();
+    }
+}
+
+template<typename Target>
+size_t CommandBuffer<Target>::size() const {
+    size_t count = 0;
+    for (const auto& buffer : buffers) {
+        count += buffer->commands.size();
+    }
+    return count;
+}
+
+template<typename Target>
+auto CommandBuffer<Target>::local() -> Buffer& {
+    if (cache.owner == id) {
+        return *cache.buffer;
+    }
+
+    std::lock_guard lock(registration);
+    const auto thread = std::this_thread::get_id();
+    auto found = std::ranges::find_if(buffers, [&](const auto& buffer) { return buffer->thread == thread; });
+    if (found == buffers.end()) {
+        buffers.push_back(std::make_unique<Buffer>());
+        buffers.back()->thread = thread;
+        found = buffers.end() - 1;
+    }
+    cache = Cache{id, found->get()};
+    return *cache.buffer;
+}
+
+template<typename Target>
+void* CommandBuffer<Target>::Buffer::allocate(const size_t size, const size_t alignment) {
+    if (size > blockSize / 4) {
+        large.push_back(std::make_unique_for_overwrite<std::byte[]>(size));
+        return large.back().get();
+    }
+
+    offset = (offset + alignment - 1) / alignment * alignment;
+    if (blocks.empty() || offset + size > blockSize) {
+        if (!blocks.empty()) {
+            block += 1;
+        }
+        if (block == blocks.size()) {
+            blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(blockSize));
+        }
+        offset = 0;
+    }
+    void* object = blocks[block].get() + offset;
+    offset += size;
+    return object;
+}
+
+template<typename Target>
+void CommandBuffer<Target>::Buffer::reset() {
+    large.clear();
+    block = 0;
+    offset = 0;
+}
+}
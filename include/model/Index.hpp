@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <set>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace agh {
+/**
+ * Base of the secondary indexes over the agents of one type, declared with Model::addIndex. The model keeps them
+ * up to date when agents are added, removed or compacted, and when they are modified through Model::update or
+ * reported with Model::reindex. Indexes refer to slots of the pool, which is why the model can't be moved.
+ * @tparam Pool Type of the pool storing the indexed agents, i.e. AgentPool<T> or SoaPool<T>.
+ */
+template<typename Pool>
+class AgentIndex {
+public:
+    virtual ~AgentIndex() = default;
+
+    /**
+     * Adds agent in the given slot to the index.
+     * @param slot Occupied slot of the pool.
+     */
+    virtual void insert(size_t slot) = 0;
+
+    /**
+     * Removes agent in the given slot from the index. It must be called before the agent is removed from the pool.
+     * @param slot Occupied slot of the pool.
+     */
+    virtual void erase(size_t slot) = 0;
+
+    /**
+     * Updates entry of the agent in the given slot after its attributes changed.
+     * @param slot Occupied slot of the pool.
+     */
+    virtual void update(size_t slot) = 0;
+
+    /**
+     * Rebuilds the index from all agents in the pool, e.g. after they were moved or modified in bulk.
+     */
+    void rebuild();
+
+protected:
+    explicit AgentIndex(Pool& pPool) : pool(&pPool) {}
+
+    virtual void clear() = 0;
+
+    Pool* pool;
+};
+
+/**
+ * Index of the agents satisfying a boolean predicate, stored as a bitset over the slots of the pool. Iteration skips
+ * 64 slots not satisfying the predicate at a time, and counting takes O(1) time.
+ * @tparam Pool Type of the pool storing the indexed agents.
+ * @tparam P Type of the predicate. It must be invocable with Pool::reference and return a value convertible to bool.
+ */
+template<typename Pool, typename P>
+class FlagIndex final : public AgentIndex<Pool> {
+public:
+    /**
+     * Creates index of the agents in the pool satisfying the predicate.
+     * @param pPool Pool storing the indexed agents.
+     * @param pPredicate Predicate selecting the agents.
+     */
+    FlagIndex(Pool& pPool, P pPredicate);
+
+    void insert(size_t slot) override;
+    void erase(size_t slot) override;
+    void update(size_t slot) override;
+
+    /**
+     * Calls f for every agent satisfying the predicate, in the order of slots.
+     * @tparam F Type of the callable. It must be invocable with Pool::reference.
+     * @param f Callable invoked with every selected agent.
+     */
+    template<typename F>
+    void forEach(F&& f);
+
+    /**
+     * Checks if the agent in the given slot satisfies the predicate.
+     * @param slot Slot of the pool.
+     * @return True if the agent is selected by the index, false otherwise.
+     */
+    [[nodiscard]] bool contains(size_t slot) const;
+
+    /**
+     * Returns number of agents satisfying the predicate.
+     * @return Number of selected agents.
+     */
+    [[nodiscard]] size_t count() const { return selected; }
+
+private:
+    P predicate;
+    std::vector<uint64_t> bits;
+    size_t selected{};
+
+    void clear() override;
+};
+
+/**
+ * Index ordering the agents by a numeric, or otherwise totally ordered, attribute. Queries for a range of keys, or for
+ * the agents with the lowest or the highest keys, take O(log n + result) time.
+ * @tparam Pool Type of the pool storing the indexed agents.
+ * @tparam K Type of the key extractor. It must be invocable with Pool::reference and return an ordered value.
+ */
+template<typename Pool, typename K>
+class SortedIndex final : public AgentIndex<Pool> {
+public:
+    /**
+     * Type of the key the agents are ordered by.
+     */
+    using Key = std::remove_cvref_t<std::invoke_result_t<K&, typename Pool::reference>>;
+
+    /**
+     * Creates index of the agents in the pool ordered by the extracted key.
+     * @param pPool Pool storing the indexed agents.
+     * @param pKey Key extractor.
+     */
+    SortedIndex(Pool& pPool, K pKey);
+
+    void insert(size_t slot) override;
+    void erase(size_t slot) override;
+    void update(size_t slot) override;
+
+    /**
+     * Calls f for every agent with key in the range [low, high), in ascending order of keys.
+     * @tparam F Type of the callable. It must be invocable with Pool::reference.
+     * @param low Lowest key included in the range.
+     * @param high Lowest key above the range.
+     * @param f Callable invoked with every agent in the range.
+     */
+    template<typename F>
+    void forEachInRange(const Key& low, const Key& high, F&& f);
+
+    /**
+     * Calls f for n agents with the lowest keys, in ascending order of keys.
+     * @tparam F Type of the callable. It must be invocable with Pool::reference.
+     * @param n Number of agents. If it exceeds size of the index, all agents are visited.
+     * @param f Callable invoked with every visited agent.
+     */
+    template<typename F>
+    void forEachLowest(size_t n, F&& f);
+
+    /**
+     * Calls f for n agents with the highest keys, in descending order of keys.
+     * @tparam F Type of the callable. It must be invocable with Pool::reference.
+     * @param n Number of agents. If it exceeds size of the index, all agents are visited.
+     * @param f Callable invoked with every visited agent.
+     */
+    template<typename F>
+    void forEachHighest(size_t n, F&& f);
+
+    /**
+     * Returns number of indexed agents.
+     * @return Number of agents.
+     */
+    [[nodiscard]] size_t size() const { return entries.size(); }
+
+private:
+    K key;
+    std::set<std::pair<Key, size_t>> entries;
+    std::vector<std::optional<Key>> keys;
+
+    void clear() override;
+};
+
+/**
+ * Index grouping the agents by a categorical attribute. Agents of one category are visited in O(result) time, and
+ * counted in O(1) time.
+ * @tparam Pool Type of the pool storing the indexed agents.
+ * @tparam K Type of the category extractor. It must be invocable with Pool::reference and return a hashable value.
+ */
+template<typename Pool, typename K>
+class CategoryIndex final : public AgentIndex<Pool> {
+public:
+    /**
+     * Type of the category the agents are grouped by.
+     */
+    using Key = std::remove_cvref_t<std::invoke_result_t<K&, typename Pool::reference>>;
+
+    /**
+     * Creates index of the agents in the pool grouped by the extracted category.
+     * @param pPool Pool storing the indexed agents.
+     * @param pKey Category extractor.
+     */
+    CategoryIndex(Pool& pPool, K pKey);
+
+    void insert(size_t slot) override;
+    void erase(size_t slot) override;
+    void update(size_t slot) override;
+
+    /**
+     * Calls f for every agent of the given category, in unspecified order.
+     * @tparam F Type of the callable. It must be invocable with Pool::reference.
+     * @param category Category of the visited agents.
+     * @param f Callable invoked with every agent of the category.
+     */
+    template<typename F>
+    void forEach(const Key& category, F&& f);
+
+    /**
+     * Returns number of agents of the given category.
+     * @param category Category of the counted agents.
+     * @return Number of agents.
+     */
+    [[nodiscard]] size_t count(const Key& category) const;
+
+private:
+    struct Entry {
+        Key category;
+        size_t position;
+    };
+
+    K key;
+    std::unordered_map<Key, std::vector<size_t>> groups;
+    std::vector<std::optional<Entry>> entries;
+
+    void clear() override;
+};
+}
+
+#include "IndexImpl.hpp"
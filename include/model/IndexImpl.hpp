@@ -0,0 +1,191 @@
+#pragma once
+
+#include <bit>
+
+namespace agh {
+template<typename Pool>
+void AgentIndex<Pool>::rebuild() {
+    clear();
+    for (size_t slot = 0; slot < pool->slots(); ++slot) {
+        if (pool->occupied(slot)) {
+            insert(slot);
+        }
+    }
+}
+
+template<typename Pool, typename P>
+FlagIndex<Pool, P>::FlagIndex(Pool& pPool, P pPredicate) : AgentIndex<Pool>(pPool), predicate(std::move(pPredicate)) {
+    this->rebuild();
+}
+
+template<typename Pool, typename P>
+void FlagIndex<Pool, P>::insert(const size_t slot) {
+    if (slot / 64 >= bits.size()) {
+        bits.resize(slot / 64 + 1);
+    }
+    if (std::invoke(predicate, (*this->pool)[slot])) {
+        bits[slot / 64] |= uint64_t{1} << (slot % 64);
+        selected += 1;
+    }
+}
+
+template<typename Pool, typename P>
+void FlagIndex<Pool, P>::erase(const size_t slot) {
+    if (contains(slot)) {
+        bits[slot / 64] &= ~(uint64_t{1} << (slot % 64));
+        selected -= 1;
+    }
+}
+
+template<typename Pool, typename P>
+void FlagIndex<Pool, P>::update(const size_t slot) {
+    erase(slot);
+    insert(slot);
+}
+
+template<typename Pool, typename P>
+template<typename F>
+void FlagIndex<Pool, P>::forEach(F&& f) {
+    for (size_t word = 0; word < bits.size(); ++word) {
+        for (uint64_t set = bits[word]; set; set &= set - 1) {
+            f((*this->pool)[word * 64 + std::countr_zero(set)]);
+        }
+    }
+}
+
+template<typename Pool, typename P>
+bool FlagIndex<Pool, P>::contains(const size_t slot) const {
+    return slot / 64 < bits.size() && (bits[slot / 64] >> (slot % 64) & 1);
+}
+
+template<typename Pool, typename P>
+void FlagIndex<Pool, P>::clear() {
+    bits.clear();
+    selected = 0;
+}
+
+template<typename Pool, typename K>
+SortedIndex<Pool, K>::SortedIndex(Pool& pPool, K pKey) : AgentIndex<Pool>(pPool), key(std::move(pKey)) {
+    this->rebuild();
+}
+
+template<typename Pool, typename K>
+void SortedIndex<Pool, K>::insert(const size_t slot) {
+    if (slot >= keys.size()) {
+        keys.resize(slot + 1);
+    }
+    keys[slot] = std::invoke(key, (*this->pool)[slot]);
+    entries.emplace(*keys[slot], slot);
+}
+
+template<typename Pool, typename K>
+void SortedIndex<Pool, K>::erase(const size_t slot) {
+    if (slot < keys.size() && keys[slot]) {
+        entries.erase({*keys[slot], slot});
+        keys[slot].reset();
+    }
+}
+
+template<typename Pool, typename K>
+void SortedIndex<Pool, K>::update(const size_t slot) {
+    if (slot < keys.size() && keys[slot] && *keys[slot] == std::invoke(key, (*this->pool)[slot])) {
+        return;
+    }
+    erase(slot);
+    insert(slot);
+}
+
+template<typename Pool, typename K>
+template<typename F>
+void SortedIndex<Pool, K>::forEachInRange(const Key& low, const Key& high, F&& f) {
+    for (auto it = entries.lower_bound({low, 0}); it != entries.end() && it->first < high; ++it) {
+        f((*this->pool)[it->second]);
+    }
+}
+
+template<typename Pool, typename K>
+template<typename F>
+void SortedIndex<Pool, K>::forEachLowest(size_t n, F&& f) {
+    for (auto it = entries.begin(); n > 0 && it != entries.end(); ++it, --n) {
+        f((*this->pool)[it->second]);
+    }
+}
+
+template<typename Pool, typename K>
+template<typename F>
+void SortedIndex<Pool, K>::forEachHighest(size_t n, F&& f) {
+    for (auto it = entries.rbegin(); n > 0 && it != entries.rend(); ++it, --n) {
+        f((*this->pool)[it->second]);
+    }
+}
+
+template<typename Pool, typename K>
+void SortedIndex<Pool, K>::clear() {
+    entries.clear();
+    keys.clear();
+}
+
+template<typename Pool, typename K>
+CategoryIndex<Pool, K>::CategoryIndex(Pool& pPool, K pKey) : AgentIndex<Pool>(pPool), key(std::move(pKey)) {
+    this->rebuild();
+}
+
+template<typename Pool, typename K>
+void CategoryIndex<Pool, K>::insert(const size_t slot) {
+    if (slot >= entries.size()) {
+        entries.resize(slot + 1);
+    }
+    Key category = std::invoke(key, (*this->pool)[slot]);
+    auto& group = groups[category];
+    entries[slot] = Entry{std::move(category), group.size()};
+    group.push_back(slot);
+}
+
+template<typename Pool, typename K>
+void CategoryIndex<Pool, K>::erase(const size_t slot) {
+    if (slot >= entries.size() || !entries[slot]) {
+        return;
+    }
+    const auto group = groups.find(entries[slot]->category);
+    std::vector<size_t>& slots = group->second;
+    const size_t last = slots.back();
+    slots[entries[slot]->position] = last;
+    entries[last]->position = entries[slot]->position;
+    slots.pop_back();
+    if (slots.empty()) {
+        groups.erase(group);
+    }
+    entries[slot].reset();
+}
+
+template<typename Pool, typename K>
+void CategoryIndex<Pool, K>::update(const size_t slot) {
+    if (slot < entries.size() && entries[slot] && entries[slot]->category == std::invoke(key, (*this->pool)[slot])) {
+        return;
+    }
+    erase(slot);
+    insert(slot);
+}
+
+template<typename Pool, typename K>
+template<typename F>
+void CategoryIndex<Pool, K>::forEach(const Key& category, F&& f) {
+    if (const auto group = groups.find(category); group != groups.end()) {
+        for (const size_t slot : group->second) {
+            f((*this->pool)[slot]);
+        }
+    }
+}
+
+template<typename Pool, typename K>
+size_t CategoryIndex<Pool, K>::count(const Key& category) const {
+    const auto group = groups.find(category);
+    return group == groups.end() ? 0 : group->second.size();
+}
+
+template<typename Pool, typename K>
+void CategoryIndex<Pool, K>::clear() {
+    groups.clear();
+    entries.clear();
+}
+}
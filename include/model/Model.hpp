@@ -1,26 +1,90 @@
 #pragma once
 
-#include <deque>
+#include <cstddef>
+#include <memory>
+#include <optional>
 #include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "AgentHandle.hpp"
+#include "AgentPool.hpp"
+#include "CommandBuffer.hpp"
+#include "Index.hpp"
+#include "Relocations.hpp"
+#include "SoaPool.hpp"
 #include "../utilities/Concepts.hpp"
+#include "../utilities/Execution.hpp"
+#include "../utilities/ThreadPool.hpp"
 
 namespace agh {
+template<typename T>
+struct StorageOf {
+    using type = AgentPool<T>;
+};
+
+template<SoaAgent T>
+struct StorageOf<T> {
+    using type = SoaPool<T>;
+};
+
 /**
  * Class template capable of storing agents present in the simulation. It assures that the address of the agent is
- * invariant.
+ * invariant until the agent is removed. Agents of every type are kept in an AgentPool, which reuses slots of removed
+ * agents. Agents may also be referred to by generational AgentHandle, which is detected as stale after the agent is
+ * removed. Agent types meeting SoaAgent requirements, i.e. listing their members in T::members, are instead stored as
+ * structure of arrays in a SoaPool, and they are referred to by SoaReference proxies instead of plain references.
+ * Bulk operations, like forEach, process agents in chunks of consecutive slots, which are distributed among threads
+ * of the model's pool when a parallel execution policy is given. Agents may be created and removed concurrently, e.g.
+ * during a parallel step, with deferred commands, which are applied when the commands are flushed. Secondary indexes
+ * declared with addIndex are maintained incrementally, so that queries for agents with given attributes don't scan
+ * the whole pool.
  * @tparam Agents Types of agents that can be present in the model. They must meet ActiveAgent requirements.
  */
 template<ActiveAgent... Agents> requires (sizeof...(Agents) > 0)
 class Model {
 public:
+    /**
+     * Type of the container storing agents of type T.
+     */
+    template<typename T>
+    using Storage = typename StorageOf<T>::type;
+
+    /**
+     * Type referring to an agent of type T, i.e. T& or SoaReference<T>.
+     */
+    template<typename T>
+    using Reference = typename Storage<T>::reference;
+
+    /**
+     * Type of the table describing agents moved or removed by compact.
+     */
+    using RelocationTable = Relocations<Agents...>;
+
+    /**
+     * Type returned when resolving handles of agents of type T, i.e. T* or SoaReference<T>, which is empty if the
+     * handle is stale.
+     */
+    template<typename T>
+    using Pointer = typename Storage<T>::pointer;
+
+    Model() = default;
+
+    /**
+     * Models are neither copyable nor movable, because secondary indexes and attached listeners refer to the model's
+     * pools, and schedules and spaces refer to the model itself.
+     */
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
     /**
      * Function returning all agents of type T stored by the model.
      * @tparam T Type of the agents we want to get.
-     * @return std::deque<T> containing all agents of type T in the model.
+     * @return AgentPool<T> or SoaPool<T> containing all agents of type T in the model.
      */
     template<ActiveAgent T>
-    std::deque<T>& getAgents();
+    Storage<T>& getAgents();
 
     /**
      * Function for adding new agents to the simulation. It differs from emplaceAgent, by adding an agent based on
@@ -30,7 +94,7 @@ public:
      * @return Reference to the added agent.
      */
     template<ActiveAgent T>
-    T& addAgent(const T& agent);
+    Reference<T> addAgent(const T& agent);
 
     /**
      * Function for creating agent directly in the simulation state. It differs from addAgent, by creating from given
@@ -41,7 +105,78 @@ public:
      * @return Reference to the created agent.
      */
     template<ActiveAgent T, typename... Args>
-    T& emplaceAgent(Args&&... args);
+    Reference<T> emplaceAgent(Args&&... args);
+
+    /**
+     * Function for removing agent from the simulation in O(1) time. The agent is destroyed, and its slot and address
+     * may be reused by agents added later. It must not be referenced by pointer from a schedule or a space anymore,
+     * e.g. its actions should be cancelled first. Handles of the agent become stale.
+     * @tparam T Type of the agent we want to remove. It must meet ActiveAgent requirements.
+     * @param agent Reference to an agent stored in the model.
+     */
+    template<ActiveAgent T>
+    void removeAgent(const T& agent);
+
+    /**
+     * Function for removing agent stored as structure of arrays in O(1) time. Handles of the agent become stale.
+     * @tparam T Type of the agent we want to remove. It must meet SoaAgent requirements.
+     * @param agent Proxy reference to an agent stored in the model.
+     */
+    template<SoaAgent T>
+    void removeAgent(SoaReference<T> agent);
+
+    /**
+     * Function issuing handle of the agent stored in the model. Agents stored as structure of arrays are referred to
+     * by their SoaReference instead, since step of the proxy runs on a copy of the agent, which is not in the model.
+     * @tparam T Type of the agent. It must meet ActiveAgent requirements.
+     * @param agent Reference to an agent stored in the model.
+     * @return Handle encoding type, slot and generation of the agent.
+     */
+    template<ActiveAgent T>
+    AgentHandle handleOf(const T& agent) const;
+
+    /**
+     * Function issuing handle of the agent stored as structure of arrays.
+     * @tparam T Type of the agent. It must meet SoaAgent requirements.
+     * @param agent Proxy reference to an agent stored in the model.
+     * @return Handle encoding type, slot and generation of the agent.
+     */
+    template<SoaAgent T>
+    AgentHandle handleOf(SoaReference<T> agent) const;
+
+    /**
+     * Function resolving handle to the agent of type T.
+     * @tparam T Type of the agent. It must meet ActiveAgent requirements.
+     * @param handle Handle issued by this model.
+     * @return Pointer to the agent, or an empty pointer if the agent was removed or is not of type T.
+     */
+    template<ActiveAgent T>
+    Pointer<T> get(AgentHandle handle);
+
+    /**
+     * Function checking if the handle refers to an agent present in the model.
+     * @param handle Handle issued by this model.
+     * @return True if the agent wasn't removed, false otherwise.
+     */
+    [[nodiscard]] bool isAlive(AgentHandle handle) const;
+
+    /**
+     * Function calling f with reference to the agent referred by the handle.
+     * @tparam F Type of the callable. It must be invocable with Reference of every agent type.
+     * @param handle Handle issued by this model.
+     * @param f Callable invoked with the agent.
+     * @return True if f was called, false if the handle is stale.
+     */
+    template<typename F>
+    bool visit(AgentHandle handle, F&& f);
+
+    /**
+     * Function returning index of type T among agent types of the model, which is encoded in its handles.
+     * @tparam T Type of the agent.
+     * @return Index of T in Agents.
+     */
+    template<ActiveAgent T>
+    static constexpr size_t typeIndex();
 
     /**
      * Function returning quantities of agents, regardless of type.
@@ -57,8 +192,271 @@ public:
     template<ActiveAgent T>
     size_t agentCount();
 
+    /**
+     * Sets number of threads used by bulk operations with parallel execution policies. Value 1 (default) means that
+     * they are executed by the calling thread.
+     * @param threads Number of threads, including the calling one.
+     */
+    void setThreads(size_t threads);
+
+    /**
+     * Returns the pool created by setThreads, which can be shared with the spaces by their setThreadPool, so that the
+     * model doesn't start several sets of threads. Calling setThreads again replaces the pool.
+     * @return Pointer to the pool, or nullptr if bulk operations are executed by the calling thread.
+     */
+    [[nodiscard]] ThreadPool* threadPool() const { return pool.get(); }
+
+    /**
+     * Calls f for every agent in the model, one agent type after another. With std::execution::par or par_unseq,
+     * agents of one type are processed concurrently, so f must not modify shared state without synchronization.
+     * @tparam P Type of the execution policy.
+     * @tparam F Type of the callable. It must be invocable with Reference of every agent type.
+     * @param policy Execution policy, e.g. std::execution::seq or std::execution::par.
+     * @param f Callable invoked with every agent.
+     */
+    template<ExecutionPolicy P, typename F>
+    void forEach(P&& policy, F&& f);
+
+    /**
+     * Calls f for every agent of type T in the model.
+     * @tparam T Type of the agents.
+     * @tparam P Type of the execution policy.
+     * @tparam F Type of the callable. It must be invocable with Reference<T>.
+     * @param policy Execution policy, e.g. std::execution::seq or std::execution::par.
+     * @param f Callable invoked with every agent of type T.
+     */
+    template<ActiveAgent T, ExecutionPolicy P, typename F>
+    void forEach(P&& policy, F&& f);
+
+    /**
+     * Transforms every agent in the model and reduces the results with init. Partial results are reduced in the order
+     * of agent types and slots, in groups which don't depend on the number of threads, so the result is reproducible
+     * even if reduce is not associative, e.g. for floating point sums.
+     * @tparam P Type of the execution policy.
+     * @tparam R Type of the result.
+     * @tparam Reduce Type of the binary function combining results.
+     * @tparam Transform Type of the callable. It must be invocable with Reference of every agent type.
+     * @param policy Execution policy, e.g. std::execution::seq or std::execution::par.
+     * @param init Initial value of the result.
+     * @param reduce Binary function combining two results.
+     * @param transform Callable mapping an agent to a result.
+     * @return Reduced result.
+     */
+    template<ExecutionPolicy P, typename R, typename Reduce, typename Transform>
+    R transformReduce(P&& policy, R init, Reduce reduce, Transform transform);
+
+    /**
+     * Transforms every agent of type T in the model and reduces the results with init.
+     * @tparam T Type of the agents.
+     * @param policy Execution policy, e.g. std::execution::seq or std::execution::par.
+     * @param init Initial value of the result.
+     * @param reduce Binary function combining two results.
+     * @param transform Callable mapping an agent of type T to a result.
+     * @return Reduced result.
+     */
+    template<ActiveAgent T, ExecutionPolicy P, typename R, typename Reduce, typename Transform>
+    R transformReduce(P&& policy, R init, Reduce reduce, Transform transform);
+
+    /**
+     * Counts agents in the model which satisfy the predicate.
+     * @param policy Execution policy, e.g. std::execution::seq or std::execution::par.
+     * @param predicate Callable invocable with Reference of every agent type, returning bool.
+     * @return Number of agents for which predicate returned true.
+     */
+    template<ExecutionPolicy P, typename Predicate>
+    size_t countIf(P&& policy, Predicate predicate);
+
+    /**
+     * Counts agents of type T in the model which satisfy the predicate.
+     * @param policy Execution policy, e.g. std::execution::seq or std::execution::par.
+     * @param predicate Callable invocable with Reference<T>, returning bool.
+     * @return Number of agents of type T for which predicate returned true.
+     */
+    template<ActiveAgent T, ExecutionPolicy P, typename Predicate>
+    size_t countIf(P&& policy, Predicate predicate);
+
+    /**
+     * Records creation of an agent, deferred until the commands are flushed. It is safe to call concurrently.
+     * @tparam T Type of the agent we want to create. It must meet ActiveAgent requirements.
+     * @tparam Args Types of the constructor's arguments for type T.
+     * @param args Arguments passed to the agent's constructor. They are copied or moved into the command.
+     */
+    template<ActiveAgent T, typename... Args>
+    void spawn(Args&&... args);
+
+    /**
+     * Records creation of an agent, deferred until the commands are flushed, after which init is called with the
+     * created agent, e.g. to add it to a space or to schedule it. It is safe to call concurrently.
+     * @tparam T Type of the agent we want to create. It must meet ActiveAgent requirements.
+     * @tparam F Type of the callable. It must be invocable with Reference<T>.
+     * @tparam Args Types of the constructor's arguments for type T.
+     * @param init Callable invoked with the created agent when it is applied.
+     * @param args Arguments passed to the agent's constructor. They are copied or moved into the command.
+     */
+    template<ActiveAgent T, typename F, typename... Args>
+    void spawnWith(F&& init, Args&&... args);
+
+    /**
+     * Records removal of the agent, deferred until the commands are flushed. The agent is referred to by its handle,
+     * so killing it more than once removes it only once. It is safe to call concurrently. At the end of the flush, the
+     * attached schedules and spaces receive the removals through relocate, so they drop their references to the killed
+     * agents, and only then their slots can be reused. Schedules and spaces which are not attached keep dangling
+     * references to them. Agents stored as structure of arrays are killed by their SoaReference, e.g. in stepBatch.
+     * @param agent Reference to an agent stored in the model.
+     */
+    void kill(const auto& agent);
+
+    /**
+     * Records arbitrary command, e.g. adding an agent to a space or scheduling it, which is deferred until the commands
+     * are flushed. It is safe to call concurrently.
+     * @tparam F Type of the command. It must be invocable with reference to the model.
+     * @param command Command to record.
+     */
+    template<typename F>
+    void defer(F&& command);
+
+    /**
+     * Applies deferred commands in the order of their keys, then passes removals of the killed agents to the attached
+     * listeners. Schedule calls it after beforeStep, after the step and advance phases, and after
+     * afterStep of every time step, and it sets the keys so that the order doesn't depend on the number of threads.
+     */
+    void flushCommands();
+
+    /**
+     * Returns buffer of the deferred commands.
+     * @return Reference to the command buffer.
+     */
+    CommandBuffer<Model>& commands() { return *commandBuffer; }
+
+    /**
+     * Removes all agents which are not active and moves the remaining agents of every type to the lowest slots of
+     * their pool, so that they are contiguous, then releases unused memory. Deferred commands are flushed first.
+     * Attached spaces and schedules are passed the table of relocations, so that they update their references, and
+     * they drop references to the removed agents. Secondary indexes are rebuilt. Other references, pointers and handles
+     * to the moved agents are invalidated. It must not be called during a step of the schedule.
+     * @return Number of removed agents.
+     */
+    size_t compact();
+
+    /**
+     * Registers space or schedule which is updated by compact. It must be detached before it is destroyed, if the
+     * model is compacted afterward.
+     * @tparam L Type of the listener. It must have relocate method accepting RelocationTable.
+     * @param listener Space or schedule referring to the agents of the model.
+     */
+    template<typename L> requires requires(L& l, const Relocations<Agents...>& r) { l.relocate(r); }
+    void attach(L& listener);
+
+    /**
+     * Unregisters space or schedule, which won't be updated by compact anymore.
+     * @param listener Previously attached space or schedule.
+     */
+    void detach(const auto& listener);
+
+    /**
+     * Declares secondary index over the agents of type T, e.g. FlagIndex, SortedIndex or CategoryIndex. The index is
+     * built from the present agents and maintained when agents are added, removed or compacted. Changes of the
+     * indexed attributes must be made through update, or reported with reindex.
+     * @tparam T Type of the indexed agents.
+     * @tparam I Template of the index, taking the type of the pool and the type of the extractor.
+     * @tparam F Type of the extractor, i.e. predicate, key or category of an agent.
+     * @param f Extractor invocable with Reference<T>.
+     * @return Reference to the index, valid until it is removed.
+     */
+    template<ActiveAgent T, template<typename, typename> class I, typename F>
+    I<Storage<T>, std::decay_t<F>>& addIndex(F&& f);
+
+    /**
+     * Removes secondary index declared with addIndex.
+     * @tparam T Type of the indexed agents.
+     * @param index Reference to the index.
+     */
+    template<ActiveAgent T>
+    void removeIndex(const AgentIndex<Storage<T>>& index);
+
+    /**
+     * Modifies the agent and updates secondary indexes of its type. It must not be called concurrently.
+     * @tparam T Type of the agent.
+     * @tparam F Type of the callable. It must be invocable with a reference to the agent.
+     * @param agent Reference to an agent stored in the model.
+     * @param f Callable modifying the agent.
+     */
+    template<ActiveAgent T, typename F> requires std::invocable<F, T&>
+    void update(T& agent, F&& f);
+
+    /**
+     * Modifies the agent stored as structure of arrays and updates secondary indexes of its type. It must not be
+     * called concurrently.
+     * @tparam T Type of the agent.
+     * @tparam F Type of the callable. It must be invocable with a proxy reference to the agent.
+     * @param agent Proxy reference to an agent stored in the model.
+     * @param f Callable modifying the agent.
+     */
+    template<SoaAgent T, typename F> requires std::invocable<F, SoaReference<T>>
+    void update(SoaReference<T> agent, F&& f);
+
+    /**
+     * Updates secondary indexes of the agent after its attributes were modified directly. It must not be called
+     * concurrently, e.g. changes made during a parallel step should be reported with deferred commands.
+     * @tparam T Type of the agent.
+     * @param agent Reference to an agent stored in the model.
+     */
+    template<ActiveAgent T>
+    void reindex(const T& agent);
+
+    /**
+     * Updates secondary indexes of the agent stored as structure of arrays after its attributes were modified.
+     * @tparam T Type of the agent.
+     * @param agent Proxy reference to an agent stored in the model.
+     */
+    template<SoaAgent T>
+    void reindex(SoaReference<T> agent);
+
+    /**
+     * Rebuilds secondary indexes of the agents of type T, e.g. after they were modified by a bulk operation.
+     * @tparam T Type of the agents.
+     */
+    template<ActiveAgent T>
+    void reindex();
+
 protected:
-    std::tuple<std::deque<Agents>...> agents{};
+    std::tuple<Storage<Agents>...> agents{};
+
+private:
+    // Number of chunks of 64 slots processed by one thread at a time.
+    static constexpr size_t bulkGrain = 16;
+
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<CommandBuffer<Model>> commandBuffer{std::make_unique<CommandBuffer<Model>>()};
+
+    struct Listener {
+        void* object;
+        void (*relocate)(void*, const RelocationTable&);
+    };
+
+    std::vector<Listener> listeners;
+    // Agents killed by the commands of the current flush, whose slots are held until the listeners are notified.
+    std::tuple<std::vector<Relocation<Agents>>...> killed;
+
+    std::tuple<std::vector<std::unique_ptr<AgentIndex<Storage<Agents>>>>...> indexes;
+
+    template<typename T>
+    auto& indexesOf() { return std::get<std::vector<std::unique_ptr<AgentIndex<Storage<T>>>>>(indexes); }
+
+    template<typename P>
+    [[nodiscard]] bool runsParallel() const;
+
+    template<ActiveAgent T>
+    void removeKilled(const T& agent);
+
+    template<SoaAgent T>
+    void removeKilled(SoaReference<T> agent);
+
+    template<ActiveAgent T, typename F>
+    void forChunks(bool parallel, F&& f);
+
+    template<ActiveAgent T, typename F>
+    void forSlots(size_t beginChunk, size_t endChunk, F& f);
 };
 }
 
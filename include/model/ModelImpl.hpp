@@ -1,31 +1,124 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
+#include <functional>
 
 namespace agh {
 template<ActiveAgent... Agents> requires (sizeof...(Agents) > 0)
 template<ActiveAgent T>
-std::deque<T>& Model<Agents...>::getAgents() {
-    return std::get<std::deque<T>>(agents);
+auto Model<Agents...>::getAgents() -> Storage<T>& {
+    return std::get<Storage<T>>(agents);
 }
 
 template<ActiveAgent... Agents> requires (sizeof...(Agents) > 0)
 template<ActiveAgent T>
-T& Model<Agents...>::addAgent(const T& agent) {
-    getAgents<T>().push_back(agent);
-    return getAgents<T>().back();
+auto Model<Agents...>::addAgent(const T& agent) -> Reference<T> {
+    Reference<T> added = getAgents<T>().emplace(agent);
+    for (auto& index : indexesOf<T>()) {
+        index->insert(getAgents<T>().slotOf(added));
+    }
+    return added;
 }
 
 template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
 template<ActiveAgent T, typename... Args>
-T& Model<Agents...>::emplaceAgent(Args&&... args) {
-    getAgents<T>().emplace_back(std::forward<Args>(args)...);
-    return getAgents<T>().back();
+auto Model<Agents...>::emplaceAgent(Args&&... args) -> Reference<T> {
+    Reference<T> added = getAgents<T>().emplace(std::forward<Args>(args)...);
+    for (auto& index : indexesOf<T>()) {
+        index->insert(getAgents<T>().slotOf(added));
+    }
+    return added;
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T>
+void Model<Agents...>::removeAgent(const T& agent) {
+    for (auto& index : indexesOf<T>()) {
+        index->erase(getAgents<T>().slotOf(agent));
+    }
+    getAgents<T>().erase(agent);
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<SoaAgent T>
+void Model<Agents...>::removeAgent(const SoaReference<T> agent) {
+    for (auto& index : indexesOf<T>()) {
+        index->erase(agent.slot());
+    }
+    getAgents<T>().erase(agent);
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T>
+AgentHandle Model<Agents...>::handleOf(const T& agent) const {
+    static_assert(!SoaAgent<T>, "Agents stored as structure of arrays are referred to by SoaReference, e.g. in "
+                                "stepBatch, as step of the proxy runs on a copy of the agent");
+    const auto& pool = std::get<AgentPool<T>>(agents);
+    const size_t slot = pool.slotOf(agent);
+    return {typeIndex<T>(), slot, pool.generation(slot)};
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<SoaAgent T>
+AgentHandle Model<Agents...>::handleOf(const SoaReference<T> agent) const {
+    return {typeIndex<T>(), agent.slot(), std::get<SoaPool<T>>(agents).generation(agent.slot())};
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T>
+auto Model<Agents...>::get(const AgentHandle handle) -> Pointer<T> {
+    auto& pool = getAgents<T>();
+    const size_t slot = handle.slot();
+    if (handle.type() != typeIndex<T>() || !pool.occupied(slot) || pool.generation(slot) != handle.generation()) {
+        return {};
+    }
+    if constexpr (SoaAgent<T>) {
+        return pool[slot];
+    }
+    else {
+        return &pool[slot];
+    }
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+bool Model<Agents...>::isAlive(const AgentHandle handle) const {
+    return std::apply([handle](const auto&... pools) {
+                          size_t type = 0;
+                          return ((type++ == handle.type() && pools.occupied(handle.slot()) &&
+                                   pools.generation(handle.slot()) == handle.generation()) || ...);
+                      },
+                      agents);
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<typename F>
+bool Model<Agents...>::visit(const AgentHandle handle, F&& f) {
+    return ([&] {
+        if (auto agent = get<Agents>(handle)) {
+            if constexpr (SoaAgent<Agents>) {
+                f(agent);
+            }
+            else {
+                f(*agent);
+            }
+            return true;
+        }
+        return false;
+    }() || ...);
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T>
+constexpr size_t Model<Agents...>::typeIndex() {
+    size_t index = 0;
+    (void)((std::is_same_v<T, Agents> || (++index, false)) || ...);
+    return index;
 }
 
 template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
 size_t Model<Agents...>::agentCount() const {
-    return std::apply([](auto... v) {
+    return std::apply([](const auto&... v) {
                           return (v.size() + ...);
                       },
                       agents);
@@ -36,4 +129,266 @@ template<ActiveAgent T>
 size_t Model<Agents...>::agentCount() {
     return getAgents<T>().size();
 }
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+void Model<Agents...>::setThreads(const size_t threads) {
+    if (threads <= 1) {
+        pool.reset();
+        return;
+    }
+    pool = std::make_unique<ThreadPool>(threads);
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ExecutionPolicy P, typename F>
+void Model<Agents...>::forEach(P&& policy, F&& f) {
+    (forEach<Agents>(policy, f), ...);
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T, ExecutionPolicy P, typename F>
+void Model<Agents...>::forEach(P&&, F&& f) {
+    forChunks<T>(runsParallel<P>(), [&](const size_t begin, const size_t end) {
+        forSlots<T>(begin, end, f);
+    });
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ExecutionPolicy P, typename R, typename Reduce, typename Transform>
+R Model<Agents...>::transformReduce(P&& policy, R init, Reduce reduce, Transform transform) {
+    ((init = transformReduce<Agents>(policy, std::move(init), reduce, transform)), ...);
+    return init;
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T, ExecutionPolicy P, typename R, typename Reduce, typename Transform>
+R Model<Agents...>::transformReduce(P&&, R init, Reduce reduce, Transform transform) {
+    const size_t chunks = getAgents<T>().chunkCount();
+    std::vector<std::optional<R>> partials((chunks + bulkGrain - 1) / bulkGrain);
+    forChunks<T>(runsParallel<P>(), [&](const size_t begin, const size_t end) {
+        std::optional<R>& partial = partials[begin / bulkGrain];
+        auto accumulate = [&](auto&& agent) {
+            if (partial) {
+                *partial = reduce(std::move(*partial), transform(agent));
+            }
+            else {
+                partial.emplace(transform(agent));
+            }
+        };
+        forSlots<T>(begin, end, accumulate);
+    });
+
+    for (auto& partial : partials) {
+        if (partial) {
+            init = reduce(std::move(init), std::move(*partial));
+        }
+    }
+    return init;
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ExecutionPolicy P, typename Predicate>
+size_t Model<Agents...>::countIf(P&& policy, Predicate predicate) {
+    return (countIf<Agents>(policy, predicate) + ...);
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T, ExecutionPolicy P, typename Predicate>
+size_t Model<Agents...>::countIf(P&& policy, Predicate predicate) {
+    return transformReduce<T>(policy, size_t{0}, std::plus<>(), [&](auto&& agent) -> size_t {
+        return predicate(agent) ? 1 : 0;
+    });
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<typename P>
+bool Model<Agents...>::runsParallel() const {
+    return pool && isParallelPolicy<P>;
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T, typename F>
+void Model<Agents...>::forChunks(const bool parallel, F&& f) {
+    // Commands recorded by every group of chunks get their own key, so they are applied in the same order regardless
+    // of the policy and the number of threads.
+    const size_t chunks = getAgents<T>().chunkCount();
+    const uint64_t serial = commandBuffer->nextSerial();
+    auto run = [&](const size_t begin, const size_t end) {
+        CommandKey::Scope scope(serial << 32 | begin);
+        f(begin, end);
+    };
+    if (parallel) {
+        pool->parallelFor(0, chunks, bulkGrain, run);
+        return;
+    }
+    for (size_t begin = 0; begin < chunks; begin += bulkGrain) {
+        run(begin, std::min(begin + bulkGrain, chunks));
+    }
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T, typename F>
+void Model<Agents...>::forSlots(const size_t beginChunk, const size_t endChunk, F& f) {
+    auto& storage = getAgents<T>();
+    for (size_t chunk = beginChunk; chunk < endChunk; ++chunk) {
+        for (uint64_t bits = storage.occupancy(chunk); bits; bits &= bits - 1) {
+            f(storage[chunk * 64 + std::countr_zero(bits)]);
+        }
+    }
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T, typename... Args>
+void Model<Agents...>::spawn(Args&&... args) {
+    commandBuffer->push([... args = std::forward<Args>(args)](Model& model) mutable {
+        model.emplaceAgent<T>(std::move(args)...);
+    });
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T, typename F, typename... Args>
+void Model<Agents...>::spawnWith(F&& init, Args&&... args) {
+    commandBuffer->push([init = std::forward<F>(init), ... args = std::forward<Args>(args)](Model& model) mutable {
+        model.update(model.emplaceAgent<T>(std::move(args)...), init);
+    });
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+void Model<Agents...>::kill(const auto& agent) {
+    commandBuffer->push([handle = handleOf(agent)](Model& model) {
+        model.visit(handle, [&](auto&& alive) { model.removeKilled(alive); });
+    });
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<typename F>
+void Model<Agents...>::defer(F&& command) {
+    commandBuffer->push(std::forward<F>(command));
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+void Model<Agents...>::flushCommands() {
+    commandBuffer->flush(*this);
+    if (std::apply([](const auto&... records) { return (records.empty() && ...); }, killed)) {
+        return;
+    }
+
+    const RelocationTable relocations(std::exchange(killed, {}));
+    for (const Listener& listener : listeners) {
+        listener.relocate(listener.object, relocations);
+    }
+    ([&] {
+        if constexpr (!SoaAgent<Agents>) {
+            getAgents<Agents>().releaseHeld();
+        }
+    }(), ...);
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T>
+void Model<Agents...>::removeKilled(const T& agent) {
+    auto& pool = getAgents<T>();
+    const size_t slot = pool.slotOf(agent);
+    for (auto& index : indexesOf<T>()) {
+        index->erase(slot);
+    }
+    std::get<std::vector<Relocation<T>>>(killed).push_back(
+        {const_cast<T*>(&agent), nullptr, slot, slot, pool.generation(slot), 0, true});
+    pool.eraseHeld(slot);
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<SoaAgent T>
+void Model<Agents...>::removeKilled(const SoaReference<T> agent) {
+    // Structure-of-arrays agents are referred to by handles, which tell apart agents reusing the slot.
+    std::get<std::vector<Relocation<T>>>(killed).push_back(
+        {nullptr, nullptr, agent.slot(), agent.slot(), handleOf(agent).generation(), 0, true});
+    removeAgent(agent);
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+size_t Model<Agents...>::compact() {
+    flushCommands();
+
+    std::tuple<std::vector<Relocation<Agents>>...> records;
+    (getAgents<Agents>().compact([](auto&& agent) { return agent.isActive(); },
+                                 std::get<std::vector<Relocation<Agents>>>(records)), ...);
+    const RelocationTable relocations(std::move(records));
+    (reindex<Agents>(), ...);
+    for (const Listener& listener : listeners) {
+        listener.relocate(listener.object, relocations);
+    }
+
+    size_t removed = 0;
+    ((removed += std::ranges::count_if(relocations.template of<Agents>(), &Relocation<Agents>::removed)), ...);
+    return removed;
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<typename L> requires requires(L& l, const Relocations<Agents...>& r) { l.relocate(r); }
+void Model<Agents...>::attach(L& listener) {
+    listeners.push_back(Listener{&listener, [](void* object, const RelocationTable& relocations) {
+        static_cast<L*>(object)->relocate(relocations);
+    }});
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+void Model<Agents...>::detach(const auto& listener) {
+    std::erase_if(listeners, [&](const Listener& entry) {
+        return entry.object == static_cast<const void*>(std::addressof(listener));
+    });
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T, template<typename, typename> class I, typename F>
+auto Model<Agents...>::addIndex(F&& f) -> I<Storage<T>, std::decay_t<F>>& {
+    auto index = std::make_unique<I<Storage<T>, std::decay_t<F>>>(getAgents<T>(), std::forward<F>(f));
+    auto& result = *index;
+    indexesOf<T>().push_back(std::move(index));
+    return result;
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T>
+void Model<Agents...>::removeIndex(const AgentIndex<Storage<T>>& index) {
+    std::erase_if(indexesOf<T>(), [&](const auto& entry) { return entry.get() == &index; });
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T, typename F> requires std::invocable<F, T&>
+void Model<Agents...>::update(T& agent, F&& f) {
+    std::invoke(std::forward<F>(f), agent);
+    reindex(agent);
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<SoaAgent T, typename F> requires std::invocable<F, SoaReference<T>>
+void Model<Agents...>::update(const SoaReference<T> agent, F&& f) {
+    std::invoke(std::forward<F>(f), agent);
+    reindex(agent);
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T>
+void Model<Agents...>::reindex(const T& agent) {
+    for (auto& index : indexesOf<T>()) {
+        index->update(getAgents<T>().slotOf(agent));
+    }
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<SoaAgent T>
+void Model<Agents...>::reindex(const SoaReference<T> agent) {
+    for (auto& index : indexesOf<T>()) {
+        index->update(agent.slot());
+    }
+}
+
+template<ActiveAgent ... Agents> requires (sizeof...(Agents) > 0)
+template<ActiveAgent T>
+void Model<Agents...>::reindex() {
+    for (auto& index : indexesOf<T>()) {
+        index->rebuild();
+    }
+}
 }
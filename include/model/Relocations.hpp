@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "AgentHandle.hpp"
+
+namespace agh {
+/**
+ * Record of an agent moved or removed by compaction of its pool.
+ * @tparam T Type of the agent.
+ */
+template<typename T>
+struct Relocation {
+    T* from;
+    T* to;
+    size_t fromSlot;
+    size_t toSlot;
+    uint32_t fromGeneration;
+    uint32_t toGeneration;
+    bool removed;
+};
+
+/**
+ * Table of agents moved or removed by Model::compact, passed to the attached spaces and schedules, so that they can
+ * update their references. Lookups take O(log n) time in the number of relocated agents of the given type.
+ * @tparam Agents Types of the agents, in the order of the model's template arguments.
+ */
+template<typename... Agents>
+class Relocations {
+public:
+    Relocations() = default;
+
+    /**
+     * Creates table from the relocations of every agent type.
+     * @param pRecords Relocations of the agents of every type, in any order.
+     */
+    explicit Relocations(std::tuple<std::vector<Relocation<Agents>>...> pRecords);
+
+    /**
+     * Returns address of the agent after compaction.
+     * @tparam T Type of the agent.
+     * @param agent Address of the agent before compaction.
+     * @return New address of the agent, the same address if it wasn't moved, or nullptr if it was removed.
+     */
+    template<typename T>
+    [[nodiscard]] T* relocate(T* agent) const;
+
+    /**
+     * Returns address of the agent after compaction, keeping its type.
+     * @param agent Address of the agent before compaction.
+     * @return New address of the agent, or nullptr of the agent's type if it was removed.
+     */
+    template<typename... Ts>
+    [[nodiscard]] std::variant<Ts*...> relocate(const std::variant<Ts*...>& agent) const;
+
+    /**
+     * Returns handle of the agent after compaction.
+     * @param handle Handle of the agent before compaction.
+     * @return Handle referring to the new slot of the agent, the same handle if it wasn't moved, or an empty handle if
+     * the agent was removed.
+     */
+    [[nodiscard]] AgentHandle relocate(AgentHandle handle) const;
+
+    /**
+     * Returns relocations of the agents of type T, ordered by their previous slots.
+     * @tparam T Type of the agents.
+     * @return Span of the relocations.
+     */
+    template<typename T>
+    [[nodiscard]] std::span<const Relocation<T>> of() const { return std::get<std::vector<Relocation<T>>>(records); }
+
+    /**
+     * Returns number of moved or removed agents.
+     * @return Number of relocations.
+     */
+    [[nodiscard]] size_t size() const;
+
+    /**
+     * Checks if any agent was moved or removed.
+     * @return True if there are no relocations, false otherwise.
+     */
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+private:
+    template<typename T>
+    using AddressIndex = std::vector<std::pair<const T*, size_t>>;
+
+    std::tuple<std::vector<Relocation<Agents>>...> records;
+    std::tuple<AddressIndex<Agents>...> addresses;
+
+    template<size_t I>
+    [[nodiscard]] AgentHandle relocateAs(AgentHandle handle) const;
+};
+}
+
+#include "RelocationsImpl.hpp"
@@ -0,0 +1,72 @@
+#pragma once
+
+namespace agh {
+template<typename... Agents>
+Relocations<Agents...>::Relocations(std::tuple<std::vector<Relocation<Agents>>...> pRecords)
+    : records(std::move(pRecords)) {
+    auto index = [](auto& list, auto& byAddress) {
+        std::ranges::sort(list, {}, [](const auto& record) { return record.fromSlot; });
+        byAddress.clear();
+        for (size_t i = 0; i < list.size(); ++i) {
+            if (list[i].from) {
+                byAddress.emplace_back(list[i].from, i);
+            }
+        }
+        std::ranges::sort(byAddress);
+    };
+    (index(std::get<std::vector<Relocation<Agents>>>(records), std::get<AddressIndex<Agents>>(addresses)), ...);
+}
+
+template<typename... Agents>
+template<typename T>
+T* Relocations<Agents...>::relocate(T* agent) const {
+    using U = std::remove_const_t<T>;
+    if constexpr ((std::is_same_v<U, Agents> || ...)) {
+        const auto& byAddress = std::get<AddressIndex<U>>(addresses);
+        const auto found = std::ranges::lower_bound(byAddress, agent, {}, [](const auto& entry) {
+            return entry.first;
+        });
+        if (found == byAddress.end() || found->first != agent) {
+            return agent;
+        }
+        const Relocation<U>& record = std::get<std::vector<Relocation<U>>>(records)[found->second];
+        return record.removed ? nullptr : record.to;
+    }
+    else {
+        return agent;
+    }
+}
+
+template<typename... Agents>
+template<typename... Ts>
+std::variant<Ts*...> Relocations<Agents...>::relocate(const std::variant<Ts*...>& agent) const {
+    return std::visit([&](auto* pointer) { return std::variant<Ts*...>(relocate(pointer)); }, agent);
+}
+
+template<typename... Agents>
+AgentHandle Relocations<Agents...>::relocate(const AgentHandle handle) const {
+    AgentHandle result = handle;
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        (void)((handle.type() == I && (result = relocateAs<I>(handle), true)) || ...);
+    }(std::index_sequence_for<Agents...>{});
+    return result;
+}
+
+template<typename... Agents>
+template<size_t I>
+AgentHandle Relocations<Agents...>::relocateAs(const AgentHandle handle) const {
+    const auto& list = std::get<I>(records);
+    const auto found = std::ranges::lower_bound(list, handle.slot(), {}, [](const auto& record) {
+        return record.fromSlot;
+    });
+    if (found == list.end() || found->fromSlot != handle.slot() || found->fromGeneration != handle.generation()) {
+        return handle;
+    }
+    return found->removed ? AgentHandle() : AgentHandle(I, found->toSlot, found->toGeneration);
+}
+
+template<typename... Agents>
+size_t Relocations<Agents...>::size() const {
+    return std::apply([](const auto&... list) { return (list.size() + ...); }, records);
+}
+}
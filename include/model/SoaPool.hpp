@@ -0,0 +1,325 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Relocations.hpp"
+#include "../utilities/AlignedAllocator.hpp"
+#include "../utilities/Concepts.hpp"
+
+namespace agh {
+template<SoaAgent T>
+class SoaPool;
+
+/**
+ * Proxy reference to an agent stored in a SoaPool. Members are accessed directly in their columns with get. Methods of
+ * the agent, like step, are called on a copy of the agent assembled from the columns, which is then written back, so
+ * agent types don't have to be changed to be stored as structure of arrays. Copying whole agents is avoided by agent
+ * types which list members read by isActive in T::activeMembers, and which step whole groups of proxies in stepBatch.
+ * The proxy is also the pool's pointer type, so it can be dereferenced like a pointer to the agent. Since step and
+ * advance run on a copy, the agent cannot refer to itself in the model there, e.g. with model.kill(*this), and writes
+ * to its columns made through the model are overwritten when the copy is written back. Agents which do so should
+ * implement stepBatch, and pass their proxies to the model instead, e.g. model.kill(proxy).
+ * @tparam T Type of the agent.
+ */
+template<SoaAgent T>
+class SoaReference {
+public:
+    /**
+     * Creates reference which does not refer to any agent.
+     */
+    SoaReference() = default;
+
+    SoaReference(SoaPool<T>* pPool, const size_t pSlot) : pool(pPool), index(pSlot) {}
+
+    /**
+     * Returns the member of the agent stored in its column.
+     * @tparam Member Pointer to the member, listed in T::members.
+     * @return Reference to the member.
+     */
+    template<auto Member>
+    [[nodiscard]] auto& get() const { return pool->template column<Member>()[index]; }
+
+    /**
+     * Assembles copy of the agent from the columns. Members not listed in T::members are default initialized.
+     * @return Copy of the agent.
+     */
+    [[nodiscard]] T load() const { return pool->load(index); }
+
+    /**
+     * Writes members of the agent to the columns.
+     * @param agent New value of the agent.
+     */
+    void store(const T& agent) const { pool->store(index, agent); }
+
+    operator T() const { return load(); }
+
+    [[nodiscard]] bool isActive() const { return pool->isActive(index); }
+
+    template<typename M>
+    void step(M& model) const requires Schedulable<T, M> {
+        T agent = load();
+        agent.step(model);
+        store(agent);
+    }
+
+    template<typename M>
+    void advance(M& model) const requires Advanceable<T, M> {
+        T agent = load();
+        agent.advance(model);
+        store(agent);
+    }
+
+    /**
+     * Returns index of the agent's slot in the pool.
+     * @return Slot index.
+     */
+    [[nodiscard]] size_t slot() const { return index; }
+
+    explicit operator bool() const { return pool != nullptr; }
+
+    const SoaReference& operator*() const { return *this; }
+
+    const SoaReference* operator->() const { return this; }
+
+    bool operator==(const SoaReference&) const = default;
+
+private:
+    SoaPool<T>* pool{};
+    size_t index{};
+};
+
+/**
+ * Container storing agents of one type as structure of arrays. Every member listed in T::members is kept in its own
+ * contiguous array aligned to a cache line, so loops touching one member read only that member and can be vectorized.
+ * If T::activeMembers lists the members read by isActive, only those are loaded to check whether an agent is active.
+ * Slots are managed like in AgentPool: removed slots are reused, and every chunk of 64 slots has an occupancy bitmask.
+ * Agents are accessed through SoaReference proxies, which stay valid while the agent is present, even when columns
+ * grow. Spans returned by column are invalidated by adding agents.
+ * @tparam T Type of the stored agents. It must meet SoaAgent requirements.
+ */
+template<SoaAgent T>
+class SoaPool {
+    using Members = std::remove_cvref_t<decltype(T::members)>;
+    static constexpr size_t memberCount = std::tuple_size_v<Members>;
+    static constexpr size_t chunkSize = 64;
+
+    template<typename P>
+    struct MemberOf;
+
+    template<typename C, typename R>
+    struct MemberOf<R C::*> {
+        using type = R;
+    };
+
+    template<size_t I>
+    using MemberType = typename MemberOf<std::tuple_element_t<I, Members>>::type;
+
+    template<typename R>
+    using Column = std::vector<R, AlignedAllocator<R>>;
+
+    template<typename Sequence>
+    struct ColumnsOf;
+
+    template<size_t... I>
+    struct ColumnsOf<std::index_sequence<I...>> {
+        using type = std::tuple<Column<MemberType<I>>...>;
+    };
+
+public:
+    using reference = SoaReference<T>;
+    using pointer = SoaReference<T>;
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = SoaReference<T>;
+        using difference_type = std::ptrdiff_t;
+        using reference = SoaReference<T>;
+
+        Iterator() = default;
+
+        reference operator*() const { return {pool, slot}; }
+
+        Iterator& operator++() {
+            slot = pool->nextOccupied(slot + 1);
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const Iterator& rhs) const { return slot == rhs.slot; }
+
+    private:
+        friend SoaPool;
+
+        Iterator(SoaPool* pPool, const size_t pSlot) : pool(pPool), slot(pSlot) {}
+
+        SoaPool* pool{};
+        size_t slot{};
+    };
+
+    using iterator = Iterator;
+
+    /**
+     * Creates agent from the given arguments and stores its members in a free slot, or in a new one if there are no
+     * free slots.
+     * @tparam Args Types of the constructor's arguments for type T.
+     * @param args Arguments passed to the agent's constructor.
+     * @return Proxy reference to the created agent.
+     */
+    template<typename... Args>
+    reference emplace(Args&&... args);
+
+    /**
+     * Frees the slot of the agent in O(1).
+     * @param agent Reference to an agent stored in this pool.
+     */
+    void erase(reference agent) { eraseAt(agent.slot()); }
+
+    /**
+     * Frees the given slot in O(1). Values in the columns are left as they were until the slot is reused.
+     * @param slot Index of an occupied slot.
+     */
+    void eraseAt(size_t slot);
+
+    /**
+     * Returns index of the slot occupied by the agent.
+     * @param agent Reference to an agent stored in this pool.
+     * @return Index of the slot.
+     */
+    [[nodiscard]] size_t slotOf(const reference agent) const { return agent.slot(); }
+
+    /**
+     * Checks if the slot is occupied by an agent.
+     * @param slot Index of the slot.
+     * @return True if there is an agent in the slot, false otherwise.
+     */
+    [[nodiscard]] bool occupied(const size_t slot) const {
+        return slot < used && (occupancy(slot / chunkSize) >> (slot % chunkSize) & 1);
+    }
+
+    /**
+     * Returns generation of the slot, which changes every time an agent is removed from the slot.
+     * @param slot Index of the slot, lower than slots().
+     * @return Generation of the slot, never zero.
+     */
+    [[nodiscard]] uint32_t generation(const size_t slot) const { return generations[slot]; }
+
+    /**
+     * Returns proxy reference to the agent in the given slot.
+     * @param slot Index of an occupied slot.
+     * @return Reference to the agent.
+     */
+    reference operator[](const size_t slot) { return {this, slot}; }
+
+    /**
+     * Returns column of the given member. It has an element for every slot, including free ones, whose values are
+     * unspecified, so kernels processing whole columns must either tolerate them or consult occupancy.
+     * @tparam Member Pointer to the member, listed in T::members.
+     * @return Span over the member of all slots.
+     */
+    template<auto Member>
+    [[nodiscard]] auto column() { return std::span(std::get<memberIndex<Member>()>(columns)); }
+
+    template<auto Member>
+    [[nodiscard]] auto column() const { return std::span(std::get<memberIndex<Member>()>(columns)); }
+
+    /**
+     * Assembles copy of the agent in the given slot.
+     * @param slot Index of an occupied slot.
+     * @return Copy of the agent.
+     */
+    [[nodiscard]] T load(size_t slot) const;
+
+    /**
+     * Checks if the agent in the given slot is active. Only members listed in T::activeMembers are loaded, if the type
+     * declares them, and the agent is loaded whole otherwise.
+     * @param slot Index of an occupied slot.
+     * @return Result of isActive called on the agent.
+     */
+    [[nodiscard]] bool isActive(size_t slot) const;
+
+    /**
+     * Writes members of the agent to the given slot.
+     * @param slot Index of an occupied slot.
+     * @param agent New value of the agent.
+     */
+    void store(size_t slot, const T& agent);
+
+    /**
+     * Returns number of agents stored in the pool.
+     * @return Number of occupied slots.
+     */
+    [[nodiscard]] size_t size() const { return live; }
+
+    /**
+     * Checks if there is any agent in the pool.
+     * @return True if pool is empty, false otherwise.
+     */
+    [[nodiscard]] bool empty() const { return live == 0; }
+
+    /**
+     * Returns number of slots, both occupied and free. It is also the length of every column.
+     * @return Number of slots.
+     */
+    [[nodiscard]] size_t slots() const { return used; }
+
+    /**
+     * Returns occupancy bitmask of the given chunk of 64 slots, starting at slot 64 * chunk.
+     * @param chunk Index of the chunk.
+     * @return Mask whose i-th bit is set if slot 64 * chunk + i is occupied.
+     */
+    [[nodiscard]] uint64_t occupancy(const size_t chunk) const { return occupancyMasks[chunk]; }
+
+    /**
+     * Returns number of chunks of 64 slots.
+     * @return Number of chunks.
+     */
+    [[nodiscard]] size_t chunkCount() const { return occupancyMasks.size(); }
+
+    /**
+     * Removes all agents which shouldn't be kept and moves the remaining ones to the lowest slots, so that columns
+     * have no gaps, then shrinks the columns. Proxy references and handles to the moved agents are invalidated, which
+     * is described by the appended relocations, whose addresses are null.
+     * @tparam Keep Type of the predicate.
+     * @param keep Predicate invocable with a proxy reference to an agent, returning false for agents to remove.
+     * @param relocations Vector to which relocations of the moved and removed agents are appended.
+     */
+    template<typename Keep>
+    void compact(Keep&& keep, std::vector<Relocation<T>>& relocations);
+
+    /**
+     * Removes all agents and releases the memory.
+     */
+    void clear();
+
+    iterator begin() { return {this, nextOccupied(0)}; }
+    iterator end() { return {this, used}; }
+
+private:
+    typename ColumnsOf<std::make_index_sequence<memberCount>>::type columns;
+    std::vector<uint64_t> occupancyMasks;
+    std::vector<size_t> freeSlots;
+    std::vector<uint32_t> generations;
+    size_t used{};
+    size_t live{};
+
+    template<auto Member>
+    static constexpr size_t memberIndex();
+
+    [[nodiscard]] size_t nextOccupied(size_t slot) const;
+};
+}
+
+#include "SoaPoolImpl.hpp"
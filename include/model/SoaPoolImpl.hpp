@@ -0,0 +1,155 @@
+#pragma once
+
+#include <bit>
+
+namespace agh {
+template<SoaAgent T>
+template<typename... Args>
+auto SoaPool<T>::emplace(Args&&... args) -> reference {
+    const T agent(std::forward<Args>(args)...);
+    size_t slot;
+    if (freeSlots.empty()) {
+        slot = used;
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (std::get<I>(columns).push_back(agent.*std::get<I>(T::members)), ...);
+        }(std::make_index_sequence<memberCount>{});
+        if (slot % chunkSize == 0) {
+            occupancyMasks.push_back(0);
+        }
+        if (slot == generations.size()) {
+            generations.push_back(1);
+        }
+        used += 1;
+    }
+    else {
+        slot = freeSlots.back();
+        store(slot, agent);
+        freeSlots.pop_back();
+    }
+
+    occupancyMasks[slot / chunkSize] |= uint64_t{1} << (slot % chunkSize);
+    live += 1;
+    return {this, slot};
+}
+
+template<SoaAgent T>
+void SoaPool<T>::eraseAt(const size_t slot) {
+    occupancyMasks[slot / chunkSize] &= ~(uint64_t{1} << (slot % chunkSize));
+    generations[slot] = generations[slot] % ((1u << 24) - 1) + 1;
+    freeSlots.push_back(slot);
+    live -= 1;
+}
+
+template<SoaAgent T>
+T SoaPool<T>::load(const size_t slot) const {
+    T agent{};
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        ((agent.*std::get<I>(T::members) = std::get<I>(columns)[slot]), ...);
+    }(std::make_index_sequence<memberCount>{});
+    return agent;
+}
+
+template<SoaAgent T>
+bool SoaPool<T>::isActive(const size_t slot) const {
+    if constexpr (requires { std::tuple_size<std::remove_cvref_t<decltype(T::activeMembers)>>::value; }) {
+        T agent{};
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            ([&] {
+                constexpr auto member = std::get<I>(T::activeMembers);
+                static_assert(memberIndex<member>() < memberCount, "activeMembers must be listed in members");
+                agent.*member = std::get<memberIndex<member>()>(columns)[slot];
+            }(), ...);
+        }(std::make_index_sequence<std::tuple_size_v<std::remove_cvref_t<decltype(T::activeMembers)>>>{});
+        return agent.isActive();
+    }
+    else {
+        return load(slot).isActive();
+    }
+}
+
+template<SoaAgent T>
+void SoaPool<T>::store(const size_t slot, const T& agent) {
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        ((std::get<I>(columns)[slot] = agent.*std::get<I>(T::members)), ...);
+    }(std::make_index_sequence<memberCount>{});
+}
+
+template<SoaAgent T>
+template<typename Keep>
+void SoaPool<T>::compact(Keep&& keep, std::vector<Relocation<T>>& relocations) {
+    for (size_t slot = nextOccupied(0); slot < used; slot = nextOccupied(slot + 1)) {
+        if (!keep((*this)[slot])) {
+            relocations.push_back({nullptr, nullptr, slot, slot, generations[slot], 0, true});
+            eraseAt(slot);
+        }
+    }
+
+    size_t low = 0;
+    size_t high = used;
+    while (true) {
+        while (low < high && occupied(low)) {
+            ++low;
+        }
+        while (high > low && !occupied(high - 1)) {
+            --high;
+        }
+        if (low + 1 >= high) {
+            break;
+        }
+
+        const size_t from = high - 1;
+        std::apply([&](auto&... column) { ((column[low] = std::move(column[from])), ...); }, columns);
+        occupancyMasks[from / chunkSize] &= ~(uint64_t{1} << (from % chunkSize));
+        occupancyMasks[low / chunkSize] |= uint64_t{1} << (low % chunkSize);
+        relocations.push_back({nullptr, nullptr, from, low, generations[from], generations[low], false});
+        generations[from] = generations[from] % ((1u << 24) - 1) + 1;
+    }
+
+    used = live;
+    freeSlots.clear();
+    std::apply([&](auto&... column) { (column.resize(used), ...); }, columns);
+    occupancyMasks.resize((used + chunkSize - 1) / chunkSize);
+}
+
+template<SoaAgent T>
+void SoaPool<T>::clear() {
+    std::apply([](auto&... column) { (column.clear(), ...); }, columns);
+    occupancyMasks.clear();
+    freeSlots.clear();
+    generations.clear();
+    used = 0;
+    live = 0;
+}
+
+template<SoaAgent T>
+template<auto Member>
+constexpr size_t SoaPool<T>::memberIndex() {
+    size_t index = memberCount;
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        ([&] {
+            if constexpr (std::is_same_v<decltype(Member), std::tuple_element_t<I, Members>>) {
+                if (index == memberCount && std::get<I>(T::members) == Member) {
+                    index = I;
+                }
+            }
+        }(), ...);
+    }(std::make_index_sequence<memberCount>{});
+    return index;
+}
+
+template<SoaAgent T>
+size_t SoaPool<T>::nextOccupied(const size_t slot) const {
+    size_t chunk = slot / chunkSize;
+    if (chunk >= occupancyMasks.size()) {
+        return used;
+    }
+    uint64_t bits = occupancyMasks[chunk] & (~uint64_t{0} << (slot % chunkSize));
+    while (bits == 0) {
+        if (++chunk == occupancyMasks.size()) {
+            return used;
+        }
+        bits = occupancyMasks[chunk];
+    }
+    return chunk * chunkSize + std::countr_zero(bits);
+}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace agh {
+namespace coroutine {
+/**
+ * Pool of coroutine frames. Freed frames are kept in free lists of their size class and reused by subsequent
+ * coroutines, so spawning and finishing behaviors doesn't go to the global allocator once the pool is warm. Frames
+ * larger than the largest class are allocated directly.
+ */
+class FramePool {
+public:
+    /**
+     * Allocates memory for a coroutine frame.
+     * @param size Size of the frame in bytes.
+     * @return Pointer to the allocated memory.
+     */
+    static void* allocate(size_t size);
+
+    /**
+     * Returns memory of a coroutine frame to the pool.
+     * @param frame Pointer returned by allocate.
+     * @param size Size passed to allocate.
+     */
+    static void deallocate(void* frame, size_t size);
+
+    ~FramePool();
+
+private:
+    static constexpr size_t granularity = 64;
+    static constexpr size_t classes = 32;
+
+    std::mutex mutex;
+    std::array<std::vector<void*>, classes> free;
+
+    static FramePool& instance();
+};
+}
+
+/**
+ * Awaitable returned by schedule's delay method. Awaiting it suspends the behavior until the given time step.
+ */
+struct Delay {
+    size_t time;
+    size_t order;
+    bool keepOrder;
+
+    static constexpr bool await_ready() noexcept { return false; }
+
+    void await_suspend(auto handle) const noexcept {
+        handle.promise().time = time;
+        if (!keepOrder) {
+            handle.promise().order = order;
+        }
+    }
+
+    static constexpr void await_resume() noexcept {}
+};
+
+/**
+ * Coroutine describing multi-stage behavior of an agent. Instead of being stepped every time step and tracking its
+ * state, the agent's behavior is written as a coroutine, which waits between its stages with co_await
+ * schedule.delay(n). A behavior is started by passing it to schedule's spawn method and it is resumed only when due.
+ * Behaviors can await only delays of the schedule which runs them. Frames of behaviors are allocated from FramePool.
+ */
+class Behavior {
+public:
+    struct promise_type {
+        size_t time{};
+        size_t order{};
+        std::exception_ptr exception;
+
+        Behavior get_return_object() { return Behavior(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        static std::suspend_always initial_suspend() noexcept { return {}; }
+        static std::suspend_always final_suspend() noexcept { return {}; }
+        static void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+
+        static Delay await_transform(const Delay delay) { return delay; }
+
+        static void* operator new(const size_t size) { return coroutine::FramePool::allocate(size); }
+        static void operator delete(void* frame, const size_t size) { coroutine::FramePool::deallocate(frame, size); }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    /**
+     * Creates empty behavior, which is already done.
+     */
+    Behavior() = default;
+
+    Behavior(Behavior&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+    Behavior& operator=(Behavior&& other) noexcept;
+
+    ~Behavior();
+
+    /**
+     * Checks if the behavior has finished.
+     * @return True if the coroutine has returned, false otherwise.
+     */
+    [[nodiscard]] bool done() const { return !handle || handle.done(); }
+
+    /**
+     * Returns promise of the coroutine.
+     * @return Reference to the promise.
+     */
+    [[nodiscard]] promise_type& promise() const { return handle.promise(); }
+
+    /**
+     * Resumes the coroutine until its next suspension point. If it has thrown an exception, the exception is
+     * rethrown. The behavior object may be moved by the coroutine in the meantime.
+     */
+    void resume();
+
+private:
+    explicit Behavior(const Handle pHandle) : handle(pHandle) {}
+
+    Handle handle{};
+};
+}
+
+#include "BehaviorImpl.hpp"
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <new>
+
+namespace agh {
+namespace coroutine {
+inline void* FramePool::allocate(const size_t size) {
+    const size_t sizeClass = (size + granularity - 1) / granularity;
+    if (sizeClass >= classes) {
+        return ::operator new(size);
+    }
+
+    FramePool& pool = instance();
+    {
+        std::lock_guard lock(pool.mutex);
+        if (auto& list = pool.free[sizeClass]; !list.empty()) {
+            void* frame = list.back();
+            list.pop_back();
+            return frame;
+        }
+    }
+    return ::operator new(sizeClass * granularity);
+}
+
+inline void FramePool::deallocate(void* frame, const size_t size) {
+    const size_t sizeClass = (size + granularity - 1) / granularity;
+    if (sizeClass >= classes) {
+        ::operator delete(frame);
+        return;
+    }
+
+    FramePool& pool = instance();
+    std::lock_guard lock(pool.mutex);
+    pool.free[sizeClass].push_back(frame);
+}
+
+inline FramePool::~FramePool() {
+    for (auto& list : free) {
+        for (void* frame : list) {
+            ::operator delete(frame);
+        }
+    }
+}
+
+inline FramePool& FramePool::instance() {
+    static FramePool pool;
+    return pool;
+}
+}
+
+inline Behavior& Behavior::operator=(Behavior&& other) noexcept {
+    if (this != &other) {
+        if (handle) {
+            handle.destroy();
+        }
+        handle = std::exchange(other.handle, {});
+    }
+    return *this;
+}
+
+inline Behavior::~Behavior() {
+    if (handle) {
+        handle.destroy();
+    }
+}
+
+inline void Behavior::resume() {
+    // The coroutine may spawn other behaviors, which moves this object when the schedule's storage grows, so only the
+    // local copy of the handle is used after resuming.
+    const Handle resumed = handle;
+    resumed.resume();
+    if (resumed.promise().exception) {
+        std::rethrow_exception(std::exchange(resumed.promise().exception, {}));
+    }
+}
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "HeapQueue.hpp"
+
+namespace agh {
+namespace queue {
+/**
+ * Queue of scheduled actions organized as a time wheel. Every time step in the window [current, current + WheelSize)
+ * has its own bucket, so inserting and taking an action costs O(1). Actions scheduled beyond the window are kept in an
+ * overflow heap and moved into the wheel as the window slides. Buckets keep their storage between steps, so repeating
+ * actions cycle through already allocated memory. Location of every action is tracked by its id, so any action can be
+ * removed or moved in O(1), or O(log n) if it is in the overflow heap.
+ * @tparam Action Type of the stored action. It must be ordered by (time, order) and have a unique id.
+ * @tparam WheelSize Number of buckets in the wheel. It must be a power of two.
+ */
+template<typename Action, size_t WheelSize>
+class CalendarQueue {
+    static_assert(WheelSize > 0 && (WheelSize & (WheelSize - 1)) == 0, "WheelSize must be a power of two");
+
+public:
+    /**
+     * Creates empty queue, whose window starts at time step zero.
+     */
+    CalendarQueue() : buckets(WheelSize) {}
+
+    /**
+     * Checks if there is any action in the queue.
+     * @return True if queue is empty, false otherwise.
+     */
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    /**
+     * Returns number of actions stored in the queue.
+     * @return Number of stored actions.
+     */
+    [[nodiscard]] size_t size() const { return wheelCount + overflow.size(); }
+
+    /**
+     * Returns time of the earliest action in the queue. Queue must not be empty.
+     * @return Time step of the earliest action.
+     */
+    [[nodiscard]] size_t nextTime() const;
+
+    /**
+     * Inserts action into the queue.
+     * @param action Action to insert.
+     */
+    void push(const Action& action);
+
+    /**
+     * Preallocates storage for the given number of actions.
+     * @param capacity Number of actions which can be stored without further allocations.
+     */
+    void reserve(size_t capacity);
+
+    /**
+     * Moves all actions scheduled not later than the given time to the end of the output vector, in (time, order)
+     * order.
+     * @param time Time step up to which actions are taken.
+     * @param out Vector to which taken actions are appended.
+     */
+    void popDue(size_t time, std::vector<Action>& out);
+
+    /**
+     * Finds action with the given id.
+     * @param id Id of the action.
+     * @return Pointer to the found action, or nullptr if there is no such action in the queue. Time and order of the
+     * action must not be modified through it.
+     */
+    [[nodiscard]] Action* find(size_t id);
+
+    /**
+     * Removes action with the given id.
+     * @param id Id of the action.
+     * @return True if action was present in the queue, false otherwise.
+     */
+    bool erase(size_t id);
+
+    /**
+     * Changes time and order of the action with the given id.
+     * @param id Id of the action.
+     * @param time New time step of the action.
+     * @param order New order of the action.
+     * @return True if action was present in the queue, false otherwise.
+     */
+    bool update(size_t id, size_t time, size_t order);
+
+    /**
+     * Removes all actions satisfying given predicate. It takes O(n) time.
+     * @tparam P Type of the predicate.
+     * @param pred Predicate invocable with a reference to an action. It may modify the action, except for its time,
+     * order and id.
+     * @return Number of removed actions.
+     */
+    template<typename P>
+    size_t eraseIf(P&& pred);
+
+private:
+    static constexpr size_t mask = WheelSize - 1;
+    static constexpr size_t absent = std::numeric_limits<size_t>::max();
+    static constexpr size_t inOverflow = WheelSize;
+
+    struct Location {
+        size_t bucket{absent};
+        size_t index{};
+    };
+
+    std::vector<std::vector<Action>> buckets;
+    HeapQueue<Action> overflow;
+    std::vector<Location> locations;
+    size_t current{};
+    size_t wheelCount{};
+
+    [[nodiscard]] bool inWindow(size_t time) const;
+    void refill();
+    void insert(const Action& action);
+};
+}
+
+/**
+ * Schedule backend keeping actions in a time wheel. It suits simulations where most of the agents are scheduled
+ * repeatedly with short intervals.
+ * @tparam WheelSize Number of buckets in the wheel. It must be a power of two and should exceed the longest commonly
+ * used interval.
+ */
+template<size_t WheelSize = 256>
+struct CalendarBackend {
+    template<typename Action>
+    using Queue = queue::CalendarQueue<Action, WheelSize>;
+};
+}
+
+#include "CalendarQueueImpl.hpp"
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+
+namespace agh {
+namespace queue {
+template<typename Action, size_t WheelSize>
+size_t CalendarQueue<Action, WheelSize>::nextTime() const {
+    size_t next = overflow.empty() ? std::numeric_limits<size_t>::max() : overflow.nextTime();
+    if (wheelCount == 0) {
+        return next;
+    }
+
+    for (size_t i = 0; i < WheelSize; ++i) {
+        if (!buckets[(current + i) & mask].empty()) {
+            return std::min(next, current + i);
+        }
+    }
+    return next;
+}
+
+template<typename Action, size_t WheelSize>
+void CalendarQueue<Action, WheelSize>::push(const Action& action) {
+    if (locations.size() <= action.id) {
+        locations.resize(action.id + 1);
+    }
+    insert(action);
+}
+
+template<typename Action, size_t WheelSize>
+void CalendarQueue<Action, WheelSize>::reserve(const size_t capacity) {
+    overflow.reserve(capacity);
+    locations.reserve(capacity);
+}
+
+template<typename Action, size_t WheelSize>
+void CalendarQueue<Action, WheelSize>::popDue(const size_t time, std::vector<Action>& out) {
+    const auto first = static_cast<std::ptrdiff_t>(out.size());
+
+    const size_t fromOverflow = out.size();
+    overflow.popDue(time, out);
+    for (size_t i = fromOverflow; i < out.size(); ++i) {
+        locations[out[i].id].bucket = absent;
+    }
+
+    if (time >= current) {
+        const size_t last = time - current < WheelSize ? time : current + WheelSize - 1;
+        for (size_t t = current; t <= last && wheelCount > 0; ++t) {
+            auto& bucket = buckets[t & mask];
+            if (bucket.empty()) {
+                continue;
+            }
+
+            // Repeating actions come back in the order they were executed, so the bucket is usually already sorted.
+            // Unlike stable_sort, sort does not allocate.
+            if (!std::ranges::is_sorted(bucket, {}, &Action::order)) {
+                std::ranges::sort(bucket, {}, &Action::order);
+            }
+            for (const auto& action : bucket) {
+                locations[action.id].bucket = absent;
+            }
+            wheelCount -= bucket.size();
+            out.insert(out.end(), bucket.begin(), bucket.end());
+            bucket.clear();
+        }
+
+        current = time + 1;
+        refill();
+    }
+
+    if (!std::is_sorted(out.begin() + first, out.end())) {
+        std::sort(out.begin() + first, out.end());
+    }
+}
+
+template<typename Action, size_t WheelSize>
+Action* CalendarQueue<Action, WheelSize>::find(const size_t id) {
+    if (id >= locations.size()) {
+        return nullptr;
+    }
+
+    const auto [bucket, index] = locations[id];
+    if (bucket == absent) {
+        return nullptr;
+    }
+    if (bucket == inOverflow) {
+        return overflow.find(id);
+    }
+    return &buckets[bucket][index];
+}
+
+template<typename Action, size_t WheelSize>
+bool CalendarQueue<Action, WheelSize>::erase(const size_t id) {
+    if (id >= locations.size() || locations[id].bucket == absent) {
+        return false;
+    }
+
+    auto& location = locations[id];
+    if (location.bucket == inOverflow) {
+        overflow.erase(id);
+    }
+    else {
+        auto& bucket = buckets[location.bucket];
+        if (location.index + 1 != bucket.size()) {
+            bucket[location.index] = bucket.back();
+            locations[bucket[location.index].id].index = location.index;
+        }
+        bucket.pop_back();
+        wheelCount -= 1;
+    }
+    location.bucket = absent;
+    return true;
+}
+
+template<typename Action, size_t WheelSize>
+bool CalendarQueue<Action, WheelSize>::update(const size_t id, const size_t time, const size_t order) {
+    const Action* found = find(id);
+    if (!found) {
+        return false;
+    }
+
+    Action action = *found;
+    erase(id);
+    action.time = time;
+    action.order = order;
+    insert(action);
+    return true;
+}
+
+template<typename Action, size_t WheelSize>
+template<typename P>
+size_t CalendarQueue<Action, WheelSize>::eraseIf(P&& pred) {
+    size_t removed = 0;
+    for (size_t b = 0; b < WheelSize; ++b) {
+        auto& bucket = buckets[b];
+        removed += std::erase_if(bucket, [&](Action& action) {
+            if (pred(action)) {
+                locations[action.id].bucket = absent;
+                return true;
+            }
+            return false;
+        });
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            locations[bucket[i].id].index = i;
+        }
+    }
+    wheelCount -= removed;
+
+    removed += overflow.eraseIf([&](Action& action) {
+        if (pred(action)) {
+            locations[action.id].bucket = absent;
+            return true;
+        }
+        return false;
+    });
+    return removed;
+}
+
+template<typename Action, size_t WheelSize>
+bool CalendarQueue<Action, WheelSize>::inWindow(const size_t time) const {
+    return time >= current && time - current < WheelSize;
+}
+
+template<typename Action, size_t WheelSize>
+void CalendarQueue<Action, WheelSize>::refill() {
+    while (!overflow.empty() && inWindow(overflow.nextTime())) {
+        const Action action = overflow.top();
+        overflow.pop();
+        insert(action);
+    }
+}
+
+template<typename Action, size_t WheelSize>
+void CalendarQueue<Action, WheelSize>::insert(const Action& action) {
+    auto& location = locations[action.id];
+    if (!inWindow(action.time)) {
+        overflow.push(action);
+        location.bucket = inOverflow;
+        return;
+    }
+
+    auto& bucket = buckets[action.time & mask];
+    location = {action.time & mask, bucket.size()};
+    bucket.push_back(action);
+    wheelCount += 1;
+}
+}
+}
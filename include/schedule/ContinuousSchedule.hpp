@@ -0,0 +1,141 @@
+#pragma once
+
+#include <variant>
+#include <vector>
+
+#include "HeapQueue.hpp"
+#include "../utilities/Concepts.hpp"
+#include "../utilities/Random.hpp"
+
+namespace agh {
+namespace continuous {
+/**
+ * Putative firing time of a reaction channel.
+ */
+struct Reaction {
+    double time;
+    size_t order;
+    size_t id;
+
+    bool operator<(const Reaction& rhs) const {
+        return time < rhs.time || (time == rhs.time && order < rhs.order);
+    }
+};
+}
+
+/**
+ * Class template representing continuous-time stochastic schedule, implementing the next-reaction method of Gibson
+ * and Bruck. Every added agent is a reaction channel, which fires with the rate returned by its rate method, and
+ * firing executes its step method. Putative firing times of all channels are kept in an indexed binary heap. After a
+ * channel fires, only its own time and times of its declared dependents are updated, each in O(log n), and times of
+ * dependents are rescaled by the ratio of the old and the new rate instead of being sampled again.
+ * @tparam M Type of the object representing simulation state. It should meet requirements of SimState.
+ * @tparam Agents Types of the agents present in the simulation. They should meet requirements of Schedulable<M> and
+ * RateBased<M>.
+ */
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+class ContinuousSchedule {
+public:
+    /**
+     * Constructs schedule correlated with given model.
+     * @param pModel Reference to an object representing simulation state.
+     * @param pSeed Seed of the random streams used to sample firing times.
+     */
+    explicit ContinuousSchedule(M& pModel, const uint64_t pSeed = 0)
+        : model(pModel), seed(pSeed), random(pSeed, 0, 0) {}
+
+    /**
+     * Adds agent as a reaction channel. Its rate is evaluated immediately.
+     * @param agent Agent firing with the rate returned by its rate method.
+     * @return Id of the channel.
+     */
+    size_t add(auto& agent);
+
+    /**
+     * Declares that firing of one channel changes rate of another one. Firing channel always updates its own rate.
+     * @param from Id of the firing channel.
+     * @param to Id of the channel whose rate depends on the firing one.
+     */
+    void addDependency(size_t from, size_t to);
+
+    /**
+     * Evaluates rate of the channel again, e.g. after the model was changed outside of the schedule, and updates its
+     * firing time in O(log n).
+     * @param id Id of the channel.
+     */
+    void updateRate(size_t id);
+
+    /**
+     * Removes the channel from the schedule. Its id is not reused.
+     * @param id Id of the channel.
+     */
+    void remove(size_t id);
+
+    /**
+     * Fires the channel with the earliest putative time, advancing the time to it. Model's beforeStep and afterStep
+     * methods are called around the firing. Channels of inactive agents are removed instead of being fired.
+     * @return True if a channel was fired, false if all rates are zero.
+     */
+    bool step();
+
+    /**
+     * Calls step method, until model's shouldEnd method returns true or no channel can fire.
+     */
+    void execute();
+
+    /**
+     * Fires all channels with putative times not later than the given time, and advances the time to it.
+     * @param end Time up to which the simulation is run.
+     */
+    void executeUntil(double end);
+
+    /**
+     * Returns current simulation time.
+     * @return Time of the last firing.
+     */
+    [[nodiscard]] double getTime() const;
+
+    /**
+     * Returns number of fired channels since the beginning of the simulation.
+     * @return Number of steps.
+     */
+    [[nodiscard]] size_t getSteps() const;
+
+    /**
+     * Returns current rate of the channel.
+     * @param id Id of the channel.
+     * @return Rate evaluated at the last update of the channel.
+     */
+    [[nodiscard]] double getRate(size_t id) const;
+
+    /**
+     *
+     * @return Logical value indicating if simulation should continue.
+     */
+    [[nodiscard]] bool isActive() const;
+
+private:
+    struct Channel {
+        std::variant<Agents*...> agent;
+        double rate{};
+        std::vector<size_t> dependents;
+        bool used{true};
+    };
+
+    M& model;
+    double time{};
+    size_t steps{};
+    queue::HeapQueue<continuous::Reaction> reactions;
+    std::vector<Channel> channels;
+    uint64_t seed;
+    // Firing times are sampled from streams of consecutive epochs, and each one is replaced before it repeats.
+    uint64_t epoch{};
+    uint64_t drawn{};
+    RandomStream random;
+
+    void refresh(size_t id, bool fired);
+    [[nodiscard]] double exponential();
+};
+}
+
+#include "ContinuousScheduleImpl.hpp"
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace agh {
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+size_t ContinuousSchedule<M, Agents...>::add(auto& agent) {
+    const size_t id = channels.size();
+    channels.push_back(Channel{std::variant<Agents*...>(&agent), 0.0, {}, true});
+    refresh(id, true);
+    return id;
+}
+
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+void ContinuousSchedule<M, Agents...>::addDependency(const size_t from, const size_t to) {
+    if (from != to) {
+        channels[from].dependents.push_back(to);
+    }
+}
+
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+void ContinuousSchedule<M, Agents...>::updateRate(const size_t id) {
+    refresh(id, false);
+}
+
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+void ContinuousSchedule<M, Agents...>::remove(const size_t id) {
+    reactions.erase(id);
+    channels[id].used = false;
+    channels[id].rate = 0.;
+    channels[id].dependents.clear();
+}
+
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+bool ContinuousSchedule<M, Agents...>::step() {
+    while (!reactions.empty()) {
+        const size_t id = reactions.top().id;
+        const auto agent = channels[id].agent;
+        if (!std::visit([](auto a) { return a->isActive(); }, agent)) {
+            remove(id);
+            continue;
+        }
+
+        time = reactions.top().time;
+        model.beforeStep();
+        std::visit([&](auto a) { a->step(model); }, agent);
+        steps += 1;
+
+        refresh(id, true);
+        for (size_t i = 0; i < channels[id].dependents.size(); ++i) {
+            refresh(channels[id].dependents[i], false);
+        }
+        model.afterStep();
+        return true;
+    }
+    return false;
+}
+
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+void ContinuousSchedule<M, Agents...>::execute() {
+    while (isActive() && step()) {}
+}
+
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+void ContinuousSchedule<M, Agents...>::executeUntil(const double end) {
+    while (!reactions.empty() && reactions.nextTime() <= end && step()) {}
+    // Remaining putative times are absolute and later than the end, so they stay valid.
+    time = std::max(time, end);
+}
+
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+double ContinuousSchedule<M, Agents...>::getTime() const {
+    return time;
+}
+
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+size_t ContinuousSchedule<M, Agents...>::getSteps() const {
+    return steps;
+}
+
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+double ContinuousSchedule<M, Agents...>::getRate(const size_t id) const {
+    return channels[id].rate;
+}
+
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+bool ContinuousSchedule<M, Agents...>::isActive() const {
+    return !model.shouldEnd(steps);
+}
+
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+void ContinuousSchedule<M, Agents...>::refresh(const size_t id, const bool fired) {
+    Channel& channel = channels[id];
+    if (!channel.used) {
+        return;
+    }
+
+    const double old = channel.rate;
+    const double rate = std::visit([&](auto a) { return static_cast<double>(a->rate(model)); }, channel.agent);
+    channel.rate = rate;
+
+    const continuous::Reaction* reaction = reactions.find(id);
+    if (rate <= 0.) {
+        reactions.erase(id);
+        return;
+    }
+    if (!reaction) {
+        reactions.push({time + exponential() / rate, id, id});
+        return;
+    }
+
+    // Fired channel needs a new sample. Others keep theirs, rescaled to the new rate.
+    const double next = fired ? time + exponential() / rate : time + old / rate * (reaction->time - time);
+    reactions.update(id, next, id);
+}
+
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (RateBased<Agents, M> && ...))
+double ContinuousSchedule<M, Agents...>::exponential() {
+    // Every sample takes two values of the stream.
+    if (drawn == RandomStream::period) {
+        random = RandomStream(seed, 0, ++epoch);
+        drawn = 0;
+    }
+    drawn += 2;
+    return -std::log1p(-random.uniform());
+}
+}
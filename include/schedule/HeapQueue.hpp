@@ -0,0 +1,126 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+namespace agh {
+namespace queue {
+/**
+ * Queue of scheduled actions backed by an indexed binary heap. Every due action is popped from the heap, and every
+ * repeating action is pushed back into it, which costs O(log n) per action. Position of every action in the heap is
+ * tracked by its id, so any action can be removed or moved in O(log n).
+ * @tparam Action Type of the stored action. It must be ordered by (time, order) and have a unique id. Its time can be
+ * of any ordered type, e.g. size_t for time steps or double for continuous time.
+ */
+template<typename Action>
+class HeapQueue {
+public:
+    using Time = decltype(Action::time);
+
+    /**
+     * Checks if there is any action in the queue.
+     * @return True if queue is empty, false otherwise.
+     */
+    [[nodiscard]] bool empty() const { return heap.empty(); }
+
+    /**
+     * Returns number of actions stored in the queue.
+     * @return Number of stored actions.
+     */
+    [[nodiscard]] size_t size() const { return heap.size(); }
+
+    /**
+     * Returns time of the earliest action in the queue. Queue must not be empty.
+     * @return Time step of the earliest action.
+     */
+    [[nodiscard]] Time nextTime() const { return heap.front().time; }
+
+    /**
+     * Returns the earliest action in the queue. Queue must not be empty.
+     * @return Reference to the earliest action.
+     */
+    [[nodiscard]] const Action& top() const { return heap.front(); }
+
+    /**
+     * Inserts action into the queue. No other action with the same id can be present in the queue.
+     * @param action Action to insert.
+     */
+    void push(const Action& action);
+
+    /**
+     * Removes the earliest action from the queue. Queue must not be empty.
+     */
+    void pop();
+
+    /**
+     * Preallocates storage for the given number of actions.
+     * @param capacity Number of actions which can be stored without further allocations.
+     */
+    void reserve(size_t capacity);
+
+    /**
+     * Moves all actions scheduled not later than the given time to the end of the output vector, in (time, order)
+     * order.
+     * @param time Time step up to which actions are taken.
+     * @param out Vector to which taken actions are appended.
+     */
+    void popDue(Time time, std::vector<Action>& out);
+
+    /**
+     * Finds action with the given id.
+     * @param id Id of the action.
+     * @return Pointer to the found action, or nullptr if there is no such action in the queue. Time and order of the
+     * action must not be modified through it.
+     */
+    [[nodiscard]] Action* find(size_t id);
+
+    /**
+     * Removes action with the given id.
+     * @param id Id of the action.
+     * @return True if action was present in the queue, false otherwise.
+     */
+    bool erase(size_t id);
+
+    /**
+     * Changes time and order of the action with the given id.
+     * @param id Id of the action.
+     * @param time New time step of the action.
+     * @param order New order of the action.
+     * @return True if action was present in the queue, false otherwise.
+     */
+    bool update(size_t id, Time time, size_t order);
+
+    /**
+     * Removes all actions satisfying given predicate. It takes O(n) time.
+     * @tparam P Type of the predicate.
+     * @param pred Predicate invocable with a reference to an action. It may modify the action, except for its time,
+     * order and id.
+     * @return Number of removed actions.
+     */
+    template<typename P>
+    size_t eraseIf(P&& pred);
+
+private:
+    static constexpr size_t absent = std::numeric_limits<size_t>::max();
+
+    std::vector<Action> heap;
+    std::vector<size_t> positions;
+
+    void removeAt(size_t i);
+    void restore(size_t i);
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+    void place(size_t i, const Action& action);
+};
+}
+
+/**
+ * Schedule backend keeping actions in an indexed binary heap. It is the default backend of the Schedule.
+ */
+struct HeapBackend {
+    template<typename Action>
+    using Queue = queue::HeapQueue<Action>;
+};
+}
+
+#include "HeapQueueImpl.hpp"
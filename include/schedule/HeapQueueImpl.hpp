@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+
+namespace agh {
+namespace queue {
+template<typename Action>
+void HeapQueue<Action>::push(const Action& action) {
+    if (positions.size() <= action.id) {
+        positions.resize(action.id + 1, absent);
+    }
+    heap.push_back(action);
+    positions[action.id] = heap.size() - 1;
+    siftUp(heap.size() - 1);
+}
+
+template<typename Action>
+void HeapQueue<Action>::pop() {
+    removeAt(0);
+}
+
+template<typename Action>
+void HeapQueue<Action>::reserve(const size_t capacity) {
+    heap.reserve(capacity);
+    positions.reserve(capacity);
+}
+
+template<typename Action>
+void HeapQueue<Action>::popDue(const Time time, std::vector<Action>& out) {
+    while (!heap.empty() && heap.front().time <= time) {
+        out.push_back(heap.front());
+        removeAt(0);
+    }
+}
+
+template<typename Action>
+Action* HeapQueue<Action>::find(const size_t id) {
+    if (id >= positions.size() || positions[id] == absent) {
+        return nullptr;
+    }
+    return &heap[positions[id]];
+}
+
+template<typename Action>
+bool HeapQueue<Action>::erase(const size_t id) {
+    if (id >= positions.size() || positions[id] == absent) {
+        return false;
+    }
+    removeAt(positions[id]);
+    return true;
+}
+
+template<typename Action>
+bool HeapQueue<Action>::update(const size_t id, const Time time, const size_t order) {
+    Action* action = find(id);
+    if (!action) {
+        return false;
+    }
+    action->time = time;
+    action->order = order;
+    restore(positions[id]);
+    return true;
+}
+
+template<typename Action>
+template<typename P>
+size_t HeapQueue<Action>::eraseIf(P&& pred) {
+    const size_t removed = std::erase_if(heap, [&](Action& action) {
+        if (pred(action)) {
+            positions[action.id] = absent;
+            return true;
+        }
+        return false;
+    });
+
+    for (size_t i = 0; i < heap.size(); ++i) {
+        positions[heap[i].id] = i;
+    }
+    for (size_t i = heap.size() / 2; i-- > 0;) {
+        siftDown(i);
+    }
+    return removed;
+}
+
+template<typename Action>
+void HeapQueue<Action>::removeAt(const size_t i) {
+    positions[heap[i].id] = absent;
+    if (i + 1 == heap.size()) {
+        heap.pop_back();
+        return;
+    }
+
+    place(i, heap.back());
+    heap.pop_back();
+    restore(i);
+}
+
+template<typename Action>
+void HeapQueue<Action>::restore(const size_t i) {
+    if (i > 0 && heap[i] < heap[(i - 1) / 2]) {
+        siftUp(i);
+    }
+    else {
+        siftDown(i);
+    }
+}
+
+template<typename Action>
+void HeapQueue<Action>::siftUp(size_t i) {
+    const Action action = heap[i];
+    while (i > 0) {
+        const size_t parent = (i - 1) / 2;
+        if (!(action < heap[parent])) {
+            break;
+        }
+        place(i, heap[parent]);
+        i = parent;
+    }
+    place(i, action);
+}
+
+template<typename Action>
+void HeapQueue<Action>::siftDown(size_t i) {
+    const Action action = heap[i];
+    while (true) {
+        size_t child = 2 * i + 1;
+        if (child >= heap.size()) {
+            break;
+        }
+        if (child + 1 < heap.size() && heap[child + 1] < heap[child]) {
+            child += 1;
+        }
+        if (!(heap[child] < action)) {
+            break;
+        }
+        place(i, heap[child]);
+        i = child;
+    }
+    place(i, action);
+}
+
+template<typename Action>
+void HeapQueue<Action>::place(const size_t i, const Action& action) {
+    heap[i] = action;
+    positions[action.id] = i;
+}
+}
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <concepts>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace agh {
+namespace profiling {
+/**
+ * Phases of a single step of the schedule.
+ */
+enum class Phase : size_t {
+    BeforeStep,
+    Collect,
+    Step,
+    Advance,
+    Reschedule,
+    AfterStep,
+    Count
+};
+
+/**
+ * Returns human-readable name of the phase.
+ * @param phase Phase to name.
+ * @return Name of the phase.
+ */
+constexpr const char* phaseName(const Phase phase) {
+    constexpr std::array<const char*, static_cast<size_t>(Phase::Count)> names{
+        "beforeStep", "collect", "step", "advance", "reschedule", "afterStep"
+    };
+    return names[static_cast<size_t>(phase)];
+}
+
+/**
+ * Name of the agent type in profiler traces, taken from the static member profileName of the type, if present. Types
+ * which cannot be modified can be named by specializing this trait.
+ * @tparam T Agent type.
+ */
+template<typename T>
+struct TypeName {
+    static constexpr std::string_view value{};
+};
+
+template<typename T> requires requires { { T::profileName } -> std::convertible_to<std::string_view>; }
+struct TypeName<T> {
+    static constexpr std::string_view value{T::profileName};
+};
+
+/**
+ * Returns name of the agent type used in profiler traces. Types without a name given by TypeName are called
+ * "type <index>", after their position in the list of agent types of the schedule.
+ * @tparam T Agent type.
+ * @param index Index of the type in the schedule.
+ * @return Name of the type.
+ */
+template<typename T>
+std::string typeName(const size_t index) {
+    if constexpr (TypeName<T>::value.empty()) {
+        return "type " + std::to_string(index);
+    }
+    else {
+        return std::string(TypeName<T>::value);
+    }
+}
+
+/**
+ * Writes text as a JSON string literal, with quotes, backslashes and control characters escaped.
+ * @param out Stream to write to.
+ * @param text Written text.
+ */
+inline void writeJsonString(std::ostream& out, std::string_view text);
+
+/**
+ * Time interval measured relatively to the beginning of the epoch.
+ */
+struct Span {
+    std::chrono::nanoseconds offset{};
+    std::chrono::nanoseconds duration{};
+};
+
+/**
+ * Measurements of a single epoch.
+ * @tparam Types Number of agent types in the schedule.
+ */
+template<size_t Types>
+struct EpochRecord {
+    size_t epoch{};
+    size_t actions{};
+    std::chrono::steady_clock::time_point start{};
+    std::array<Span, static_cast<size_t>(Phase::Count)> phases{};
+    std::array<Span, Types> steps{};
+    std::array<Span, Types> advances{};
+};
+
+/**
+ * Profiler which measures nothing. It is used by schedules whose backend does not enable profiling, and all of its
+ * calls are optimized away.
+ */
+struct NullProfiler {
+    struct Mark {};
+
+    static Mark now() { return {}; }
+    static void beginEpoch(Mark) {}
+    static void record(Phase, Mark) {}
+    static void recordStep(size_t, Mark) {}
+    static void recordAdvance(size_t, Mark) {}
+    static void endEpoch(size_t, size_t) {}
+};
+
+/**
+ * Profiler recording wall time of every phase of the schedule's step, and time spent in step and advance by every
+ * agent type. Records of the most recent epochs are kept in a ring buffer, and totals are accumulated over the whole
+ * run.
+ * @tparam Types Number of agent types in the schedule.
+ */
+template<size_t Types>
+class PhaseProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Mark = Clock::time_point;
+    using Record = EpochRecord<Types>;
+
+    /**
+     * Creates profiler keeping records of the given number of the most recent epochs.
+     * @param capacity Size of the ring buffer.
+     * @param pTypeNames Names of the agent types, used in the trace.
+     */
+    explicit PhaseProfiler(size_t capacity = 1024, std::array<std::string, Types> pTypeNames = {})
+        : records(capacity), typeNames(std::move(pTypeNames)) {}
+
+    /**
+     * Returns current time.
+     * @return Current time point.
+     */
+    static Mark now() { return Clock::now(); }
+
+    /**
+     * Starts new epoch record.
+     * @param start Time at which epoch started.
+     */
+    void beginEpoch(Mark start);
+
+    /**
+     * Records phase which started at the given time and ends now.
+     * @param phase Measured phase.
+     * @param start Time at which phase started.
+     */
+    void record(Phase phase, Mark start);
+
+    /**
+     * Records execution of step by agents of the given type, which started at the given time and ends now. Multiple
+     * executions in one epoch are summed.
+     * @param type Index of the agent type in the schedule.
+     * @param start Time at which execution started.
+     */
+    void recordStep(size_t type, Mark start);
+
+    /**
+     * Records execution of advance by agents of the given type, which started at the given time and ends now.
+     * @param type Index of the agent type in the schedule.
+     * @param start Time at which execution started.
+     */
+    void recordAdvance(size_t type, Mark start);
+
+    /**
+     * Finishes current epoch record and stores it in the ring buffer.
+     * @param epoch Number of the epoch.
+     * @param actions Number of actions executed in the epoch.
+     */
+    void endEpoch(size_t epoch, size_t actions);
+
+    /**
+     * Returns number of records kept in the ring buffer.
+     * @return Number of recorded epochs, not greater than the capacity.
+     */
+    [[nodiscard]] size_t recordedEpochs() const { return count; }
+
+    /**
+     * Returns the i-th oldest record kept in the ring buffer.
+     * @param i Index of the record, lower than recordedEpochs().
+     * @return Reference to the record.
+     */
+    [[nodiscard]] const Record& epoch(size_t i) const;
+
+    /**
+     * Returns total time spent in the given phase since the profiler was created or reset.
+     * @param phase Phase of the step.
+     * @return Total duration.
+     */
+    [[nodiscard]] std::chrono::nanoseconds total(Phase phase) const { return phaseTotals[static_cast<size_t>(phase)]; }
+
+    /**
+     * Returns total time spent in step by agents of the given type.
+     * @param type Index of the agent type in the schedule.
+     * @return Total duration.
+     */
+    [[nodiscard]] std::chrono::nanoseconds totalStep(size_t type) const { return stepTotals[type]; }
+
+    /**
+     * Returns total time spent in advance by agents of the given type.
+     * @param type Index of the agent type in the schedule.
+     * @return Total duration.
+     */
+    [[nodiscard]] std::chrono::nanoseconds totalAdvance(size_t type) const { return advanceTotals[type]; }
+
+    /**
+     * Changes number of the most recent epochs kept in the ring buffer. Already kept records are removed.
+     * @param capacity Size of the ring buffer.
+     */
+    void setCapacity(size_t capacity);
+
+    /**
+     * Removes all records and clears totals.
+     */
+    void reset();
+
+    /**
+     * Writes records kept in the ring buffer in the Chrome trace event format, which can be opened in chrome://tracing
+     * or Perfetto. Phases are placed on the first track, and agent types on the second one.
+     * @param out Stream to write to.
+     */
+    void writeChromeTrace(std::ostream& out) const;
+
+private:
+    std::vector<Record> records;
+    size_t head{};
+    size_t count{};
+    Record current{};
+    std::array<std::chrono::nanoseconds, static_cast<size_t>(Phase::Count)> phaseTotals{};
+    std::array<std::chrono::nanoseconds, Types> stepTotals{};
+    std::array<std::chrono::nanoseconds, Types> advanceTotals{};
+    std::array<std::string, Types> typeNames;
+
+    void accumulate(Span& span, Mark start, std::chrono::nanoseconds& total);
+};
+}
+
+/**
+ * Schedule backend adaptor enabling the phase profiler. Without it, profiling code is not compiled at all.
+ * @tparam Backend Backend storing the actions, e.g. HeapBackend or CalendarBackend.
+ */
+template<typename Backend>
+struct Profiled : Backend {
+    static constexpr bool profiling = true;
+};
+
+template<typename B>
+concept ProfilingBackend = requires {
+    requires B::profiling;
+};
+}
+
+#include "ProfilerImpl.hpp"
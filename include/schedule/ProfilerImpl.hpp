@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+
+namespace agh {
+namespace profiling {
+inline void writeJsonString(std::ostream& out, const std::string_view text) {
+    out << '"';
+    for (const char c : text) {
+        switch (c) {
+        case '"':
+            out << R"(\")";
+            break;
+        case '\\':
+            out << R"(\\)";
+            break;
+        case '\n':
+            out << R"(\n)";
+            break;
+        case '\t':
+            out << R"(\t)";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[7];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                out << escaped;
+            }
+            else {
+                out << c;
+            }
+        }
+    }
+    out << '"';
+}
+
+template<size_t Types>
+void PhaseProfiler<Types>::beginEpoch(const Mark start) {
+    current = Record{};
+    current.start = start;
+}
+
+template<size_t Types>
+void PhaseProfiler<Types>::record(const Phase phase, const Mark start) {
+    const auto i = static_cast<size_t>(phase);
+    accumulate(current.phases[i], start, phaseTotals[i]);
+}
+
+template<size_t Types>
+void PhaseProfiler<Types>::recordStep(const size_t type, const Mark start) {
+    accumulate(current.steps[type], start, stepTotals[type]);
+}
+
+template<size_t Types>
+void PhaseProfiler<Types>::recordAdvance(const size_t type, const Mark start) {
+    accumulate(current.advances[type], start, advanceTotals[type]);
+}
+
+template<size_t Types>
+void PhaseProfiler<Types>::endEpoch(const size_t epoch, const size_t actions) {
+    if (records.empty()) {
+        return;
+    }
+
+    current.epoch = epoch;
+    current.actions = actions;
+    records[head] = current;
+    head = (head + 1) % records.size();
+    count = std::min(count + 1, records.size());
+}
+
+template<size_t Types>
+const typename PhaseProfiler<Types>::Record& PhaseProfiler<Types>::epoch(const size_t i) const {
+    return records[(head + records.size() - count + i) % records.size()];
+}
+
+template<size_t Types>
+void PhaseProfiler<Types>::setCapacity(const size_t capacity) {
+    records.assign(capacity, Record{});
+    head = 0;
+    count = 0;
+}
+
+template<size_t Types>
+void PhaseProfiler<Types>::reset() {
+    head = 0;
+    count = 0;
+    phaseTotals = {};
+    stepTotals = {};
+    advanceTotals = {};
+}
+
+template<size_t Types>
+void PhaseProfiler<Types>::writeChromeTrace(std::ostream& out) const {
+    out << R"({"displayTimeUnit":"ns","traceEvents":[)";
+    if (count == 0) {
+        out << "]}\n";
+        return;
+    }
+
+    const auto origin = epoch(0).start;
+    bool first = true;
+    const auto event = [&](const char* category, const std::string_view name, const size_t track,
+                           const Record& record, const Span& span) {
+        const auto start = record.start - origin + span.offset;
+        out << (first ? "\n" : ",\n");
+        out << R"({"name":)";
+        writeJsonString(out, name);
+        out << R"(,"cat":")" << category << R"(","ph":"X","pid":0,"tid":)" << track
+            << R"(,"ts":)" << static_cast<double>(start.count()) / 1000.0
+            << R"(,"dur":)" << static_cast<double>(span.duration.count()) / 1000.0
+            << R"(,"args":{"epoch":)" << record.epoch << R"(,"actions":)" << record.actions << "}}";
+        first = false;
+    };
+
+    for (size_t i = 0; i < count; ++i) {
+        const Record& record = epoch(i);
+        for (size_t p = 0; p < record.phases.size(); ++p) {
+            event("phase", phaseName(static_cast<Phase>(p)), 0, record, record.phases[p]);
+        }
+        for (size_t t = 0; t < Types; ++t) {
+            if (record.steps[t].duration.count() > 0) {
+                event("step", typeNames[t], 1, record, record.steps[t]);
+            }
+            if (record.advances[t].duration.count() > 0) {
+                event("advance", typeNames[t], 1, record, record.advances[t]);
+            }
+        }
+    }
+    out << "\n]}\n";
+}
+
+template<size_t Types>
+void PhaseProfiler<Types>::accumulate(Span& span, const Mark start, std::chrono::nanoseconds& total) {
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(now() - start);
+    if (span.duration.count() == 0) {
+        span.offset = std::chrono::duration_cast<std::chrono::nanoseconds>(start - current.start);
+    }
+    span.duration += duration;
+    total += duration;
+}
+}
+}
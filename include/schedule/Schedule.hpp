@@ -1,9 +1,24 @@
 #pragma once
 
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <tuple>
+#include <utility>
 #include <variant>
-#include <queue>
+#include <vector>
 
+#include "Behavior.hpp"
+#include "CalendarQueue.hpp"
+#include "HeapQueue.hpp"
+#include "Profiler.hpp"
+#include "../model/AgentHandle.hpp"
+#include "../model/CommandBuffer.hpp"
 #include "../utilities/Concepts.hpp"
+#include "../utilities/Random.hpp"
+#include "../utilities/ThreadPool.hpp"
 
 namespace agh {
 namespace action {
@@ -27,10 +42,15 @@ struct Action {
         return std::visit([](auto agent) { return agent->isActive(); }, agent);
     }
 
+    [[nodiscard]] bool isActive(M&) const {
+        return isActive();
+    }
+
     size_t time;
     size_t order;
     size_t interval;
     std::variant<Agents*...> agent;
+    size_t id{};
 
     auto operator<=>(const Action& rhs) const {
         if (auto relation = time <=> rhs.time; relation != 0) {
@@ -39,47 +59,314 @@ struct Action {
         return order <=> rhs.order;
     }
 };
+
+/**
+ * Action referring to its agent by generational handle issued by the model. Action of a removed agent is treated as
+ * inactive, instead of referring to the removed agent or to the agent which took its slot.
+ */
+template<typename M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0 && (AgentResolver<M, Agents> && ...))
+struct HandleAction {
+    HandleAction(const AgentHandle pAgent, const size_t pTime, const size_t pPriority, const size_t pInterval = 0)
+        : time(pTime), order(pPriority), interval(pInterval), agent(pAgent) {}
+
+    void step(M& model) {
+        visit(model, [&](auto pAgent) { pAgent->step(model); });
+    }
+
+    void advance(M& model) requires (Advanceable<Agents, M> && ...) {
+        visit(model, [&](auto pAgent) { pAgent->advance(model); });
+    }
+
+    [[nodiscard]] bool isActive(M& model) const {
+        bool active = false;
+        visit(model, [&](auto pAgent) { active = pAgent->isActive(); });
+        return active;
+    }
+
+    /**
+     * Calls f with pointer to the agent, if it is still present in the model. The pointer is of the type returned by
+     * the model, e.g. SoaReference for agents stored as structure of arrays.
+     * @return True if f was called, false if the handle is stale.
+     */
+    template<typename F>
+    bool visit(M& model, F&& f) const {
+        return ([&] {
+            if (auto pAgent = model.template get<Agents>(agent)) {
+                f(pAgent);
+                return true;
+            }
+            return false;
+        }() || ...);
+    }
+
+    size_t time;
+    size_t order;
+    size_t interval;
+    AgentHandle agent;
+    size_t id{};
+
+    auto operator<=>(const HandleAction& rhs) const {
+        if (auto relation = time <=> rhs.time; relation != 0) {
+            return relation;
+        }
+        return order <=> rhs.order;
+    }
+};
+
+/**
+ * Type by which the schedule passes agents of type T to their step and stepBatch: T* if actions store pointers, or
+ * the type returned by the model when resolving handles, e.g. SoaReference<T>.
+ */
+template<typename M, typename T, bool Handles>
+struct PointerOf {
+    using type = T*;
+};
+
+template<typename M, typename T>
+struct PointerOf<M, T, true> {
+    using type = decltype(std::declval<M&>().template get<T>(std::declval<AgentHandle>()));
+};
 }
 
+/**
+ * Wrapper of a schedule backend, which makes the schedule store generational handles of agents instead of pointers.
+ * Actions are smaller, and removing an agent from the model while its actions are scheduled is safe, since they are
+ * dropped as inactive. The model must issue handles, e.g. derive from Model. Agents stored as structure of arrays have
+ * no stable address, so they can be scheduled only with this backend.
+ * @tparam Backend Wrapped backend.
+ */
+template<typename Backend>
+struct ByHandle : Backend {
+    static constexpr bool handles = true;
+};
+
+template<typename B>
+concept HandleBackend = requires {
+    requires B::handles;
+};
+
+/**
+ * Lightweight reference to an action scheduled in the schedule. It stays valid until the action is cancelled, or it is
+ * executed and not repeated anymore. Operations on an invalid handle have no effect. Handle refers to the schedule
+ * object which issued it, so it must not outlive that schedule.
+ * @tparam S Type of the schedule which issued the handle.
+ */
+template<typename S>
+class ActionHandle {
+public:
+    /**
+     * Creates handle which does not refer to any action.
+     */
+    ActionHandle() = default;
+
+    /**
+     * Removes the action from the schedule. If it is due in the current time step, but its order group hasn't been
+     * executed yet, it won't be executed. If it is being executed, it won't be rescheduled.
+     * @return True if the action was scheduled, false otherwise.
+     */
+    bool cancel() { return schedule && schedule->cancel(*this); }
+
+    /**
+     * Moves the action to another time step and order.
+     * @param time New time step of the action.
+     * @param order New order value of the action.
+     * @return True if the action was scheduled, false otherwise.
+     */
+    bool reschedule(size_t time, size_t order) { return schedule && schedule->reschedule(*this, time, order); }
+
+    /**
+     * Changes the number of steps after which the action is repeated. Zero means that it won't be repeated.
+     * @param interval New interval of the action.
+     * @return True if the action was scheduled, false otherwise.
+     */
+    bool changeInterval(size_t interval) { return schedule && schedule->changeInterval(*this, interval); }
+
+    /**
+     * Checks if the action is still scheduled.
+     * @return True if the handle refers to a scheduled action, false otherwise.
+     */
+    [[nodiscard]] bool isScheduled() const { return schedule && schedule->isScheduled(*this); }
+
+private:
+    friend S;
+
+    ActionHandle(S* pSchedule, const uint32_t pId, const uint32_t pGeneration)
+        : schedule(pSchedule), id(pId), generation(pGeneration) {}
+
+    S* schedule{};
+    uint32_t id{};
+    uint32_t generation{};
+};
+
 /**
  * Class template representing schedule for the simulation, where state is represented by object of class M, and
- * simulation's agents types are in Agents. It is responsible for running simulation and scheduling events.
+ * simulation's agents types are in Agents. It is responsible for running simulation and scheduling events. Due actions
+ * sharing the same order are grouped by agent type, and every group is dispatched without visiting the variant. Agent
+ * types meeting BatchSchedulable requirements receive the whole group in a single stepBatch call. Buffers used by step
+ * are kept between epochs, so once they have grown to fit the model, stepping does not allocate memory. Besides
+ * actions, the schedule runs coroutine behaviors, whose wake-ups are kept in a separate queue of the same backend and
+ * which are resumed only when due.
+ * @tparam Backend Type describing how the scheduled actions are stored, e.g. HeapBackend or CalendarBackend. It may be
+ * wrapped in ByHandle to refer to agents by their handles.
  * @tparam M Type of the object representing simulation state. It should meet requirements of SimState.
  * @tparam Agents Types of the agents present in the simulation. They should meet requirements of Schedulable<M>
  */
-template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
-class Schedule {
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+class BasicSchedule {
 public:
-    using ActionItem = action::Action<M, Agents...>;
+    using ActionItem = std::conditional_t<HandleBackend<Backend>, action::HandleAction<M, Agents...>,
+                                          action::Action<M, Agents...>>;
+    using QueueT = typename Backend::template Queue<ActionItem>;
+    using Handle = ActionHandle<BasicSchedule>;
+    using ProfilerT = std::conditional_t<ProfilingBackend<Backend>, profiling::PhaseProfiler<sizeof...(Agents)>,
+                                         profiling::NullProfiler>;
+
+    /**
+     * Type by which agents of type T are passed to stepBatch, i.e. T*, or SoaReference<T> for agents stored as
+     * structure of arrays in a schedule referring to agents by handles.
+     */
+    template<typename T>
+    using AgentPointer = typename action::PointerOf<M, T, HandleBackend<Backend>>::type;
+
     /**
      * Constructs Schedule correlated with given model.
      * @param pModel Reference to an object representing simulation state.
      */
-    explicit Schedule(M& pModel) : model(pModel), epochs(0) {}
+    explicit BasicSchedule(M& pModel) : model(pModel), epochs(0) {}
 
     /**
      * Schedules agent's action only once. It will be executed in specified time. If two agents are scheduled for the
      * same step, one with the lower order will be executed first.
-     * @param agent Agent whose action will be executed.
+     * @param agent Agent whose action will be executed, or proxy reference to it, like SoaReference.
      * @param time Time step in which action will be executed.
      * @param order Order value. The lower, the better.
+     * @return Handle to the scheduled action.
      */
-    void scheduleOnce(auto& agent, size_t time, size_t order);
+    Handle scheduleOnce(auto&& agent, size_t time, size_t order);
 
     /**
      * Schedules agent's action which will be repeated every specified number of steps, beginning from the specified
      * time. If two agents are scheduled for the same step, one with the lower order will be executed first.
-     * @param agent Agent to schedule.
+     * @param agent Agent to schedule, or proxy reference to it, like SoaReference.
      * @param time Time step at which agent's action should be invoked.
      * @param order Order value. The lower, the better.
      * @param interval Number of iterations after which action should be invoked again. Default value is one.
+     * @return Handle to the scheduled action.
+     */
+    Handle scheduleRepeating(auto&& agent, size_t time, size_t order, size_t interval = 1);
+
+    /**
+     * Starts the behavior at the given time step. Between its stages, the behavior awaits delays returned by the delay
+     * method, and it is resumed only when due, after actions with the same order. Behaviors are always resumed by the
+     * thread calling step, one after another. The schedule owns the behavior until it returns. If the behavior throws,
+     * it is finished and the first such exception is rethrown by step, after the step has been completed.
+     * @param behavior Coroutine to run.
+     * @param time Time step in which the behavior is started.
+     * @param order Order value. The lower, the better.
+     */
+    void spawn(Behavior behavior, size_t time, size_t order);
+
+    /**
+     * Returns awaitable suspending the behavior for the given number of steps. The behavior keeps its order.
+     * @param steps Number of steps to wait. Zero is treated as one.
+     * @return Delay to be awaited by the behavior.
      */
-    void scheduleRepeating(auto& agent, size_t time, size_t order, size_t interval = 1);
+    [[nodiscard]] Delay delay(size_t steps) const;
+
+    /**
+     * Returns awaitable suspending the behavior for the given number of steps, after which it is resumed with the
+     * given order.
+     * @param steps Number of steps to wait. Zero is treated as one.
+     * @param order New order value of the behavior.
+     * @return Delay to be awaited by the behavior.
+     */
+    [[nodiscard]] Delay delay(size_t steps, size_t order) const;
+
+    /**
+     * Returns number of behaviors waiting in the schedule.
+     * @return Number of suspended behaviors.
+     */
+    [[nodiscard]] size_t behaviorCount() const;
+
+    /**
+     * Removes the action from the schedule in O(log n) time. If the action is due in the current time step, but its
+     * order group hasn't been executed yet, it won't be executed. If it is being executed, it won't be rescheduled.
+     * @param handle Handle to the action.
+     * @return True if the action was scheduled, false otherwise.
+     */
+    bool cancel(Handle handle);
+
+    /**
+     * Moves the action to another time step and order in O(log n) time. If the action is due in the current time step,
+     * but its order group hasn't been executed yet, it is executed only at the given time. If it is being executed, it
+     * will be scheduled at the given time instead of being repeated after its interval.
+     * @param handle Handle to the action.
+     * @param time New time step of the action.
+     * @param order New order value of the action.
+     * @return True if the action was scheduled, false otherwise.
+     */
+    bool reschedule(Handle handle, size_t time, size_t order);
+
+    /**
+     * Changes the number of steps after which the action is repeated. Zero means that it won't be repeated.
+     * @param handle Handle to the action.
+     * @param interval New interval of the action.
+     * @return True if the action was scheduled, false otherwise.
+     */
+    bool changeInterval(Handle handle, size_t interval);
+
+    /**
+     * Checks if the action is still scheduled.
+     * @param handle Handle to the action.
+     * @return True if the handle refers to a scheduled action, false otherwise.
+     */
+    [[nodiscard]] bool isScheduled(Handle handle) const;
+
+    /**
+     * Returns number of actions waiting in the schedule, including those of inactive agents which were not removed yet.
+     * @return Number of stored actions.
+     */
+    [[nodiscard]] size_t actionCount() const;
+
+    /**
+     * Preallocates storage for the given number of simultaneously scheduled actions, so that the schedule doesn't
+     * allocate memory until their count is exceeded.
+     * @param capacity Expected number of scheduled actions.
+     */
+    void reserve(size_t capacity);
+
+    /**
+     * Removes actions of all inactive agents from the schedule. It is called automatically when the number of stored
+     * actions grows by the compaction threshold since the last compaction.
+     */
+    void compact();
+
+    /**
+     * Updates references to the agents moved by Model::compact and removes actions of the agents which were removed
+     * from the model, e.g. killed by deferred commands. It is called by the model the schedule is attached to, and it
+     * must not be called during the step or advance phase. Actions of the current time step whose agents were removed
+     * are not rescheduled. Behaviors are not updated, so they must not keep references to the agents across
+     * compaction.
+     * @tparam R Type of the relocation table.
+     * @param relocations Table of the moved and removed agents.
+     */
+    template<typename R>
+    void relocate(const R& relocations);
+
+    /**
+     * Sets growth of the stored actions count, relative to the count after the last compaction, at which actions of
+     * inactive agents are removed. Default value is one, i.e. compaction runs whenever the count doubles.
+     * @param threshold Positive growth factor.
+     */
+    void setCompactionThreshold(double threshold);
 
     /**
      * Executes one step of the simulation. It consists of calling beforeStep method of the model, executing step
      * method for every agent scheduled for that time step, potentially calling advance method for mentioned agents and
-     * finally, calling afterStep on the model.
+     * finally, calling afterStep on the model. If the model meets EpochAware requirements, its setEpoch method is
+     * called with the current time step before agents are executed, e.g. to key random streams. If the model defers
+     * commands, e.g. it derives from Model, they are flushed after the advance phase, ordered by the position of the
+     * agent which recorded them in the execution order, regardless of the number of threads.
      */
     void step();
 
@@ -101,11 +388,180 @@ public:
      */
     [[nodiscard]] bool isActive() const;
 
+    /**
+     * Sets number of threads used to execute agents' actions in parallel phases, starting a pool owned by the schedule.
+     * Value 1 (default) means that all actions are executed by the thread calling step. Prefer setThreadPool with the
+     * pool of the model, so that the schedule doesn't start another set of threads.
+     * @param threads Number of threads, including the calling one.
+     */
+    void setThreads(size_t threads);
+
+    /**
+     * Sets the thread pool executing agents' actions in parallel phases, e.g. the pool of the model returned by
+     * Model::threadPool, so that the schedule, the model and the spaces share one set of threads. The pool is not
+     * owned, and it must outlive the parallel steps. It replaces the pool started by setThreads. Null pointer
+     * (default) means that all actions are executed by the thread calling step.
+     * @param pPool Pool running the actions, or nullptr.
+     */
+    void setThreadPool(ThreadPool* pPool);
+
+    /**
+     * Enables or disables parallel execution of agents' step methods. Actions scheduled for the same time step with
+     * the same order are then executed concurrently, and actions with a higher order start only after all actions with
+     * a lower order have finished. Agents sharing an order value must not depend on each other. Agent types meeting
+     * BatchSchedulable requirements receive their group in parts of at most grain agents.
+     * @param parallel Should step methods be executed in parallel.
+     * @param grain Number of consecutive actions executed by one thread at a time.
+     */
+    void setParallelStep(bool parallel, size_t grain = 64);
+
+    /**
+     * Enables or disables parallel execution of agents' advance methods. Since advance only commits the state computed
+     * in step, all due actions are dispatched together, in chunks of the given size, regardless of their order. It has
+     * an effect only if every agent type meets Advanceable requirements.
+     * @param parallel Should advance methods be executed in parallel.
+     * @param grain Number of consecutive actions executed by one thread at a time.
+     */
+    void setParallelAdvance(bool parallel, size_t grain = 1024);
+
+    /**
+     * Enables or disables random activation. Actions scheduled for the same time step with the same order are then
+     * executed in a random order, instead of the order in which they were taken from the queue. Permutation of every
+     * group depends only on the seed, its time step and its order, so it is reproducible. In serial mode, agents of
+     * different types sharing a group are interleaved as well, so they are stepped one by one instead of in batches.
+     * @param random Should actions in a group be executed in a random order.
+     * @param seed Seed of the permutations.
+     */
+    void setRandomActivation(bool random, uint64_t seed = 0);
+
+    /**
+     * Returns profiler recording duration of every phase of the step. It is available only if the backend is wrapped
+     * in Profiled. Agent types are indexed in the order they are listed in the schedule's template arguments.
+     * @return Reference to the profiler.
+     */
+    [[nodiscard]] ProfilerT& getProfiler() requires ProfilingBackend<Backend> { return profiler; }
+
+    /**
+     * Returns profiler recording duration of every phase of the step. It is available only if the backend is wrapped
+     * in Profiled.
+     * @return Constant reference to the profiler.
+     */
+    [[nodiscard]] const ProfilerT& getProfiler() const requires ProfilingBackend<Backend> { return profiler; }
+
 private:
+    // Actions taken from the queue for the current time step are running until they are rescheduled. Those cancelled
+    // or moved before their order group is gathered are skipped, and moved ones keep their new time and order here, so
+    // the order groups of the current time step don't change.
+    struct Slot {
+        uint32_t generation{};
+        bool used{};
+        bool running{};
+        bool cancelled{};
+        bool rescheduled{};
+        bool skipped{};
+        size_t event{};
+        size_t time{};
+        size_t order{};
+    };
+
+    struct Timer {
+        size_t time;
+        size_t order;
+        size_t id;
+
+        auto operator<=>(const Timer& rhs) const {
+            if (auto relation = time <=> rhs.time; relation != 0) {
+                return relation;
+            }
+            return order <=> rhs.order;
+        }
+    };
+
+    static constexpr size_t minCompactionBase = 1024;
+
     M& model;
     size_t epochs;
-    std::priority_queue<ActionItem, std::vector<ActionItem>, std::greater<ActionItem>> actions;
+    QueueT actions;
+    std::vector<ActionItem> events;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    double compactionThreshold{1.};
+    size_t compactionBase{minCompactionBase};
+    std::unique_ptr<ThreadPool> ownedPool;
+    ThreadPool* pool{};
+    bool parallelStep{false};
+    size_t stepGrain{64};
+    bool parallelAdvance{false};
+    size_t advanceGrain{1024};
+    bool randomActivation{false};
+    Random activationRandom;
+
+    std::tuple<std::vector<AgentPointer<Agents>>...> batches;
+    std::vector<Behavior> behaviors;
+    std::vector<size_t> freeBehaviors;
+    typename Backend::template Queue<Timer> timers;
+    std::vector<Timer> resumptions;
+    // First exception thrown by a behavior in the current step, rethrown once the step is rescheduled.
+    std::exception_ptr behaviorError;
+    [[no_unique_address]] ProfilerT profiler{makeProfiler()};
+
+    template<typename T>
+    static constexpr size_t typeIndex();
+    [[nodiscard]] size_t typeOf(const ActionItem& action) const;
+    static ProfilerT makeProfiler();
+
+    Handle enqueue(ActionItem action);
+    void release(size_t id);
+    [[nodiscard]] const Slot* resolve(Handle handle) const;
+    void reschedulePhase();
+    void shuffleGroups();
+
+    void stepPhase();
+    void resumeBehaviors(size_t& next, size_t bound);
+    void afterStep();
+    void flushCommands();
+    uint64_t commandKey();
+    void advancePhase() requires (Advanceable<Agents, M> && ...);
+
+    void skipRemoved(size_t begin, size_t end);
+    void gather(size_t begin, size_t end);
+
+    template<size_t... I>
+    void gatherOne(const ActionItem& action, std::index_sequence<I...>);
+
+    auto referenceOf(auto&& agent) const;
+
+    template<typename T>
+    void stepBatch(bool parallel);
+
+    template<typename T>
+    void advanceBatch(bool parallel);
 };
+
+/**
+ * Schedule storing actions in a binary heap.
+ */
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+using Schedule = BasicSchedule<HeapBackend, M, Agents...>;
+
+/**
+ * Schedule storing actions in a time wheel. Ordering guarantees are the same as for Schedule, but repeating actions
+ * are rescheduled in constant time.
+ */
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+using CalendarSchedule = BasicSchedule<CalendarBackend<>, M, Agents...>;
+
+/**
+ * Schedule storing actions in a binary heap, which records duration of every phase of the step.
+ */
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+using ProfiledSchedule = BasicSchedule<Profiled<HeapBackend>, M, Agents...>;
+
+/**
+ * Schedule storing actions in a binary heap, which refers to agents by their generational handles.
+ */
+template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+using HandleSchedule = BasicSchedule<ByHandle<HeapBackend>, M, Agents...>;
 }
 
 #include "ScheduleImpl.hpp"
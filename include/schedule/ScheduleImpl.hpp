@@ -1,85 +1,629 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <limits>
+#include <string>
+#include <type_traits>
 
 namespace agh {
-template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
-void Schedule<M, Agents...>::scheduleOnce(auto& agent, const size_t time, const size_t order) {
-    actions.emplace(agent, time, order);
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+auto BasicSchedule<Backend, M, Agents...>::scheduleOnce(auto&& agent, const size_t time, const size_t order) -> Handle {
+    return enqueue(ActionItem(referenceOf(agent), time, order));
 }
 
-template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
-void Schedule<M, Agents...>::scheduleRepeating(auto& agent, const size_t time, const size_t order,
-                                               const size_t interval) {
-    actions.emplace(agent, time, order, interval);
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+auto BasicSchedule<Backend, M, Agents...>::scheduleRepeating(auto&& agent, const size_t time, const size_t order,
+                                                             const size_t interval) -> Handle {
+    return enqueue(ActionItem(referenceOf(agent), time, order, interval));
 }
 
-template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
-void Schedule<M, Agents...>::step() {
-    model.beforeStep();
-    if (actions.empty()) {
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::step() {
+    using profiling::Phase;
+
+    auto start = profiler.now();
+    profiler.beginEpoch(start);
+    {
+        CommandKey::Scope scope(commandKey());
+        model.beforeStep();
+    }
+    flushCommands();
+    profiler.record(Phase::BeforeStep, start);
+
+    if (actions.empty() && timers.empty()) {
         epochs += 1;
-        model.afterStep();
+        if constexpr (EpochAware<M>) {
+            model.setEpoch(epochs);
+        }
+        start = profiler.now();
+        afterStep();
+        profiler.record(Phase::AfterStep, start);
+        profiler.endEpoch(epochs, 0);
         return;
     }
 
-    epochs = actions.top().time;
+    start = profiler.now();
+    if (actions.empty()) {
+        epochs = timers.nextTime();
+    }
+    else {
+        epochs = timers.empty() ? actions.nextTime() : std::min(actions.nextTime(), timers.nextTime());
+    }
+    if constexpr (EpochAware<M>) {
+        model.setEpoch(epochs);
+    }
 
-    std::vector<ActionItem> events;
-    events.reserve(actions.size());
-    while (true) {
-        if (actions.empty()) {
-            break;
+    events.clear();
+    actions.popDue(epochs, events);
+    size_t kept = 0;
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (!events[i].isActive(model)) {
+            release(events[i].id);
+            continue;
         }
+        events[kept] = events[i];
+        ++kept;
+    }
+    events.erase(events.begin() + static_cast<std::ptrdiff_t>(kept), events.end());
+    if (randomActivation) {
+        shuffleGroups();
+    }
+    for (size_t i = 0; i < events.size(); ++i) {
+        slots[events[i].id].running = true;
+        slots[events[i].id].event = i;
+    }
 
-        if (actions.top().time > epochs) {
-            break;
-        }
+    resumptions.clear();
+    timers.popDue(epochs, resumptions);
+    profiler.record(Phase::Collect, start);
+
+    start = profiler.now();
+    stepPhase();
+    profiler.record(Phase::Step, start);
 
-        if (!actions.top().isActive()) {
-            actions.pop();
+    if constexpr ((Advanceable<Agents, M> && ...)) {
+        start = profiler.now();
+        advancePhase();
+        profiler.record(Phase::Advance, start);
+    }
+
+    start = profiler.now();
+    flushCommands();
+    reschedulePhase();
+    profiler.record(Phase::Reschedule, start);
+    if (behaviorError) {
+        // Failed behaviors are already freed and the remaining actions rescheduled, so the schedule stays usable.
+        std::rethrow_exception(std::exchange(behaviorError, {}));
+    }
+
+    start = profiler.now();
+    afterStep();
+    profiler.record(Phase::AfterStep, start);
+    profiler.endEpoch(epochs, events.size());
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::reschedulePhase() {
+    for (auto& resumption : resumptions) {
+        Behavior& behavior = behaviors[resumption.id];
+        if (behavior.done()) {
+            behavior = Behavior();
+            freeBehaviors.push_back(resumption.id);
             continue;
         }
-
-        events.push_back(actions.top());
-        actions.pop();
+        resumption.time = behavior.promise().time;
+        resumption.order = behavior.promise().order;
+        timers.push(resumption);
     }
+    resumptions.clear();
 
     for (auto& event : events) {
-        event.step(model);
+        Slot& slot = slots[event.id];
+        slot.running = false;
+        if (slot.cancelled || !event.isActive(model)) {
+            release(event.id);
+        }
+        else if (slot.rescheduled) {
+            slot.rescheduled = false;
+            slot.skipped = false;
+            event.time = slot.time;
+            event.order = slot.order;
+            actions.push(event);
+        }
+        else if (event.interval) {
+            event.time = epochs + event.interval;
+            actions.push(event);
+        }
+        else {
+            release(event.id);
+        }
     }
+}
 
-    if constexpr ((Advanceable<Agents, M> && ...)) {
-        for (auto& event : events) {
-            event.advance(model);
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::shuffleGroups() {
+    // Every group is shuffled with its own stream, so the permutation doesn't depend on the other groups.
+    for (size_t begin = 0; begin < events.size();) {
+        size_t end = begin + 1;
+        while (end < events.size() && events[end].time == events[begin].time &&
+               events[end].order == events[begin].order) {
+            ++end;
         }
+
+        auto stream = activationRandom.stream(events[begin].order, events[begin].time);
+        for (size_t i = end - begin; i > 1; --i) {
+            const size_t j = stream.below(static_cast<uint32_t>(i));
+            std::swap(events[begin + i - 1], events[begin + j]);
+        }
+        begin = end;
     }
+}
 
-    for (auto& event : events) {
-        std::visit([&](auto agent) {
-            if (agent->isActive() && event.interval) {
-                scheduleRepeating(event.agent, epochs + event.interval, event.order, event.interval);
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::stepPhase() {
+    const bool parallel = parallelStep && pool;
+    bool interleave = false;
+    if constexpr (sizeof...(Agents) > 1) {
+        // Batches would group agents by type, which defeats interleaving them randomly.
+        interleave = randomActivation && !parallel;
+    }
+
+    // Events are sorted by order, so every group of equal orders is a contiguous range. In parallel mode, returning
+    // from parallelFor is the barrier between groups. Due behaviors are sorted by order as well, and they are resumed
+    // between the groups.
+    size_t resumed = 0;
+    for (size_t begin = 0; begin < events.size();) {
+        size_t end = begin + 1;
+        while (end < events.size() && events[end].order == events[begin].order) {
+            ++end;
+        }
+        resumeBehaviors(resumed, events[begin].order);
+        skipRemoved(begin, end);
+
+        if (interleave) {
+            CommandKey::Scope scope(commandKey());
+            // Consecutive actions of one type are timed together, and the times of every type are summed by the
+            // profiler, as if the types were stepped in batches.
+            size_t type = sizeof...(Agents);
+            auto start = profiler.now();
+            for (size_t i = begin; i < end; ++i) {
+                if (slots[events[i].id].skipped) {
+                    continue;
+                }
+                if constexpr (ProfilingBackend<Backend>) {
+                    if (const size_t next = typeOf(events[i]); next != type) {
+                        if (type < sizeof...(Agents)) {
+                            profiler.recordStep(type, start);
+                        }
+                        type = next;
+                        start = profiler.now();
+                    }
+                }
+                events[i].step(model);
+            }
+            if (type < sizeof...(Agents)) {
+                profiler.recordStep(type, start);
+            }
+        }
+        else {
+            gather(begin, end);
+            (stepBatch<Agents>(parallel), ...);
+        }
+        begin = end;
+    }
+    resumeBehaviors(resumed, std::numeric_limits<size_t>::max());
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::resumeBehaviors(size_t& next, const size_t bound) {
+    if (next == resumptions.size() || resumptions[next].order >= bound) {
+        return;
+    }
+    CommandKey::Scope scope(commandKey());
+    for (; next < resumptions.size() && resumptions[next].order < bound; ++next) {
+        try {
+            behaviors[resumptions[next].id].resume();
+        }
+        catch (...) {
+            if (!behaviorError) {
+                behaviorError = std::current_exception();
             }
-        }, event.agent);
+        }
+    }
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::afterStep() {
+    {
+        CommandKey::Scope scope(commandKey());
+        model.afterStep();
+    }
+    flushCommands();
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::flushCommands() {
+    if constexpr (Deferring<M>) {
+        model.flushCommands();
     }
+}
 
-    model.afterStep();
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+uint64_t BasicSchedule<Backend, M, Agents...>::commandKey() {
+    // Serial identifies the unit of work, and the lower 32 bits are left for the index of the first agent of a chunk.
+    if constexpr (Deferring<M>) {
+        return model.commands().nextSerial() << 32;
+    }
+    else {
+        return 0;
+    }
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::advancePhase() requires (Advanceable<Agents, M> && ...) {
+    gather(0, events.size());
+    (advanceBatch<Agents>(parallelAdvance && pool), ...);
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::skipRemoved(const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        Slot& slot = slots[events[i].id];
+        slot.skipped = slot.cancelled || slot.rescheduled;
+    }
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::gather(const size_t begin, const size_t end) {
+    std::apply([](auto&... batch) { (batch.clear(), ...); }, batches);
+    for (size_t i = begin; i < end; ++i) {
+        if (!slots[events[i].id].skipped) {
+            gatherOne(events[i], std::index_sequence_for<Agents...>{});
+        }
+    }
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+template<size_t... I>
+void BasicSchedule<Backend, M, Agents...>::gatherOne(const ActionItem& action, std::index_sequence<I...>) {
+    if constexpr (HandleBackend<Backend>) {
+        action.visit(model, [&](auto agent) { std::get<std::vector<decltype(agent)>>(batches).push_back(agent); });
+    }
+    else {
+        const auto& agent = action.agent;
+        (void)((agent.index() == I && (std::get<I>(batches).push_back(*std::get_if<I>(&agent)), true)) || ...);
+    }
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+auto BasicSchedule<Backend, M, Agents...>::referenceOf(auto&& agent) const {
+    if constexpr (HandleBackend<Backend>) {
+        return model.handleOf(agent);
+    }
+    else {
+        static_assert((std::is_same_v<std::remove_cvref_t<decltype(agent)>, Agents> || ...),
+                      "Agents without a stable address, e.g. stored as structure of arrays, need a ByHandle backend");
+        return std::variant<Agents*...>(&agent);
+    }
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+template<typename T>
+void BasicSchedule<Backend, M, Agents...>::stepBatch(const bool parallel) {
+    auto& batch = std::get<std::vector<AgentPointer<T>>>(batches);
+    const uint64_t key = commandKey();
+    auto run = [&](const size_t first, const size_t last) {
+        CommandKey::Scope scope(key | first);
+        const std::span<AgentPointer<T>> agents(batch.data() + first, last - first);
+        if constexpr (BatchSchedulable<T, M, AgentPointer<T>>) {
+            T::stepBatch(agents, model);
+        }
+        else {
+            for (const auto agent : agents) {
+                agent->step(model);
+            }
+        }
+    };
+
+    if (batch.empty()) {
+        return;
+    }
+    const auto start = profiler.now();
+    if (parallel) {
+        pool->parallelFor(0, batch.size(), stepGrain, run);
+    }
+    else {
+        run(0, batch.size());
+    }
+    profiler.recordStep(typeIndex<T>(), start);
 }
 
-template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
-size_t Schedule<M, Agents...>::getEpochs() const {
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+template<typename T>
+void BasicSchedule<Backend, M, Agents...>::advanceBatch(const bool parallel) {
+    auto& batch = std::get<std::vector<AgentPointer<T>>>(batches);
+    const uint64_t key = commandKey();
+    auto run = [&](const size_t first, const size_t last) {
+        CommandKey::Scope scope(key | first);
+        for (size_t i = first; i < last; ++i) {
+            batch[i]->advance(model);
+        }
+    };
+
+    if (batch.empty()) {
+        return;
+    }
+    const auto start = profiler.now();
+    if (parallel) {
+        pool->parallelFor(0, batch.size(), advanceGrain, run);
+    }
+    else {
+        run(0, batch.size());
+    }
+    profiler.recordAdvance(typeIndex<T>(), start);
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+template<typename T>
+constexpr size_t BasicSchedule<Backend, M, Agents...>::typeIndex() {
+    size_t index = 0;
+    (void)((std::is_same_v<T, Agents> || (++index, false)) || ...);
+    return index;
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+size_t BasicSchedule<Backend, M, Agents...>::typeOf(const ActionItem& action) const {
+    if constexpr (HandleBackend<Backend>) {
+        // Stale handles, whose actions are skipped by step, belong to none of the types.
+        size_t type = sizeof...(Agents);
+        action.visit(model, [&](auto agent) {
+            using Pointer = decltype(agent);
+            (void)((std::is_same_v<Pointer, AgentPointer<Agents>> && (type = typeIndex<Agents>(), true)) || ...);
+        });
+        return type;
+    }
+    else {
+        return action.agent.index();
+    }
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+auto BasicSchedule<Backend, M, Agents...>::makeProfiler() -> ProfilerT {
+    if constexpr (ProfilingBackend<Backend>) {
+        return ProfilerT(1024, {profiling::typeName<Agents>(typeIndex<Agents>())...});
+    }
+    else {
+        return {};
+    }
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+size_t BasicSchedule<Backend, M, Agents...>::getEpochs() const {
     return epochs;
 }
 
-template<SimState M, Schedulable<M> ... Agents> requires (sizeof...(Agents) > 0)
-bool Schedule<M, Agents...>::isActive() const {
+template<typename Backend, SimState M, Schedulable<M> ... Agents> requires (sizeof...(Agents) > 0)
+bool BasicSchedule<Backend, M, Agents...>::isActive() const {
     return !model.shouldEnd(epochs);
 }
 
-template<SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
-void Schedule<M, Agents...>::execute() {
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::execute() {
     while (isActive()) {
         step();
     }
 }
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::setThreads(const size_t threads) {
+    ownedPool = threads > 1 ? std::make_unique<ThreadPool>(threads) : nullptr;
+    pool = ownedPool.get();
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::setThreadPool(ThreadPool* pPool) {
+    ownedPool.reset();
+    pool = pPool;
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::setParallelStep(const bool parallel, const size_t grain) {
+    parallelStep = parallel;
+    stepGrain = grain;
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::setParallelAdvance(const bool parallel, const size_t grain) {
+    parallelAdvance = parallel;
+    advanceGrain = grain;
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::setRandomActivation(const bool random, const uint64_t seed) {
+    randomActivation = random;
+    activationRandom = Random(seed);
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::spawn(Behavior behavior, const size_t time, const size_t order) {
+    size_t id;
+    if (freeBehaviors.empty()) {
+        id = behaviors.size();
+        behaviors.push_back(std::move(behavior));
+    }
+    else {
+        id = freeBehaviors.back();
+        freeBehaviors.pop_back();
+        behaviors[id] = std::move(behavior);
+    }
+    timers.push({time, order, id});
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+Delay BasicSchedule<Backend, M, Agents...>::delay(const size_t steps) const {
+    return {epochs + std::max<size_t>(steps, 1), 0, true};
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+Delay BasicSchedule<Backend, M, Agents...>::delay(const size_t steps, const size_t order) const {
+    return {epochs + std::max<size_t>(steps, 1), order, false};
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+size_t BasicSchedule<Backend, M, Agents...>::behaviorCount() const {
+    return timers.size();
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+bool BasicSchedule<Backend, M, Agents...>::cancel(const Handle handle) {
+    if (!resolve(handle)) {
+        return false;
+    }
+
+    Slot& slot = slots[handle.id];
+    if (slot.running) {
+        slot.cancelled = true;
+        return true;
+    }
+    actions.erase(handle.id);
+    release(handle.id);
+    return true;
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+bool BasicSchedule<Backend, M, Agents...>::reschedule(const Handle handle, const size_t time, const size_t order) {
+    if (!resolve(handle)) {
+        return false;
+    }
+
+    Slot& slot = slots[handle.id];
+    if (slot.running) {
+        slot.time = time;
+        slot.order = order;
+        slot.rescheduled = true;
+        return true;
+    }
+    return actions.update(handle.id, time, order);
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+bool BasicSchedule<Backend, M, Agents...>::changeInterval(const Handle handle, const size_t interval) {
+    if (!resolve(handle)) {
+        return false;
+    }
+
+    const Slot& slot = slots[handle.id];
+    ActionItem* action = slot.running ? &events[slot.event] : actions.find(handle.id);
+    action->interval = interval;
+    return true;
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+bool BasicSchedule<Backend, M, Agents...>::isScheduled(const Handle handle) const {
+    return resolve(handle) != nullptr;
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+size_t BasicSchedule<Backend, M, Agents...>::actionCount() const {
+    return actions.size();
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::reserve(const size_t capacity) {
+    actions.reserve(capacity);
+    events.reserve(capacity);
+    slots.reserve(capacity);
+    freeSlots.reserve(capacity);
+    std::apply([&](auto&... batch) { (batch.reserve(capacity), ...); }, batches);
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::compact() {
+    actions.eraseIf([&](const ActionItem& action) {
+        if (action.isActive(model)) {
+            return false;
+        }
+        release(action.id);
+        return true;
+    });
+    compactionBase = std::max(actions.size(), minCompactionBase);
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+template<typename R>
+void BasicSchedule<Backend, M, Agents...>::relocate(const R& relocations) {
+    auto removed = [&](ActionItem& action) {
+        action.agent = relocations.relocate(action.agent);
+        if constexpr (HandleBackend<Backend>) {
+            return !action.agent;
+        }
+        else {
+            return std::visit([](const auto* agent) { return agent == nullptr; }, action.agent);
+        }
+    };
+
+    actions.eraseIf([&](ActionItem& action) {
+        if (!removed(action)) {
+            return false;
+        }
+        release(action.id);
+        return true;
+    });
+    // Actions taken from the queue in the current time step are released by reschedulePhase, without touching their
+    // agents.
+    for (ActionItem& event : events) {
+        if (Slot& slot = slots[event.id]; slot.running && removed(event)) {
+            slot.cancelled = true;
+        }
+    }
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::setCompactionThreshold(const double threshold) {
+    compactionThreshold = threshold;
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+auto BasicSchedule<Backend, M, Agents...>::enqueue(ActionItem action) -> Handle {
+    uint32_t id;
+    if (freeSlots.empty()) {
+        id = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+    }
+    else {
+        id = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    slots[id].used = true;
+    action.id = id;
+    actions.push(action);
+    const Handle handle(this, id, slots[id].generation);
+
+    if (static_cast<double>(actions.size()) > static_cast<double>(compactionBase) * (1. + compactionThreshold)) {
+        compact();
+    }
+    return handle;
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+void BasicSchedule<Backend, M, Agents...>::release(const size_t id) {
+    Slot& slot = slots[id];
+    slot = Slot{slot.generation + 1};
+    freeSlots.push_back(static_cast<uint32_t>(id));
+}
+
+template<typename Backend, SimState M, Schedulable<M>... Agents> requires (sizeof...(Agents) > 0)
+auto BasicSchedule<Backend, M, Agents...>::resolve(const Handle handle) const -> const Slot* {
+    if (handle.schedule != this || handle.id >= slots.size()) {
+        return nullptr;
+    }
+
+    const Slot& slot = slots[handle.id];
+    if (!slot.used || slot.cancelled || slot.generation != handle.generation) {
+        return nullptr;
+    }
+    return &slot;
+}
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../utilities/Concepts.hpp"
+#include "../utilities/Execution.hpp"
+#include "../utilities/ThreadPool.hpp"
 
 #include <cmath>
 #include <variant>
@@ -67,6 +69,35 @@ public:
     template<typename F> requires (std::invocable<F, Agents&> || ...)
     void apply(F&& f);
 
+    /**
+     * Calls specified function for every agent on the field. With std::execution::par or par_unseq, and more than one
+     * thread in the pool set by setThreadPool, disjoint ranges of cells of the discretization are processed
+     * concurrently, so f must not modify shared state without synchronization, nor add, move or remove agents.
+     * @tparam P Type of the execution policy.
+     * @tparam F Type of the invoked function.
+     * @param policy Execution policy, e.g. std::execution::seq or std::execution::par.
+     * @param f Function to be invoked. It must be invocable with a reference to an agent.
+     */
+    template<ExecutionPolicy P, typename F> requires (std::invocable<F, Agents&> || ...)
+    void apply(P&& policy, F&& f);
+
+    /**
+     * Sets the thread pool running apply with parallel execution policies, e.g. the pool of the model returned by
+     * Model::threadPool, so that spaces and the model share one set of threads. The pool is not owned, and it must
+     * outlive the parallel calls. Null pointer (default) means that it is executed by the calling thread.
+     * @param pPool Pool running the work, or nullptr.
+     */
+    void setThreadPool(ThreadPool* pPool) { pool = pPool; }
+
+    /**
+     * Updates references to the agents moved by Model::compact and removes the agents which were removed from the
+     * model. It is called by the model the space is attached to.
+     * @tparam R Type of the relocation table.
+     * @param relocations Table of the moved and removed agents.
+     */
+    template<typename R>
+    void relocate(const R& relocations);
+
     /**
      * Get agent count at the given position.
      * @param p Point at which we want to count agents.
@@ -117,6 +148,7 @@ private:
     int cols;
     GridT grid;
     bool toroidal;
+    ThreadPool* pool{};
 
     [[nodiscard]] Point discretize(RealPoint point) const;
     [[nodiscard]] SquareT& getCell(RealPoint point);
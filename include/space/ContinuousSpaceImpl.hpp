@@ -45,13 +45,37 @@ void ContinuousSpace<Agents...>::apply(F&& f) {
     applyToAll(grid,
                [&](SquareT& square) {
                    for (auto agent : square) {
-                       std::visit([&](auto a) { std::invoke(std::forward<F>(f), *a); }, agent);
+                       visitPointer([&](auto a) { std::invoke(std::forward<F>(f), *a); }, agent);
                    }
                },
                cols,
                rows);
 }
 
+template<RealPositionable ... Agents> requires (sizeof...(Agents) > 0)
+template<ExecutionPolicy P, typename F> requires (std::invocable<F, Agents&> || ...)
+void ContinuousSpace<Agents...>::apply(P&&, F&& f) {
+    // Cells of the discretization hold few agents each, so every row of them is a separate chunk.
+    forEachChunk<P>(pool, grid.size(), static_cast<size_t>(cols), [&](const size_t begin, const size_t end) {
+        for (size_t cell = begin; cell < end; ++cell) {
+            for (auto agent : grid[cell]) {
+                visitPointer([&](auto a) { std::invoke(f, *a); }, agent);
+            }
+        }
+    });
+}
+
+template<RealPositionable ... Agents> requires (sizeof...(Agents) > 0)
+template<typename R>
+void ContinuousSpace<Agents...>::relocate(const R& relocations) {
+    for (SquareT& square : grid) {
+        for (AgentT& agent : square) {
+            agent = relocations.relocate(agent);
+        }
+        std::erase_if(square, [](AgentT agent) { return std::visit([](auto a) { return a == nullptr; }, agent); });
+    }
+}
+
 template<RealPositionable ... Agents> requires (sizeof...(Agents) > 0)
 size_t ContinuousSpace<Agents...>::agentCount(const RealPoint p) const {
     return std::ranges::count_if(getCell(p),
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "../utilities/Random.hpp"
+
+namespace agh {
+/**
+ * Index of the empty cells of a grid, which supports sampling a random empty cell in O(1) time. The number of empty
+ * cells is always maintained, while the list of empty cells is built on the first sampling, and then it is updated
+ * incrementally in O(1) time whenever a cell becomes occupied or empty. Grids which never sample don't pay for it.
+ */
+class EmptyCellIndex {
+public:
+    /**
+     * Creates index of the grid with the given number of cells, all of them empty except the padding.
+     * @param pCells Number of cells of the grid, including padding.
+     * @param padding Number of cells which don't belong to the grid, so they are never empty.
+     */
+    explicit EmptyCellIndex(size_t pCells, size_t padding = 0) : cells(pCells), occupied(padding) {}
+
+    /**
+     * Records that the empty cell became occupied.
+     * @param cell Index of the cell.
+     */
+    void occupy(size_t cell);
+
+    /**
+     * Records that the occupied cell became empty.
+     * @param cell Index of the cell.
+     */
+    void vacate(size_t cell);
+
+    /**
+     * Returns number of empty cells.
+     * @return Number of empty cells.
+     */
+    [[nodiscard]] size_t emptyCount() const { return cells - occupied; }
+
+    /**
+     * Returns uniformly distributed random empty cell. The first call builds the list of empty cells in O(cells) time.
+     * @tparam G Type of the random bit generator, e.g. RandomStream. It must meet randomBelow requirements, so the
+     * sampled cell is the same on every platform.
+     * @tparam IsEmpty Type of the predicate checking if a cell is empty.
+     * @param rng Random bit generator.
+     * @param isEmpty Predicate invocable with the index of a cell, used to build the list. It must return false for
+     * padding.
+     * @return Index of the sampled cell, or std::nullopt if all cells are occupied.
+     */
+    template<std::uniform_random_bit_generator G, typename IsEmpty>
+    std::optional<size_t> sample(G& rng, IsEmpty&& isEmpty);
+
+private:
+    static constexpr uint32_t absent = UINT32_MAX;
+
+    size_t cells;
+    size_t occupied{};
+    std::vector<uint32_t> empty;
+    std::vector<uint32_t> positions;
+};
+
+inline void EmptyCellIndex::occupy(const size_t cell) {
+    occupied += 1;
+    if (!positions.empty()) {
+        const uint32_t position = positions[cell];
+        positions[empty.back()] = position;
+        empty[position] = empty.back();
+        empty.pop_back();
+        positions[cell] = absent;
+    }
+}
+
+inline void EmptyCellIndex::vacate(const size_t cell) {
+    occupied -= 1;
+    if (!positions.empty()) {
+        positions[cell] = static_cast<uint32_t>(empty.size());
+        empty.push_back(static_cast<uint32_t>(cell));
+    }
+}
+
+template<std::uniform_random_bit_generator G, typename IsEmpty>
+std::optional<size_t> EmptyCellIndex::sample(G& rng, IsEmpty&& isEmpty) {
+    if (positions.empty() && cells > 0) {
+        positions.assign(cells, absent);
+        empty.reserve(emptyCount());
+        for (size_t cell = 0; cell < cells; ++cell) {
+            if (isEmpty(cell)) {
+                positions[cell] = static_cast<uint32_t>(empty.size());
+                empty.push_back(static_cast<uint32_t>(cell));
+            }
+        }
+    }
+    if (empty.empty()) {
+        return std::nullopt;
+    }
+    return empty[randomBelow(rng, static_cast<uint32_t>(empty.size()))];
+}
+}
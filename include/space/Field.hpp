@@ -1,20 +1,41 @@
 #pragma once
 
 #include "../utilities/Concepts.hpp"
+#include "../utilities/Execution.hpp"
+#include "../utilities/TaggedPointer.hpp"
+#include "../utilities/ThreadPool.hpp"
+#include "EmptyCellIndex.hpp"
+#include "GridGeometry.hpp"
 #include "Point.hpp"
+#include "Stencil.hpp"
 
+#include <cstdint>
 #include <optional>
 #include <variant>
 #include <vector>
 
 namespace agh {
 /**
- * Representation of two-dimensional grid. It allows storage of the one agent per cell.
+ * Representation of two-dimensional grid. It allows storage of the one agent per cell. Every cell is a tagged pointer
+ * to the agent, which takes a single word if the alignment of the agent types leaves room for the tag, and occupancy of
+ * the cells is additionally kept in a bitmap, so that checking and scanning empty cells touches one bit per cell, and
+ * iteration over agents skips 64 empty cells at a time. Empty cells are also indexed, so that a random empty cell is
+ * sampled in O(1) time. Dimensions and topology may be fixed at compile time, which specializes index arithmetic and
+ * wrapping, while the interface stays the same. The layout of the cells in memory may be changed as well, in which case
+ * apply and transform visit agents in the order of the layout.
+ * @tparam E Extent of the grid, i.e. DynamicExtent or Extent<W, H>.
+ * @tparam Tp Topology of the grid, i.e. DynamicTopology, Bounded or Torus.
+ * @tparam L Layout of the cells in memory, i.e. RowMajor, Tiled<S> or Morton.
  * @tparam Agents Types of the agents to be stored in the struct. They must meet Positionable requirements.
  */
-template<Positionable... Agents> requires (sizeof...(Agents) > 0)
-class Field {
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+class BasicField {
 public:
+  /**
+   * Type of the dimensions and topology of the grid.
+   */
+  using Geometry = GridGeometry<E, Tp, L>;
+
   /**
    * Type of the agent stored at given cell.
    */
@@ -25,34 +46,38 @@ public:
    */
   using OptAgentT = std::optional<AgentT>;
 
+  /**
+   * Type of the cell, i.e. pointer to the agent tagged with index of its type, which is null if the cell is empty.
+   */
+  using CellT = TaggedPointer<Agents...>;
 
   /**
    * Type of the grid.
    */
-  using GridT = std::vector<OptAgentT>;
+  using GridT = std::vector<CellT>;
 
   /**
    * Creates empty grid that has specified attributes.
-   * @param pWidth Width of the grid.
-   * @param pHeight Height of the grid.
-   * @param torus Should space wrap.
+   * @param pWidth Width of the grid. It must match the static extent, if there is one.
+   * @param pHeight Height of the grid. It must match the static extent, if there is one.
+   * @param torus Should space wrap. It must match the static topology, if there is one.
    */
-  explicit Field(const int pWidth, const int pHeight, const bool torus = false)
-    : width(pWidth), height(pHeight), grid(height * width), toroidal(torus) {}
+  explicit BasicField(const int pWidth, const int pHeight, const bool torus = Geometry::defaultToroidal)
+    : geometry(pWidth, pHeight, torus), grid(geometry.cells()), occupancy((grid.size() + 63) / 64),
+      empties(grid.size(), geometry.padding()) {}
 
   /**
-   * Gets agent at the given position. Returns std::nullopt when at given position there is no agent.
-   * @param pos Position to check agent at.
-   * @return Reference to the specified cell.
+   * Creates empty grid of the dimensions and topology fixed at compile time.
    */
-  OptAgentT& getAgent(Point pos);
+  BasicField() requires Geometry::fixed
+    : grid(geometry.cells()), occupancy((grid.size() + 63) / 64), empties(grid.size(), geometry.padding()) {}
 
   /**
    * Gets agent at the given position. Returns std::nullopt when at given position there is no agent.
    * @param pos Position to check agent at.
-   * @return Reference to the specified constant cell.
+   * @return Pointer to the agent at the specified cell, or std::nullopt if it is empty.
    */
-  const OptAgentT& getAgent(Point pos) const;
+  [[nodiscard]] OptAgentT getAgent(Point pos) const;
 
   /**
    * Adds agent on the field at specified position only if there is no other agent at that position. It sets pos
@@ -106,6 +131,47 @@ public:
   template<typename F> requires (std::invocable<F, Point, Agents&> || ...)
   void transform(F&& f);
 
+  /**
+   * Calls specified function for every agent on the grid. With std::execution::par or par_unseq, and more than one
+   * thread in the pool set by setThreadPool, disjoint ranges of cells are processed concurrently, so f must not modify
+   * shared state without synchronization, nor add, move or remove agents.
+   * @tparam P Type of the execution policy.
+   * @tparam F Type of the invoked function.
+   * @param policy Execution policy, e.g. std::execution::seq or std::execution::par.
+   * @param f Function to be invoked. It must be invocable with a reference to an agent.
+   */
+  template<ExecutionPolicy P, typename F> requires (std::invocable<F, Agents&> || ...)
+  void apply(P&& policy, F&& f);
+
+  /**
+   * Calls specified function for every pair (coordinates, agent) on the grid. With std::execution::par or par_unseq,
+   * and more than one thread in the pool set by setThreadPool, disjoint ranges of cells are processed concurrently, so
+   * f must not modify shared state without synchronization, nor add, move or remove agents.
+   * @tparam P Type of the execution policy.
+   * @tparam F Type of the invoked function.
+   * @param policy Execution policy, e.g. std::execution::seq or std::execution::par.
+   * @param f Function to be invoked. It must be invocable with an object of type Point and a reference to an agent.
+   */
+  template<ExecutionPolicy P, typename F> requires (std::invocable<F, Point, Agents&> || ...)
+  void transform(P&& policy, F&& f);
+
+  /**
+   * Sets the thread pool running apply and transform with parallel execution policies, e.g. the pool of the model
+   * returned by Model::threadPool, so that spaces and the model share one set of threads. The pool is not owned, and it
+   * must outlive the parallel calls. Null pointer (default) means that they are executed by the calling thread.
+   * @param pPool Pool running the work, or nullptr.
+   */
+  void setThreadPool(ThreadPool* pPool) { pool = pPool; }
+
+  /**
+   * Updates references to the agents moved by Model::compact and removes the agents which were removed from the
+   * model. It is called by the model the field is attached to.
+   * @tparam R Type of the relocation table.
+   * @param relocations Table of the moved and removed agents.
+   */
+  template<typename R>
+  void relocate(const R& relocations);
+
   /**
    * Checks if the cell at the given position is empty.
    * @param p Position of the cell we want to check to see if it is empty.
@@ -133,6 +199,19 @@ public:
    */
   [[nodiscard]] std::vector<AgentT> getNeighbors(Point pos, int r=1, bool moore=true, bool center=false);
 
+  /**
+   * Calls f for every agent in the neighborhood of the given point, described by the stencil. It doesn't allocate, and
+   * cells beyond the grid are skipped, or wrapped if the grid is toroidal.
+   * @tparam S Type of the stencil, i.e. Stencil or FixedStencil.
+   * @tparam F Type of the invoked function.
+   * @param pos Central point of the neighborhood.
+   * @param stencil Precomputed offsets of the neighborhood, e.g. Stencil::moore() or Stencil::fixedMoore<1>().
+   * @param f Function invocable with a reference to an agent. It may return bool, where false stops the iteration.
+   * @return False if the iteration was stopped by f, true otherwise.
+   */
+  template<StencilShape S, typename F> requires (std::invocable<F, Agents&> || ...)
+  bool forEachNeighbor(Point pos, const S& stencil, F&& f);
+
   /**
    * Checks if given point is beyond the grid.
    * @param p Point to be checked.
@@ -148,35 +227,78 @@ public:
   [[nodiscard]] Point toToroidal(Point p) const;
 
   /**
-   * Gets all empty cells of the grid.
+   * Gets all empty cells of the grid, in the order of the storage layout.
    * @return Vector containing the coordinates of grids without an agent.
    */
   [[nodiscard]] std::vector<Point> getEmpty() const;
 
+  /**
+   * Gets number of empty cells of the grid in O(1) time.
+   * @return Number of cells without an agent.
+   */
+  [[nodiscard]] size_t emptyCount() const { return empties.emptyCount(); }
+
+  /**
+   * Gets uniformly distributed random empty cell in O(1) time. The first call builds index of empty cells in
+   * O(width * height) time, which is afterwards updated when agents are added, moved or removed.
+   * @tparam G Type of the random bit generator, e.g. RandomStream.
+   * @param rng Random bit generator.
+   * @return Coordinates of the sampled cell, or std::nullopt if there is no empty cell.
+   */
+  template<std::uniform_random_bit_generator G>
+  [[nodiscard]] std::optional<Point> randomEmpty(G& rng);
+
+  /**
+   * Gets empty cell nearest to the given point in the Chebyshev distance, by searching rings of cells around it. Ties
+   * are broken in a fixed order. If the grid is toroidal, rings wrap around its edges.
+   * @param p Point to search around.
+   * @return Coordinates of the nearest empty cell, or std::nullopt if there is no empty cell.
+   */
+  [[nodiscard]] std::optional<Point> nearestEmpty(Point p) const;
+
   /**
    * Gets with of the grid. Equivalent to the maximum x coordinate plus one.
    * @return Width of the grid.
    */
-  [[nodiscard]] int getWidth() const { return width; }
+  [[nodiscard]] int getWidth() const { return geometry.width(); }
 
   /**
    * Gets height of the grid. Equivalent to the maximum y coordinate plus one.
    * @return Height of the grid.
    */
-  [[nodiscard]] int getHeight() const { return height; }
+  [[nodiscard]] int getHeight() const { return geometry.height(); }
 
   /**
    * Checks if grid is wrapped (top edge is connected with bottom edge, and left edge is connected with right edge).
    * @return True if grid is representing wrapped space, false otherwise.
    */
-  [[nodiscard]] bool isToroidal() const { return toroidal; }
+  [[nodiscard]] bool isToroidal() const { return geometry.toroidal(); }
 
 private:
-  int width;
-  int height;
+  Geometry geometry;
   GridT grid;
-  bool toroidal;
+  std::vector<uint64_t> occupancy;
+  EmptyCellIndex empties;
+  ThreadPool* pool{};
+
+  [[nodiscard]] size_t indexOf(const Point p) const { return geometry.indexOf(p); }
+  [[nodiscard]] bool occupied(const size_t cell) const { return occupancy[cell / 64] >> (cell % 64) & 1; }
+  void place(size_t cell, CellT agent);
+  void clear(size_t cell);
+
+  template<typename F>
+  void forEachOccupied(F&& f) const { forEachOccupied(0, occupancy.size(), std::forward<F>(f)); }
+
+  template<typename F>
+  void forEachOccupied(size_t beginWord, size_t endWord, F&& f) const;
 };
+
+/**
+ * Field with dimensions and topology chosen at run time.
+ * @tparam Agents Types of the agents to be stored in the struct. They must meet Positionable requirements.
+ */
+template<Positionable... Agents> requires (sizeof...(Agents) > 0)
+using Field = BasicField<DynamicExtent, DynamicTopology, RowMajor, Agents...>;
 }
 
 #include "FieldImpl.hpp"
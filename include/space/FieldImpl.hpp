@@ -2,122 +2,218 @@
 
 #include "../utilities/Utils.hpp"
 
+#include <algorithm>
+#include <bit>
+
 namespace agh {
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
 template<Positionable Agent> requires (std::is_same_v<Agent, Agents> || ...)
-bool Field<Agents...>::addAgent(Agent& agent, Point pos) {
-    if (getAgent(pos)) return false;
-    getAgent(pos) = &agent;
+bool BasicField<E, Tp, L, Agents...>::addAgent(Agent& agent, Point pos) {
+    const size_t cell = indexOf(pos);
+    if (occupied(cell)) return false;
+    place(cell, CellT(&agent));
     agent.pos = pos;
     return true;
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
 template<Positionable Agent> requires (std::is_same_v<Agent, Agents> || ...)
-bool Field<Agents...>::moveAgent(Agent& agent, Point pos) {
-    if (getAgent(pos)) return false;
+bool BasicField<E, Tp, L, Agents...>::moveAgent(Agent& agent, Point pos) {
+    const size_t cell = indexOf(pos);
+    if (occupied(cell)) return false;
     if (!agent.pos) {
         return addAgent(agent, pos);
     }
-    getAgent(*agent.pos) = std::nullopt;
-    getAgent(pos) = &agent;
+    clear(indexOf(*agent.pos));
+    place(cell, CellT(&agent));
     agent.pos = pos;
     return true;
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
 template<Positionable Agent> requires (std::is_same_v<Agent, Agents> || ...)
-void Field<Agents...>::removeAgent(Agent& agent) {
+void BasicField<E, Tp, L, Agents...>::removeAgent(Agent& agent) {
     if (agent.pos) {
-        getAgent(*agent.pos) = std::nullopt;
+        clear(indexOf(*agent.pos));
     }
     agent.pos = std::nullopt;
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-void Field<Agents...>::removeAgent(const Point pos) {
-    if (OptAgentT& square = getAgent(pos)) {
-        std::visit([&](auto agent) { removeAgent(*agent); }, *square);
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+void BasicField<E, Tp, L, Agents...>::removeAgent(const Point pos) {
+    const size_t cell = indexOf(pos);
+    if (occupied(cell)) {
+        grid[cell].visit([&](auto agent) { removeAgent(*agent); });
     }
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
 template<typename Visitor> requires (std::invocable<Visitor, Agents&> || ...)
-void Field<Agents...>::apply(Visitor&& f) {
-    applyToAll(grid,
-               [&](OptAgentT& agent) {
-                   if (!agent.has_value()) return;
-                   std::visit([&](auto a) { std::invoke(std::forward<Visitor>(f), *a); }, *agent);
-               },
-               width,
-               height);
+void BasicField<E, Tp, L, Agents...>::apply(Visitor&& f) {
+    forEachOccupied([&](const size_t cell) {
+        grid[cell].visit([&](auto a) { std::invoke(std::forward<Visitor>(f), *a); });
+    });
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
 template<typename F> requires (std::invocable<F, Point, Agents&> || ...)
-void Field<Agents...>::transform(F&& f) {
-    transformAll(grid,
-                 [&](Point p, OptAgentT& agent) {
-                     if (!agent.has_value()) return;
-                     std::visit([&](auto a) { std::invoke(std::forward<F>(f), p, *a); }, *agent);
-                 },
-                 width,
-                 height);
+void BasicField<E, Tp, L, Agents...>::transform(F&& f) {
+    forEachOccupied([&](const size_t cell) {
+        const Point p = geometry.pointOf(cell);
+        grid[cell].visit([&](auto a) { std::invoke(std::forward<F>(f), p, *a); });
+    });
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+template<ExecutionPolicy P, typename F> requires (std::invocable<F, Agents&> || ...)
+void BasicField<E, Tp, L, Agents...>::apply(P&&, F&& f) {
+    forEachChunk<P>(pool, occupancy.size(), bulkCells / 64, [&](const size_t begin, const size_t end) {
+        forEachOccupied(begin, end, [&](const size_t cell) {
+            grid[cell].visit([&](auto a) { std::invoke(f, *a); });
+        });
+    });
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-auto Field<Agents...>::getAgent(const Point pos) -> OptAgentT& {
-    return grid[pos.y * width + pos.x];
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+template<ExecutionPolicy P, typename F> requires (std::invocable<F, Point, Agents&> || ...)
+void BasicField<E, Tp, L, Agents...>::transform(P&&, F&& f) {
+    forEachChunk<P>(pool, occupancy.size(), bulkCells / 64, [&](const size_t begin, const size_t end) {
+        forEachOccupied(begin, end, [&](const size_t cell) {
+            const Point p = geometry.pointOf(cell);
+            grid[cell].visit([&](auto a) { std::invoke(f, p, *a); });
+        });
+    });
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+template<typename R>
+void BasicField<E, Tp, L, Agents...>::relocate(const R& relocations) {
+    forEachOccupied([&](const size_t cell) {
+        const AgentT agent = relocations.relocate(grid[cell].variant());
+        if (std::visit([](auto a) { return a == nullptr; }, agent)) {
+            clear(cell);
+        }
+        else {
+            grid[cell] = CellT(agent);
+        }
+    });
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-auto Field<Agents...>::getAgent(const Point pos) const -> const OptAgentT& {
-    return grid[pos.y * width + pos.x];
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+auto BasicField<E, Tp, L, Agents...>::getAgent(const Point pos) const -> OptAgentT {
+    const size_t cell = indexOf(pos);
+    if (!occupied(cell)) return std::nullopt;
+    return grid[cell].variant();
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-bool Field<Agents...>::isEmpty(const Point p) const {
-    return !getAgent(p).has_value();
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+bool BasicField<E, Tp, L, Agents...>::isEmpty(const Point p) const {
+    return !occupied(indexOf(p));
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-std::vector<Point> Field<Agents...>::getNeighborhood(Point pos, int r, bool moore, bool center) const {
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+std::vector<Point> BasicField<E, Tp, L, Agents...>::getNeighborhood(Point pos, int r, bool moore, bool center) const {
     return visitNeighborhood(*this, pos, r, moore, center, [](Point p) { return p; });
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-std::vector<typename Field<Agents...>::AgentT> Field<Agents...>::getNeighbors(
-    const Point pos, int r, const bool moore, const bool center) {
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+auto BasicField<E, Tp, L, Agents...>::getNeighbors(
+    const Point pos, int r, const bool moore, const bool center) -> std::vector<AgentT> {
     auto f = [&](const Point p, std::vector<AgentT>& result) {
-        if (!isEmpty(p))
-            result.push_back(*getAgent(p));
+        const size_t cell = indexOf(p);
+        if (occupied(cell))
+            result.push_back(grid[cell].variant());
     };
-    return visitNeighbors<Field, AgentT, decltype(f)>(*this, pos, r, moore, center, std::forward<decltype(f)>(f));
+    return visitNeighbors<BasicField, AgentT, decltype(f)>(*this, pos, r, moore, center,
+                                                           std::forward<decltype(f)>(f));
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+template<StencilShape S, typename F> requires (std::invocable<F, Agents&> || ...)
+bool BasicField<E, Tp, L, Agents...>::forEachNeighbor(const Point pos, const S& stencil, F&& f) {
+    return forEachStencilCell(geometry, pos, stencil, [&](Point, const size_t cell) {
+        return !occupied(cell) || grid[cell].visit([&](auto a) { return invokeContinuing(f, *a); });
+    });
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-bool Field<Agents...>::outOfBounds(const Point p) const {
-    return p.x < 0 || p.x >= width || p.y < 0 || p.y >= height;
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+bool BasicField<E, Tp, L, Agents...>::outOfBounds(const Point p) const {
+    return geometry.outOfBounds(p);
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-Point Field<Agents...>::toToroidal(const Point p) const {
-    return convertToToroidal(p, width, height);
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+Point BasicField<E, Tp, L, Agents...>::toToroidal(const Point p) const {
+    return geometry.toToroidal(p);
 }
 
-template<Positionable... Agents> requires (sizeof...(Agents) > 0)
-std::vector<Point> Field<Agents...>::getEmpty() const {
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+std::vector<Point> BasicField<E, Tp, L, Agents...>::getEmpty() const {
     std::vector<Point> result;
-    result.reserve(width*height / 2);
+    result.reserve(emptyCount());
 
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < height; ++x) {
-            if (isEmpty({x,y})) {
-                result.push_back({x, y});
+    if constexpr (!std::same_as<L, RowMajor>) {
+        geometry.forEachCell([&](const Point p, const size_t cell) {
+            if (!occupied(cell)) result.push_back(p);
+        });
+        return result;
+    }
+
+    for (size_t word = 0; word < occupancy.size(); ++word) {
+        uint64_t empty = ~occupancy[word];
+        if (word == occupancy.size() - 1 && grid.size() % 64) {
+            empty &= (uint64_t{1} << grid.size() % 64) - 1;
+        }
+        const Point first = geometry.pointOf(word * 64);
+        for (; empty; empty &= empty - 1) {
+            Point p(first.x + std::countr_zero(empty), first.y);
+            while (p.x >= getWidth()) {
+                p.x -= getWidth();
+                p.y += 1;
             }
+            result.push_back(p);
         }
     }
 
     return result;
 }
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+template<std::uniform_random_bit_generator G>
+std::optional<Point> BasicField<E, Tp, L, Agents...>::randomEmpty(G& rng) {
+    const auto cell = empties.sample(rng, [&](const size_t i) { return !occupied(i) && !geometry.isPadding(i); });
+    if (!cell) return std::nullopt;
+    return geometry.pointOf(*cell);
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+std::optional<Point> BasicField<E, Tp, L, Agents...>::nearestEmpty(const Point p) const {
+    if (emptyCount() == 0) return std::nullopt;
+    return spiralSearch(*this, p, std::max(getWidth(), getHeight()), [&](const Point q) {
+        return !occupied(indexOf(q));
+    });
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+void BasicField<E, Tp, L, Agents...>::place(const size_t cell, const CellT agent) {
+    grid[cell] = agent;
+    occupancy[cell / 64] |= uint64_t{1} << (cell % 64);
+    empties.occupy(cell);
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+void BasicField<E, Tp, L, Agents...>::clear(const size_t cell) {
+    grid[cell] = CellT();
+    occupancy[cell / 64] &= ~(uint64_t{1} << (cell % 64));
+    empties.vacate(cell);
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+template<typename F>
+void BasicField<E, Tp, L, Agents...>::forEachOccupied(const size_t beginWord, const size_t endWord, F&& f) const {
+    for (size_t word = beginWord; word < endWord; ++word) {
+        for (uint64_t bits = occupancy[word]; bits; bits &= bits - 1) {
+            f(word * 64 + std::countr_zero(bits));
+        }
+    }
+}
 }
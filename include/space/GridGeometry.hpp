@@ -0,0 +1,371 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "Point.hpp"
+
+namespace agh {
+/**
+ * Marks dimensions of a grid as known only at run time, i.e. passed to the constructor.
+ */
+struct DynamicExtent {};
+
+/**
+ * Compile-time dimensions of a grid. Index arithmetic on such grids uses constants, so e.g. multiplication by a power
+ * of two width becomes a shift.
+ * @tparam W Width of the grid.
+ * @tparam H Height of the grid.
+ */
+template<int W, int H> requires (W > 0 && H > 0)
+struct Extent {
+    static constexpr int width = W;
+    static constexpr int height = H;
+};
+
+/**
+ * Marks topology of a grid as chosen at run time with the torus flag of the constructor.
+ */
+struct DynamicTopology {};
+
+/**
+ * Topology of a grid whose edges are not connected, so cells beyond them are skipped.
+ */
+struct Bounded {};
+
+/**
+ * Topology of a grid whose top edge is connected with the bottom one, and left edge with the right one.
+ */
+struct Torus {};
+
+/**
+ * Layout storing cells row by row. Neighbors in the same row are adjacent in memory, while neighbors in the adjacent
+ * rows are a whole row apart.
+ */
+struct RowMajor {
+    static constexpr size_t cells(const int width, const int height) { return static_cast<size_t>(width) * height; }
+
+    static constexpr size_t row(const int y, const int width, int) { return static_cast<size_t>(y) * width; }
+
+    static constexpr size_t column(const int x, int, int) { return static_cast<size_t>(x); }
+
+    static constexpr Point pointOf(const size_t cell, const int width, int) {
+        return {static_cast<int>(cell % width), static_cast<int>(cell / width)};
+    }
+};
+
+/**
+ * Layout storing cells in square tiles, which are stored row by row, and cells within a tile are also stored row by
+ * row. Small neighborhoods then mostly lie within one or a few tiles. Dimensions are padded to a multiple of the tile
+ * size.
+ * @tparam S Size of the side of the tile. It must be a power of two.
+ */
+template<int S = 8> requires (S > 0 && (S & (S - 1)) == 0)
+struct Tiled {
+    static constexpr size_t cells(const int width, const int height) {
+        return static_cast<size_t>(tilesIn(width)) * tilesIn(height) * S * S;
+    }
+
+    static constexpr size_t row(const int y, const int width, int) {
+        const auto u = static_cast<size_t>(y);
+        return u / S * tilesIn(width) * S * S + u % S * S;
+    }
+
+    static constexpr size_t column(const int x, int, int) {
+        const auto u = static_cast<size_t>(x);
+        return u / S * S * S + u % S;
+    }
+
+    static constexpr Point pointOf(const size_t cell, const int width, int) {
+        const size_t tile = cell / (S * S);
+        const size_t offset = cell % (S * S);
+        return {static_cast<int>(tile % tilesIn(width) * S + offset % S),
+                static_cast<int>(tile / tilesIn(width) * S + offset / S)};
+    }
+
+private:
+    static constexpr int tilesIn(const int size) { return (size + S - 1) / S; }
+};
+
+/**
+ * Layout storing cells along the Z-order curve, i.e. index of a cell interleaves bits of its coordinates, so cells
+ * close in both dimensions are close in memory at every scale. Dimensions are padded to powers of two, and bits of the
+ * longer dimension which have no counterpart are placed above the interleaved ones.
+ */
+struct Morton {
+    static constexpr size_t cells(const int width, const int height) {
+        return size_t{1} << (bitsOf(width) + bitsOf(height));
+    }
+
+    static constexpr size_t row(const int y, const int width, const int height) {
+        return interleave(static_cast<uint64_t>(y), std::min(bitsOf(width), bitsOf(height)), 1);
+    }
+
+    static constexpr size_t column(const int x, const int width, const int height) {
+        return interleave(static_cast<uint64_t>(x), std::min(bitsOf(width), bitsOf(height)), 0);
+    }
+
+    static constexpr Point pointOf(const size_t cell, const int width, const int height) {
+        const int shared = std::min(bitsOf(width), bitsOf(height));
+        const uint64_t low = cell & ((uint64_t{1} << 2 * shared) - 1);
+        const uint64_t high = cell >> 2 * shared;
+        uint64_t x = compact(low);
+        uint64_t y = compact(low >> 1);
+        if (bitsOf(width) > bitsOf(height)) {
+            x |= high << shared;
+        }
+        else {
+            y |= high << shared;
+        }
+        return {static_cast<int>(x), static_cast<int>(y)};
+    }
+
+private:
+    static constexpr int bitsOf(const int size) { return std::bit_width(static_cast<unsigned>(size) - 1); }
+
+    // Spreads the shared low bits of the coordinate at positions of the given parity, and places the remaining ones
+    // above them. Remaining bits of the shorter dimension are always zero, so parts of both coordinates can be added.
+    static constexpr uint64_t interleave(const uint64_t c, const int shared, const int parity) {
+        return spread(c & ((uint64_t{1} << shared) - 1)) << parity | (c >> shared) << 2 * shared;
+    }
+
+    // Places bits of the value at even positions.
+    static constexpr uint64_t spread(uint64_t v) {
+        v = (v | v << 16) & 0x0000FFFF0000FFFF;
+        v = (v | v << 8) & 0x00FF00FF00FF00FF;
+        v = (v | v << 4) & 0x0F0F0F0F0F0F0F0F;
+        v = (v | v << 2) & 0x3333333333333333;
+        return (v | v << 1) & 0x5555555555555555;
+    }
+
+    // Gathers bits at even positions, inverse of spread.
+    static constexpr uint64_t compact(uint64_t v) {
+        v &= 0x5555555555555555;
+        v = (v | v >> 1) & 0x3333333333333333;
+        v = (v | v >> 2) & 0x0F0F0F0F0F0F0F0F;
+        v = (v | v >> 4) & 0x00FF00FF00FF00FF;
+        v = (v | v >> 8) & 0x0000FFFF0000FFFF;
+        return (v | v >> 16) & 0x00000000FFFFFFFF;
+    }
+};
+
+template<typename E>
+concept GridExtent = std::same_as<E, DynamicExtent> || requires {
+    { E::width } -> std::convertible_to<int>;
+    { E::height } -> std::convertible_to<int>;
+};
+
+template<typename T>
+concept GridTopology = std::same_as<T, DynamicTopology> || std::same_as<T, Bounded> || std::same_as<T, Torus>;
+
+template<typename L>
+concept GridLayout = requires(size_t cell, int c, int size) {
+    { L::cells(size, size) } -> std::same_as<size_t>;
+    { L::row(c, size, size) } -> std::same_as<size_t>;
+    { L::column(c, size, size) } -> std::same_as<size_t>;
+    { L::pointOf(cell, size, size) } -> std::same_as<Point>;
+};
+
+/**
+ * Dimensions, topology and memory layout of a grid, together with the index arithmetic depending on them. Dimensions
+ * and topology are either stored at run time, or fixed at compile time by the template parameters, in which case the
+ * accessors return constants and the branches depending on them are folded. Wrapping a grid of a static power of two
+ * extent is a mask. Layouts other than RowMajor may pad the grid with cells which don't belong to it.
+ * @tparam E Extent of the grid, i.e. DynamicExtent or Extent<W, H>.
+ * @tparam Tp Topology of the grid, i.e. DynamicTopology, Bounded or Torus.
+ * @tparam L Layout of the cells in memory, i.e. RowMajor, Tiled<S> or Morton.
+ */
+template<GridExtent E = DynamicExtent, GridTopology Tp = DynamicTopology, GridLayout L = RowMajor>
+class GridGeometry {
+public:
+    /**
+     * Layout of the cells in memory.
+     */
+    using Layout = L;
+
+    /**
+     * True if the dimensions are known at compile time.
+     */
+    static constexpr bool staticExtent = !std::same_as<E, DynamicExtent>;
+
+    /**
+     * True if the topology is known at compile time.
+     */
+    static constexpr bool staticTopology = !std::same_as<Tp, DynamicTopology>;
+
+    /**
+     * True if the dimensions and the topology are known at compile time, so the grid doesn't need any arguments.
+     */
+    static constexpr bool fixed = staticExtent && staticTopology;
+
+    /**
+     * Default value of the torus flag of the grid constructors, which matches the static topology.
+     */
+    static constexpr bool defaultToroidal = std::same_as<Tp, Torus>;
+
+    /**
+     * Creates geometry of the given attributes. Attributes fixed at compile time must match the given ones.
+     * @param pWidth Width of the grid.
+     * @param pHeight Height of the grid.
+     * @param torus Should grid wrap.
+     */
+    constexpr GridGeometry(const int pWidth, const int pHeight, const bool torus)
+        : dynamicWidth(pWidth), dynamicHeight(pHeight), dynamicToroidal(torus) {
+        assert(width() == pWidth && height() == pHeight && "dimensions don't match the static extent");
+        assert(toroidal() == torus && "torus flag doesn't match the static topology");
+    }
+
+    /**
+     * Creates geometry fixed at compile time.
+     */
+    constexpr GridGeometry() requires fixed : GridGeometry(width(), height(), toroidal()) {}
+
+    [[nodiscard]] constexpr int width() const {
+        if constexpr (staticExtent) return E::width;
+        else return dynamicWidth;
+    }
+
+    [[nodiscard]] constexpr int height() const {
+        if constexpr (staticExtent) return E::height;
+        else return dynamicHeight;
+    }
+
+    [[nodiscard]] constexpr bool toroidal() const {
+        if constexpr (staticTopology) return std::same_as<Tp, Torus>;
+        else return dynamicToroidal;
+    }
+
+    /**
+     * Returns number of the cells stored by the layout, including padding.
+     * @return Size of the storage of the grid.
+     */
+    [[nodiscard]] constexpr size_t cells() const { return L::cells(width(), height()); }
+
+    /**
+     * Returns number of the cells stored by the layout which don't belong to the grid.
+     * @return Size of the padding.
+     */
+    [[nodiscard]] constexpr size_t padding() const { return cells() - static_cast<size_t>(width()) * height(); }
+
+    /**
+     * Returns index of the cell at the given point in the storage.
+     * @param p Point inside the grid.
+     * @return Index of the cell.
+     */
+    [[nodiscard]] constexpr size_t indexOf(const Point p) const { return row(p.y) + column(p.x); }
+
+    /**
+     * Returns part of the index of a cell which depends only on its y coordinate. Index of the cell is the sum of its
+     * row and column parts, so they may be computed once for a row or column of cells.
+     * @param y Row inside the grid.
+     * @return Row part of the index.
+     */
+    [[nodiscard]] constexpr size_t row(const int y) const { return L::row(y, width(), height()); }
+
+    /**
+     * Returns part of the index of a cell which depends only on its x coordinate.
+     * @param x Column inside the grid.
+     * @return Column part of the index.
+     */
+    [[nodiscard]] constexpr size_t column(const int x) const { return L::column(x, width(), height()); }
+
+    /**
+     * Returns point of the cell at the given index in the storage.
+     * @param cell Index of the cell.
+     * @return Coordinates of the cell, which are beyond the grid if the cell is padding.
+     */
+    [[nodiscard]] constexpr Point pointOf(const size_t cell) const { return L::pointOf(cell, width(), height()); }
+
+    /**
+     * Checks if the cell at the given index in the storage is padding.
+     * @param cell Index of the cell.
+     * @return True if the cell doesn't belong to the grid.
+     */
+    [[nodiscard]] constexpr bool isPadding(const size_t cell) const {
+        if constexpr (std::same_as<L, RowMajor>) return false;
+        else return outOfBounds(pointOf(cell));
+    }
+
+    /**
+     * Calls f for every cell of the grid in the order of the storage, skipping padding.
+     * @tparam F Type of the invoked function.
+     * @param f Function invocable with the coordinates and the index of a cell.
+     */
+    template<std::invocable<Point, size_t> F>
+    constexpr void forEachCell(F&& f) const { forEachCell(0, cells(), std::forward<F>(f)); }
+
+    /**
+     * Calls f for every cell of the grid with index in the given range of the storage, skipping padding. Disjoint
+     * ranges may be processed concurrently, e.g. rows of a row-major grid or tiles of a tiled one.
+     * @tparam F Type of the invoked function.
+     * @param begin Index of the first cell of the range.
+     * @param end Index one past the last cell of the range.
+     * @param f Function invocable with the coordinates and the index of a cell.
+     */
+    template<std::invocable<Point, size_t> F>
+    constexpr void forEachCell(size_t begin, size_t end, F&& f) const;
+
+    /**
+     * Checks if given point is beyond the grid.
+     * @param p Point to be checked.
+     * @return Boolean value indicating if given point is out of the bounds of the grid.
+     */
+    [[nodiscard]] constexpr bool outOfBounds(const Point p) const {
+        return p.x < 0 || p.x >= width() || p.y < 0 || p.y >= height();
+    }
+
+    /**
+     * Maps the given point to the coordinates it would have if the grid were toroidal.
+     * @param p Point to be converted.
+     * @return Point mapped to the proper coordinates.
+     */
+    [[nodiscard]] constexpr Point toToroidal(const Point p) const;
+
+private:
+    int dynamicWidth;
+    int dynamicHeight;
+    bool dynamicToroidal;
+};
+
+template<GridExtent E, GridTopology Tp, GridLayout L>
+template<std::invocable<Point, size_t> F>
+constexpr void GridGeometry<E, Tp, L>::forEachCell(const size_t begin, const size_t end, F&& f) const {
+    if (begin == end) {
+        return;
+    }
+    if constexpr (std::same_as<L, RowMajor>) {
+        Point p = pointOf(begin);
+        for (size_t cell = begin; cell < end; ++cell) {
+            f(p, cell);
+            if (++p.x == width()) {
+                p.x = 0;
+                ++p.y;
+            }
+        }
+    }
+    else {
+        for (size_t cell = begin; cell < end; ++cell) {
+            if (const Point p = pointOf(cell); !outOfBounds(p)) {
+                f(p, cell);
+            }
+        }
+    }
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L>
+constexpr Point GridGeometry<E, Tp, L>::toToroidal(const Point p) const {
+    if constexpr (staticExtent) {
+        if constexpr ((E::width & (E::width - 1)) == 0 && (E::height & (E::height - 1)) == 0) {
+            return {p.x & (E::width - 1), p.y & (E::height - 1)};
+        }
+    }
+    const int x = p.x % width();
+    const int y = p.y % height();
+    return {x < 0 ? x + width() : x, y < 0 ? y + height() : y};
+}
+}
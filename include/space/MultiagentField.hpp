@@ -1,19 +1,37 @@
 #pragma once
 
 #include "../utilities/Concepts.hpp"
+#include "../utilities/Execution.hpp"
+#include "../utilities/ThreadPool.hpp"
+#include "EmptyCellIndex.hpp"
+#include "GridGeometry.hpp"
 #include "Point.hpp"
+#include "Stencil.hpp"
 
+#include <optional>
 #include <variant>
 #include <vector>
 
 namespace agh {
 /**
- * Representation of two-dimensional grid. It allows storage of the multiple agents in one cell.
+ * Representation of two-dimensional grid. It allows storage of the multiple agents in one cell. Empty cells are
+ * indexed, so that a random empty cell is sampled in O(1) time. The index is maintained by the methods adding, moving
+ * and removing agents, so cells returned by getAgents must not be modified directly. Dimensions and topology may be
+ * fixed at compile time, which specializes index arithmetic and wrapping, while the interface stays the same. The
+ * layout of the cells in memory may be changed as well, in which case apply and transform visit cells in its order.
+ * @tparam E Extent of the grid, i.e. DynamicExtent or Extent<W, H>.
+ * @tparam Tp Topology of the grid, i.e. DynamicTopology, Bounded or Torus.
+ * @tparam L Layout of the cells in memory, i.e. RowMajor, Tiled<S> or Morton.
  * @tparam Agents Types of the agents to be stored in the struct. They must meet Positionable requirements.
  */
-template<Positionable... Agents> requires (sizeof...(Agents) > 0)
-class MultiagentField {
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+class BasicMultiagentField {
 public:
+    /**
+     * Type of the dimensions and topology of the grid.
+     */
+    using Geometry = GridGeometry<E, Tp, L>;
+
     /**
      * Type of the stored agent.
      */
@@ -31,27 +49,34 @@ public:
 
     /**
      * Creates empty grid that has specified attributes.
-     * @param pWidth Width of the grid.
-     * @param pHeight Height of the grid.
-     * @param torus Should space wrap.
+     * @param pWidth Width of the grid. It must match the static extent, if there is one.
+     * @param pHeight Height of the grid. It must match the static extent, if there is one.
+     * @param torus Should space wrap. It must match the static topology, if there is one.
      */
-    explicit MultiagentField(const int pWidth, const int pHeight, const bool torus = false)
-        : width(pWidth), height(pHeight), grid(height * width), toroidal(torus) {}
+    explicit BasicMultiagentField(const int pWidth, const int pHeight, const bool torus = Geometry::defaultToroidal)
+        : geometry(pWidth, pHeight, torus), grid(geometry.cells()), empties(grid.size(), geometry.padding()) {}
 
     /**
      * Crates empty grid that has specified attributes. Additionally, it reserves requested space for agents per grid.
-     * @param pWidth Width of the grid.
-     * @param pHeight Height of the grid.
+     * @param pWidth Width of the grid. It must match the static extent, if there is one.
+     * @param pHeight Height of the grid. It must match the static extent, if there is one.
      * @param reservation Number of agents per grid to reserve.
-     * @param torus Should space wrap.
+     * @param torus Should space wrap. It must match the static topology, if there is one.
      */
-    explicit MultiagentField(const int pWidth, const int pHeight, size_t reservation, const bool torus = false)
-        : width(pWidth), height(pHeight), grid(height * width), toroidal(torus) {
+    explicit BasicMultiagentField(const int pWidth, const int pHeight, size_t reservation,
+                                  const bool torus = Geometry::defaultToroidal)
+        : geometry(pWidth, pHeight, torus), grid(geometry.cells()), empties(grid.size(), geometry.padding()) {
         for (auto& cell : grid) {
             cell.reserve(reservation);
         }
     }
 
+    /**
+     * Creates empty grid of the dimensions and topology fixed at compile time.
+     */
+    BasicMultiagentField() requires Geometry::fixed
+        : grid(geometry.cells()), empties(grid.size(), geometry.padding()) {}
+
     /**
      * Gets all agents present at the given position. Returns empty vector if there is no agent at given position.
      * @param pos Position to get agents from.
@@ -115,6 +140,47 @@ public:
     template<typename F> requires (std::invocable<F, Point, Agents&> || ...)
     void transform(F&& f);
 
+    /**
+     * Calls specified function for every agent on the grid. With std::execution::par or par_unseq, and more than one
+     * thread in the pool set by setThreadPool, disjoint ranges of cells are processed concurrently, so f must not
+     * modify shared state without synchronization, nor add, move or remove agents.
+     * @tparam P Type of the execution policy.
+     * @tparam F Type of the invoked function.
+     * @param policy Execution policy, e.g. std::execution::seq or std::execution::par.
+     * @param f Function to be invoked. It must be invocable with a reference to an agent.
+     */
+    template<ExecutionPolicy P, typename F> requires (std::invocable<F, Agents&> || ...)
+    void apply(P&& policy, F&& f);
+
+    /**
+     * Calls specified function for every pair (coordinates, agent) on the grid. With std::execution::par or par_unseq,
+     * and more than one thread in the pool set by setThreadPool, disjoint ranges of cells are processed concurrently,
+     * so f must not modify shared state without synchronization, nor add, move or remove agents.
+     * @tparam P Type of the execution policy.
+     * @tparam F Type of the invoked function.
+     * @param policy Execution policy, e.g. std::execution::seq or std::execution::par.
+     * @param f Function to be invoked. It must be invocable with an object of type Point and a reference to an agent.
+     */
+    template<ExecutionPolicy P, typename F> requires (std::invocable<F, Point, Agents&> || ...)
+    void transform(P&& policy, F&& f);
+
+    /**
+     * Sets the thread pool running apply and transform with parallel execution policies, e.g. the pool of the model
+     * returned by Model::threadPool, so that spaces and the model share one set of threads. The pool is not owned, and
+     * it must outlive the parallel calls. Null pointer (default) means that they are executed by the calling thread.
+     * @param pPool Pool running the work, or nullptr.
+     */
+    void setThreadPool(ThreadPool* pPool) { pool = pPool; }
+
+    /**
+     * Updates references to the agents moved by Model::compact and removes the agents which were removed from the
+     * model. It is called by the model the field is attached to.
+     * @tparam R Type of the relocation table.
+     * @param relocations Table of the moved and removed agents.
+     */
+    template<typename R>
+    void relocate(const R& relocations);
+
     /**
      * Checks if the cell at the given position is empty.
      * @param p Position of the cell we want to check to see if it is empty.
@@ -149,6 +215,19 @@ public:
      */
     [[nodiscard]] std::vector<AgentT> getNeighbors(Point pos, int r, bool moore, bool center);
 
+    /**
+     * Calls f for every agent in the neighborhood of the given point, described by the stencil. It doesn't allocate,
+     * and cells beyond the grid are skipped, or wrapped if the grid is toroidal.
+     * @tparam S Type of the stencil, i.e. Stencil or FixedStencil.
+     * @tparam F Type of the invoked function.
+     * @param pos Central point of the neighborhood.
+     * @param stencil Precomputed offsets of the neighborhood, e.g. Stencil::moore() or Stencil::fixedMoore<1>().
+     * @param f Function invocable with a reference to an agent. It may return bool, where false stops the iteration.
+     * @return False if the iteration was stopped by f, true otherwise.
+     */
+    template<StencilShape S, typename F> requires (std::invocable<F, Agents&> || ...)
+    bool forEachNeighbor(Point pos, const S& stencil, F&& f);
+
     /**
      * Checks if given point is beyond the grid.
      * @param p Point to be checked.
@@ -164,35 +243,68 @@ public:
     [[nodiscard]] Point toToroidal(Point p) const;
 
     /**
-     * Gets all empty cells of the grid.
+     * Gets all empty cells of the grid, in the order of the storage layout.
      * @return Vector containing the coordinates of grids without an agent.
      */
     [[nodiscard]] std::vector<Point> getEmpty() const;
 
+    /**
+     * Gets number of empty cells of the grid in O(1) time.
+     * @return Number of cells without an agent.
+     */
+    [[nodiscard]] size_t emptyCount() const { return empties.emptyCount(); }
+
+    /**
+     * Gets uniformly distributed random empty cell in O(1) time. The first call builds index of empty cells in
+     * O(width * height) time, which is afterwards updated when agents are added, moved or removed.
+     * @tparam G Type of the random bit generator, e.g. RandomStream.
+     * @param rng Random bit generator.
+     * @return Coordinates of the sampled cell, or std::nullopt if there is no empty cell.
+     */
+    template<std::uniform_random_bit_generator G>
+    [[nodiscard]] std::optional<Point> randomEmpty(G& rng);
+
+    /**
+     * Gets empty cell nearest to the given point in the Chebyshev distance, by searching rings of cells around it. Ties
+     * are broken in a fixed order. If the grid is toroidal, rings wrap around its edges.
+     * @param p Point to search around.
+     * @return Coordinates of the nearest empty cell, or std::nullopt if there is no empty cell.
+     */
+    [[nodiscard]] std::optional<Point> nearestEmpty(Point p) const;
+
     /**
      * Gets with of the grid. Equivalent to the maximum x coordinate plus one.
      * @return Width of the grid.
      */
-    [[nodiscard]] int getWidth() const { return width; }
+    [[nodiscard]] int getWidth() const { return geometry.width(); }
 
     /**
      * Gets height of the grid. Equivalent to the maximum y coordinate plus one.
      * @return Height of the grid.
      */
-    [[nodiscard]] int getHeight() const { return height; }
+    [[nodiscard]] int getHeight() const { return geometry.height(); }
 
     /**
      * Checks if grid is wrapped (top edge is connected with bottom edge, and left edge is connected with right edge).
      * @return True if grid is representing wrapped space, false otherwise
      */
-    [[nodiscard]] bool isToroidal() const { return toroidal; }
+    [[nodiscard]] bool isToroidal() const { return geometry.toroidal(); }
 
 private:
-    int width;
-    int height;
+    Geometry geometry;
     GridT grid;
-    bool toroidal;
+    EmptyCellIndex empties;
+    ThreadPool* pool{};
+
+    [[nodiscard]] size_t indexOf(const Point p) const { return geometry.indexOf(p); }
 };
+
+/**
+ * MultiagentField with dimensions and topology chosen at run time.
+ * @tparam Agents Types of the agents to be stored in the struct. They must meet Positionable requirements.
+ */
+template<Positionable... Agents> requires (sizeof...(Agents) > 0)
+using MultiagentField = BasicMultiagentField<DynamicExtent, DynamicTopology, RowMajor, Agents...>;
 }
 
 #include "MultiagentFieldImpl.hpp"
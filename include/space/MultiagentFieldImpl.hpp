@@ -2,36 +2,44 @@
 
 #include "../utilities/Utils.hpp"
 
+#include <algorithm>
+
 namespace agh {
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-auto MultiagentField<Agents...>::getAgents(const Point pos) -> SquareT& {
-    return grid[pos.y * width + pos.x];
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+auto BasicMultiagentField<E, Tp, L, Agents...>::getAgents(const Point pos) -> SquareT& {
+    return grid[indexOf(pos)];
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-auto MultiagentField<Agents...>::getAgents(const Point pos) const -> const SquareT& {
-    return grid[pos.y * width + pos.x];
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+auto BasicMultiagentField<E, Tp, L, Agents...>::getAgents(const Point pos) const -> const SquareT& {
+    return grid[indexOf(pos)];
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
 template<Positionable Agent> requires (std::is_same_v<Agent, Agents> || ...)
-void MultiagentField<Agents...>::addAgent(Agent& agent, Point pos) {
+void BasicMultiagentField<E, Tp, L, Agents...>::addAgent(Agent& agent, Point pos) {
     agent.pos = pos;
-    getAgents(pos).push_back(&agent);
+    SquareT& square = getAgents(pos);
+    if (square.empty()) {
+        empties.occupy(indexOf(pos));
+    }
+    square.push_back(&agent);
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
 template<Positionable Agent> requires (std::is_same_v<Agent, Agents> || ...) && std::equality_comparable<Agent>
-void MultiagentField<Agents...>::moveAgent(Agent& agent, Point pos) {
+void BasicMultiagentField<E, Tp, L, Agents...>::moveAgent(Agent& agent, Point pos) {
     removeAgent(agent);
     addAgent(agent, pos);
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
 template<Positionable Agent> requires (std::is_same_v<Agent, Agents> || ...) && std::equality_comparable<Agent>
-void MultiagentField<Agents...>::removeAgent(Agent& agent) {
+void BasicMultiagentField<E, Tp, L, Agents...>::removeAgent(Agent& agent) {
     if (agent.pos) {
-        std::erase_if(getAgents(*agent.pos),
+        SquareT& square = getAgents(*agent.pos);
+        const bool wasEmpty = square.empty();
+        std::erase_if(square,
                       [&](AgentT agentVariant) {
                           return std::visit([&](auto a) {
                                                 if constexpr (std::is_same_v<
@@ -42,98 +50,161 @@ void MultiagentField<Agents...>::removeAgent(Agent& agent) {
                                             },
                                             agentVariant);
                       });
+        if (!wasEmpty && square.empty()) {
+            empties.vacate(indexOf(*agent.pos));
+        }
         agent.pos = std::nullopt;
     }
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-void MultiagentField<Agents...>::removeAgents(const Point pos) {
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+void BasicMultiagentField<E, Tp, L, Agents...>::removeAgents(const Point pos) {
     for (auto& agent : getAgents(pos)) {
         std::visit([&](auto a) { a->pos = std::nullopt; }, agent);
     }
+    if (!getAgents(pos).empty()) {
+        empties.vacate(indexOf(pos));
+    }
     getAgents(pos).clear();
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
 template<typename F> requires (std::invocable<F, Agents&> || ...)
-void MultiagentField<Agents...>::apply(F&& f) {
-    applyToAll(grid,
-               [&](SquareT& square) {
-                   for (auto agent : square) {
-                       std::visit([&](auto a) { std::invoke(std::forward<F>(f), *a); }, agent);
-                   }
-               },
-               width,
-               height);
-}
-
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
+void BasicMultiagentField<E, Tp, L, Agents...>::apply(F&& f) {
+    for (SquareT& square : grid) {
+        for (auto agent : square) {
+            visitPointer([&](auto a) { std::invoke(std::forward<F>(f), *a); }, agent);
+        }
+    }
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
 template<typename F> requires (std::invocable<F, Point, Agents&> || ...)
-void MultiagentField<Agents...>::transform(F&& f) {
-    transformAll(grid,
-                 [&](Point p, SquareT& agents) {
-                     for (auto& agent : agents) {
-                         std::visit([&](auto a) { std::invoke(std::forward<F>(f), p, *a); }, agent);
-                     }
-                 },
-                 width,
-                 height);
-}
-
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-bool MultiagentField<Agents...>::isEmpty(const Point p) const {
+void BasicMultiagentField<E, Tp, L, Agents...>::transform(F&& f) {
+    geometry.forEachCell([&](const Point p, const size_t cell) {
+        for (auto& agent : grid[cell]) {
+            visitPointer([&](auto a) { std::invoke(std::forward<F>(f), p, *a); }, agent);
+        }
+    });
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+template<ExecutionPolicy P, typename F> requires (std::invocable<F, Agents&> || ...)
+void BasicMultiagentField<E, Tp, L, Agents...>::apply(P&&, F&& f) {
+    forEachChunk<P>(pool, grid.size(), bulkCells, [&](const size_t begin, const size_t end) {
+        for (size_t cell = begin; cell < end; ++cell) {
+            for (auto agent : grid[cell]) {
+                visitPointer([&](auto a) { std::invoke(f, *a); }, agent);
+            }
+        }
+    });
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+template<ExecutionPolicy P, typename F> requires (std::invocable<F, Point, Agents&> || ...)
+void BasicMultiagentField<E, Tp, L, Agents...>::transform(P&&, F&& f) {
+    forEachChunk<P>(pool, grid.size(), bulkCells, [&](const size_t begin, const size_t end) {
+        geometry.forEachCell(begin, end, [&](const Point p, const size_t cell) {
+            for (auto agent : grid[cell]) {
+                visitPointer([&](auto a) { std::invoke(f, p, *a); }, agent);
+            }
+        });
+    });
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+template<typename R>
+void BasicMultiagentField<E, Tp, L, Agents...>::relocate(const R& relocations) {
+    for (size_t cell = 0; cell < grid.size(); ++cell) {
+        SquareT& square = grid[cell];
+        if (square.empty()) continue;
+        for (AgentT& agent : square) {
+            agent = relocations.relocate(agent);
+        }
+        std::erase_if(square, [](AgentT agent) { return std::visit([](auto a) { return a == nullptr; }, agent); });
+        if (square.empty()) {
+            empties.vacate(cell);
+        }
+    }
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+bool BasicMultiagentField<E, Tp, L, Agents...>::isEmpty(const Point p) const {
     return getAgents(p).empty();
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-size_t MultiagentField<Agents...>::agentCount(const Point p) const {
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+size_t BasicMultiagentField<E, Tp, L, Agents...>::agentCount(const Point p) const {
     return getAgents(p).size();
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-std::vector<Point> MultiagentField<Agents...>::getNeighborhood(Point pos, int r, bool moore, bool center) const {
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+std::vector<Point> BasicMultiagentField<E, Tp, L, Agents...>::getNeighborhood(
+    Point pos, int r, bool moore, bool center) const {
     return visitNeighborhood(*this, pos, r, moore, center, [](Point p) { return p; });
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-std::vector<typename MultiagentField<Agents...>::AgentT> MultiagentField<Agents...>::getNeighbors(
-    const Point pos, const int r, const bool moore, const bool center) {
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+auto BasicMultiagentField<E, Tp, L, Agents...>::getNeighbors(
+    const Point pos, const int r, const bool moore, const bool center) -> std::vector<AgentT> {
     auto f = [&](const Point p, std::vector<AgentT>& result) {
         for (auto& agent : getAgents(p)) {
             result.push_back(agent);
         }
     };
-    return visitNeighbors<MultiagentField, AgentT, decltype(f)>(*this,
-                                                                pos,
-                                                                r,
-                                                                moore,
-                                                                center,
-                                                                std::forward<decltype(f)>(f));
+    return visitNeighbors<BasicMultiagentField, AgentT, decltype(f)>(*this,
+                                                                     pos,
+                                                                     r,
+                                                                     moore,
+                                                                     center,
+                                                                     std::forward<decltype(f)>(f));
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+template<StencilShape S, typename F> requires (std::invocable<F, Agents&> || ...)
+bool BasicMultiagentField<E, Tp, L, Agents...>::forEachNeighbor(const Point pos, const S& stencil, F&& f) {
+    return forEachStencilCell(geometry, pos, stencil, [&](Point, const size_t cell) {
+        return std::ranges::all_of(grid[cell], [&](const AgentT agent) {
+            return visitPointer([&](auto a) { return invokeContinuing(f, *a); }, agent);
+        });
+    });
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-bool MultiagentField<Agents...>::outOfBounds(const Point p) const {
-    return p.x < 0 || p.x >= width || p.y < 0 || p.y >= height;
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+bool BasicMultiagentField<E, Tp, L, Agents...>::outOfBounds(const Point p) const {
+    return geometry.outOfBounds(p);
 }
 
-template<Positionable ... Agents> requires (sizeof...(Agents) > 0)
-Point MultiagentField<Agents...>::toToroidal(const Point p) const {
-    return convertToToroidal(p, width, height);
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+Point BasicMultiagentField<E, Tp, L, Agents...>::toToroidal(const Point p) const {
+    return geometry.toToroidal(p);
 }
 
-template<Positionable... Agents> requires (sizeof...(Agents) > 0)
-std::vector<Point> MultiagentField<Agents...>::getEmpty() const {
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+std::vector<Point> BasicMultiagentField<E, Tp, L, Agents...>::getEmpty() const {
     std::vector<Point> result;
-    result.reserve(width * height / 2);
+    result.reserve(emptyCount());
 
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < height; ++x) {
-            if (isEmpty({x, y})) {
-                result.push_back({x, y});
-            }
+    geometry.forEachCell([&](const Point p, const size_t cell) {
+        if (grid[cell].empty()) {
+            result.push_back(p);
         }
-    }
+    });
 
     return result;
 }
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+template<std::uniform_random_bit_generator G>
+std::optional<Point> BasicMultiagentField<E, Tp, L, Agents...>::randomEmpty(G& rng) {
+    const auto cell = empties.sample(rng, [&](const size_t i) { return grid[i].empty() && !geometry.isPadding(i); });
+    if (!cell) return std::nullopt;
+    return geometry.pointOf(*cell);
+}
+
+template<GridExtent E, GridTopology Tp, GridLayout L, Positionable... Agents> requires (sizeof...(Agents) > 0)
+std::optional<Point> BasicMultiagentField<E, Tp, L, Agents...>::nearestEmpty(const Point p) const {
+    if (emptyCount() == 0) return std::nullopt;
+    return spiralSearch(*this, p, std::max(getWidth(), getHeight()), [&](const Point q) { return isEmpty(q); });
+}
 }
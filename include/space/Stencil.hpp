@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "Point.hpp"
+
+namespace agh {
+/**
+ * Set of offsets describing a neighborhood of a grid cell, whose size is known at compile time. It is built in a
+ * constant expression, e.g. Stencil::fixedMoore<1>(), so that loops over its offsets are unrolled and the offsets
+ * are folded into the index arithmetic, especially on grids of static extent.
+ * @tparam N Number of the offsets.
+ */
+template<size_t N>
+class FixedStencil {
+public:
+    /**
+     * Creates stencil from the given offsets.
+     * @param pOffsets Offsets of the neighboring cells relative to the central one.
+     */
+    constexpr explicit FixedStencil(const std::array<Point, N>& pOffsets);
+
+    /**
+     * Returns offsets of the neighboring cells.
+     * @return Array of the offsets.
+     */
+    [[nodiscard]] constexpr const std::array<Point, N>& offsets() const { return cells; }
+
+    /**
+     * Returns the greatest Chebyshev distance of the offsets from the central cell.
+     * @return Radius of the stencil.
+     */
+    [[nodiscard]] constexpr int radius() const { return reach; }
+
+private:
+    std::array<Point, N> cells;
+    int reach{};
+};
+
+/**
+ * Precomputed set of offsets describing a neighborhood of a grid cell, e.g. Moore or von Neumann neighborhood of the
+ * given radius. Stencils are meant to be built once and reused, so that iterating over neighbors with
+ * forEachNeighbor neither allocates nor recomputes the shape of the neighborhood. Offsets are ordered by rows, and by
+ * columns within a row.
+ */
+class Stencil {
+public:
+    /**
+     * Creates stencil from the given offsets.
+     * @param pOffsets Offsets of the neighboring cells relative to the central one.
+     */
+    explicit Stencil(std::vector<Point> pOffsets);
+
+    /**
+     * Creates stencil of the Moore neighborhood, i.e. square of cells within the given Chebyshev distance.
+     * @param r Radius of the neighborhood.
+     * @param center If set to true, the central cell is included.
+     * @return Stencil of the neighborhood.
+     */
+    static Stencil moore(int r = 1, bool center = false);
+
+    /**
+     * Creates stencil of the von Neumann neighborhood, i.e. diamond of cells within the given Manhattan distance.
+     * @param r Radius of the neighborhood.
+     * @param center If set to true, the central cell is included.
+     * @return Stencil of the neighborhood.
+     */
+    static Stencil vonNeumann(int r = 1, bool center = false);
+
+    /**
+     * Creates stencil of the offsets within the given Chebyshev distance satisfying the predicate, e.g. a disc.
+     * @tparam F Type of the predicate.
+     * @param r Radius of the square containing the neighborhood.
+     * @param include Predicate invocable with an offset, returning true for offsets of the neighborhood.
+     * @return Stencil of the neighborhood.
+     */
+    template<std::predicate<Point> F>
+    static Stencil custom(int r, F&& include);
+
+    /**
+     * Creates stencil of the Moore neighborhood of the radius known at compile time.
+     * @tparam R Radius of the neighborhood.
+     * @tparam Center If set to true, the central cell is included.
+     * @return Fixed stencil of the neighborhood.
+     */
+    template<int R = 1, bool Center = false>
+    static constexpr auto fixedMoore();
+
+    /**
+     * Creates stencil of the von Neumann neighborhood of the radius known at compile time.
+     * @tparam R Radius of the neighborhood.
+     * @tparam Center If set to true, the central cell is included.
+     * @return Fixed stencil of the neighborhood.
+     */
+    template<int R = 1, bool Center = false>
+    static constexpr auto fixedVonNeumann();
+
+    /**
+     * Returns offsets of the neighboring cells.
+     * @return Span of the offsets.
+     */
+    [[nodiscard]] std::span<const Point> offsets() const { return cells; }
+
+    /**
+     * Returns the greatest Chebyshev distance of the offsets from the central cell.
+     * @return Radius of the stencil.
+     */
+    [[nodiscard]] int radius() const { return reach; }
+
+private:
+    std::vector<Point> cells;
+    int reach{};
+};
+}
+
+#include "StencilImpl.hpp"
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <utility>
+
+namespace agh {
+template<size_t N>
+constexpr FixedStencil<N>::FixedStencil(const std::array<Point, N>& pOffsets) : cells(pOffsets) {
+    for (const Point offset : cells) {
+        reach = std::max({reach, offset.x < 0 ? -offset.x : offset.x, offset.y < 0 ? -offset.y : offset.y});
+    }
+}
+
+inline Stencil::Stencil(std::vector<Point> pOffsets) : cells(std::move(pOffsets)) {
+    for (const Point offset : cells) {
+        reach = std::max({reach, std::abs(offset.x), std::abs(offset.y)});
+    }
+}
+
+inline Stencil Stencil::moore(const int r, const bool center) {
+    return custom(r, [=](const Point offset) { return center || offset != Point{}; });
+}
+
+inline Stencil Stencil::vonNeumann(const int r, const bool center) {
+    return custom(r, [=](const Point offset) {
+        return std::abs(offset.x) + std::abs(offset.y) <= r && (center || offset != Point{});
+    });
+}
+
+template<std::predicate<Point> F>
+Stencil Stencil::custom(const int r, F&& include) {
+    std::vector<Point> offsets;
+    offsets.reserve((2 * r + 1) * (2 * r + 1));
+    for (int dy = -r; dy <= r; ++dy) {
+        for (int dx = -r; dx <= r; ++dx) {
+            if (std::invoke(include, Point{dx, dy})) {
+                offsets.push_back({dx, dy});
+            }
+        }
+    }
+    return Stencil(std::move(offsets));
+}
+
+template<int R, bool Center>
+constexpr auto Stencil::fixedMoore() {
+    std::array<Point, (2 * R + 1) * (2 * R + 1) - !Center> offsets{};
+    size_t i = 0;
+    for (int dy = -R; dy <= R; ++dy) {
+        for (int dx = -R; dx <= R; ++dx) {
+            if (Center || dx != 0 || dy != 0) {
+                offsets[i++] = {dx, dy};
+            }
+        }
+    }
+    return FixedStencil(offsets);
+}
+
+template<int R, bool Center>
+constexpr auto Stencil::fixedVonNeumann() {
+    std::array<Point, 2 * R * (R + 1) + Center> offsets{};
+    size_t i = 0;
+    for (int dy = -R; dy <= R; ++dy) {
+        const int span = R - (dy < 0 ? -dy : dy);
+        for (int dx = -span; dx <= span; ++dx) {
+            if (Center || dx != 0 || dy != 0) {
+                offsets[i++] = {dx, dy};
+            }
+        }
+    }
+    return FixedStencil(offsets);
+}
+}
@@ -2,27 +2,49 @@
 
 #include <vector>
 
+#include "../utilities/Concepts.hpp"
+#include "../utilities/Execution.hpp"
+#include "../utilities/ThreadPool.hpp"
+#include "GridGeometry.hpp"
 #include "Point.hpp"
+#include "Stencil.hpp"
 
 namespace agh {
 /**
  * Represents two-dimensional grid for storing space attributes. It poses two arrays: one to modify values, and the
- * second one to read them.
+ * second one to read them. Dimensions and topology may be fixed at compile time, which specializes index arithmetic
+ * and wrapping, e.g. ValueLayer<int, Extent<1024, 1024>, Torus>, while the interface stays the same. The layout of
+ * the cells in memory may be changed as well, e.g. to Tiled<8>, so that neighborhoods span fewer cache lines.
  * @tparam T Type of the stored attributes.
+ * @tparam E Extent of the layer, i.e. DynamicExtent or Extent<W, H>.
+ * @tparam Tp Topology of the layer, i.e. DynamicTopology, Bounded or Torus.
+ * @tparam L Layout of the cells in memory, i.e. RowMajor, Tiled<S> or Morton.
  */
-template<typename T>
+template<typename T, GridExtent E = DynamicExtent, GridTopology Tp = DynamicTopology, GridLayout L = RowMajor>
 class ValueLayer {
 public:
+    /**
+     * Type of the dimensions and topology of the layer.
+     */
+    using Geometry = GridGeometry<E, Tp, L>;
+
     /**
      * Constructs ValueLayer with specified value on both layers.
-     * @param pWidth Width of the layer.
-     * @param pHeight Height of the layer.
-     * @param torus Should layer wrap.
+     * @param pWidth Width of the layer. It must match the static extent, if there is one.
+     * @param pHeight Height of the layer. It must match the static extent, if there is one.
+     * @param torus Should layer wrap. It must match the static topology, if there is one.
+     * @param initValue Initial value of the read and write layers.
+     */
+    explicit ValueLayer(const int pWidth, const int pHeight, const bool torus = Geometry::defaultToroidal,
+                        const T initValue = T())
+        : geometry(pWidth, pHeight, torus), read(geometry.cells(), initValue), write(geometry.cells(), initValue) {}
+
+    /**
+     * Constructs ValueLayer of the dimensions and topology fixed at compile time, with specified value on both layers.
      * @param initValue Initial value of the read and write layers.
      */
-    explicit ValueLayer(const int pWidth, const int pHeight, const bool torus = false, const T initValue = T())
-        : width(pWidth), height(pHeight), read(height * width, initValue), write(height * width, initValue),
-          toroidal(torus) {}
+    explicit ValueLayer(const T initValue = T()) requires Geometry::fixed
+        : read(geometry.cells(), initValue), write(geometry.cells(), initValue) {}
 
     /**
      * Returns value stored at given position on the read layer.
@@ -69,6 +91,40 @@ public:
     template<std::invocable<Point, T&> F>
     void transform(F&& f);
 
+    /**
+     * Calls specified function for every attribute value on the write layer. With std::execution::par or par_unseq, and
+     * more than one thread in the pool set by setThreadPool, disjoint ranges of cells are processed concurrently, so f
+     * must not modify shared state without synchronization.
+     * @tparam P Type of the execution policy.
+     * @tparam F Type of the invoked function.
+     * @param policy Execution policy, e.g. std::execution::seq or std::execution::par.
+     * @param f Function to be invoked. It must be invocable with a reference to an attribute type.
+     */
+    template<ExecutionPolicy P, std::invocable<T&> F>
+    void apply(P&& policy, F&& f);
+
+    /**
+     * Calls specified function for every pair (coordinates, attribute) on the write layer. With std::execution::par or
+     * par_unseq, and more than one thread in the pool set by setThreadPool, disjoint ranges of cells are processed
+     * concurrently, so f must not modify shared state without synchronization. Reading the read layer, e.g. with
+     * forEachNeighbor, is safe.
+     * @tparam P Type of the execution policy.
+     * @tparam F Type of the invoked function.
+     * @param policy Execution policy, e.g. std::execution::seq or std::execution::par.
+     * @param f Function to be invoked. It must be invocable with an object of type Point and a reference to an
+     * attribute type.
+     */
+    template<ExecutionPolicy P, std::invocable<Point, T&> F>
+    void transform(P&& policy, F&& f);
+
+    /**
+     * Sets the thread pool running apply and transform with parallel execution policies, e.g. the pool of the model
+     * returned by Model::threadPool, so that spaces and the model share one set of threads. The pool is not owned, and
+     * it must outlive the parallel calls. Null pointer (default) means that they are executed by the calling thread.
+     * @param pPool Pool running the work, or nullptr.
+     */
+    void setThreadPool(ThreadPool* pPool) { pool = pPool; }
+
     /**
      * Returns all points that are neighboring (according to the specified criteria) the chosen central point.
      * @param pos Point which neighborhood we want to get.
@@ -89,6 +145,20 @@ public:
      */
     [[nodiscard]] std::vector<T> getNeighbors(Point pos, int r, bool moore, bool center) const;
 
+    /**
+     * Calls f for every value on the read layer in the neighborhood of the given point, described by the stencil. It
+     * doesn't allocate, and cells beyond the grid are skipped, or wrapped if the grid is toroidal.
+     * @tparam S Type of the stencil, i.e. Stencil or FixedStencil.
+     * @tparam F Type of the invoked function.
+     * @param pos Central point of the neighborhood.
+     * @param stencil Precomputed offsets of the neighborhood, e.g. Stencil::moore() or Stencil::fixedMoore<1>().
+     * @param f Function invocable with a position and a constant reference to a value. It may return bool, where false
+     * stops the iteration.
+     * @return False if the iteration was stopped by f, true otherwise.
+     */
+    template<StencilShape S, typename F> requires std::invocable<F, Point, const T&>
+    bool forEachNeighbor(Point pos, const S& stencil, F&& f) const;
+
     /**
      * Checks if given point is beyond the grid.
      * @param p Point to be checked.
@@ -112,28 +182,26 @@ public:
      * Gets with of the grid. Equivalent to the maximum x coordinate plus one.
      * @return Width of the grid.
      */
-    [[nodiscard]] int getWidth() const { return width; }
+    [[nodiscard]] int getWidth() const { return geometry.width(); }
 
     /**
      * Gets height of the grid. Equivalent to the maximum y coordinate plus one.
      * @return Height of the grid.
      */
-    [[nodiscard]] int getHeight() const { return height; }
+    [[nodiscard]] int getHeight() const { return geometry.height(); }
 
     /**
      * Checks if grid is wrapped (top edge is connected with bottom edge, and left edge is connected with right edge).
      * @return True if grid is representing wrapped space, false otherwise.
      */
-    [[nodiscard]] bool isToroidal() const { return toroidal; }
+    [[nodiscard]] bool isToroidal() const { return geometry.toroidal(); }
 
 private:
-    int width;
-    int height;
+    Geometry geometry;
 
     std::vector<T> read;
     std::vector<T> write;
-
-    bool toroidal;
+    ThreadPool* pool{};
 };
 
 using IntValueLayer = ValueLayer<int>;
@@ -7,61 +7,86 @@
 #include <functional>
 
 namespace agh {
-template<typename T>
-T ValueLayer<T>::get(const Point pos) const {
-    return read[pos.y * width + pos.x];
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
+T ValueLayer<T, E, Tp, L>::get(const Point pos) const {
+    return read[geometry.indexOf(pos)];
 }
 
-template<typename T>
-T ValueLayer<T>::getFromWrite(const Point pos) const {
-    return write[pos.y * width + pos.x];
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
+T ValueLayer<T, E, Tp, L>::getFromWrite(const Point pos) const {
+    return write[geometry.indexOf(pos)];
 }
 
-template<typename T>
-void ValueLayer<T>::set(const Point pos, T value) {
-    write[pos.y * width + pos.x] = value;
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
+void ValueLayer<T, E, Tp, L>::set(const Point pos, T value) {
+    write[geometry.indexOf(pos)] = value;
 }
 
-template<typename T>
-void ValueLayer<T>::setOnRead(const Point pos, T value) {
-    read[pos.y * width + pos.x] = value;
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
+void ValueLayer<T, E, Tp, L>::setOnRead(const Point pos, T value) {
+    read[geometry.indexOf(pos)] = value;
 }
 
-template<typename T>
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
 template<std::invocable<T&> F>
-void ValueLayer<T>::apply(F&& f) {
-    std::for_each(write.begin(), write.end(), f);
+void ValueLayer<T, E, Tp, L>::apply(F&& f) {
+    geometry.forEachCell([&](Point, const size_t cell) { std::invoke(f, write[cell]); });
 }
 
-template<typename T>
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
 template<std::invocable<Point, T&> F>
-void ValueLayer<T>::transform(F&& f) {
-    transformAll(write, std::forward<F>(f), width, height);
+void ValueLayer<T, E, Tp, L>::transform(F&& f) {
+    geometry.forEachCell([&](const Point p, const size_t cell) { std::invoke(f, p, write[cell]); });
 }
 
-template<typename T>
-std::vector<Point> ValueLayer<T>::getNeighborhood(
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
+template<ExecutionPolicy P, std::invocable<T&> F>
+void ValueLayer<T, E, Tp, L>::apply(P&&, F&& f) {
+    forEachChunk<P>(pool, write.size(), bulkCells, [&](const size_t begin, const size_t end) {
+        geometry.forEachCell(begin, end, [&](Point, const size_t cell) { std::invoke(f, write[cell]); });
+    });
+}
+
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
+template<ExecutionPolicy P, std::invocable<Point, T&> F>
+void ValueLayer<T, E, Tp, L>::transform(P&&, F&& f) {
+    forEachChunk<P>(pool, write.size(), bulkCells, [&](const size_t begin, const size_t end) {
+        geometry.forEachCell(begin, end, [&](const Point p, const size_t cell) { std::invoke(f, p, write[cell]); });
+    });
+}
+
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
+std::vector<Point> ValueLayer<T, E, Tp, L>::getNeighborhood(
     const Point pos, const int r, const bool moore, const bool center) const {
     return visitNeighborhood(*this, pos, r, moore, center, [](Point p) { return p; });
 }
 
-template<typename T>
-std::vector<T> ValueLayer<T>::getNeighbors(const Point pos, const int r, const bool moore, const bool center) const {
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
+std::vector<T> ValueLayer<T, E, Tp, L>::getNeighbors(
+    const Point pos, const int r, const bool moore, const bool center) const {
     return visitNeighborhood(*this, pos, r, moore, center, [&](const Point p) { return get(p); });
 }
 
-template<typename T>
-bool ValueLayer<T>::outOfBounds(const Point p) const {
-    return p.x < 0 || p.x >= width || p.y < 0 || p.y >= height;
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
+template<StencilShape S, typename F> requires std::invocable<F, Point, const T&>
+bool ValueLayer<T, E, Tp, L>::forEachNeighbor(const Point pos, const S& stencil, F&& f) const {
+    return forEachStencilCell(geometry, pos, stencil, [&](const Point p, const size_t cell) {
+        return invokeContinuing(f, p, read[cell]);
+    });
+}
+
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
+bool ValueLayer<T, E, Tp, L>::outOfBounds(const Point p) const {
+    return geometry.outOfBounds(p);
 }
 
-template<typename T>
-Point ValueLayer<T>::toToroidal(const Point p) const {
-    return convertToToroidal(p, width, height);
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
+Point ValueLayer<T, E, Tp, L>::toToroidal(const Point p) const {
+    return geometry.toToroidal(p);
 }
 
-template<typename T>
-void ValueLayer<T>::swap() {
+template<typename T, GridExtent E, GridTopology Tp, GridLayout L>
+void ValueLayer<T, E, Tp, L>::swap() {
     read.swap(write);
 }
 }
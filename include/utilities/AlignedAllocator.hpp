@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace agh {
+/**
+ * Allocator returning memory aligned to the given boundary, e.g. to a cache line, so that arrays of numbers can be
+ * processed with aligned SIMD loads.
+ * @tparam T Type of the allocated objects.
+ * @tparam Alignment Alignment of the returned memory in bytes. It must be a power of two.
+ */
+template<typename T, size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    explicit AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(const size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* pointer, const size_t n) noexcept {
+        ::operator delete(pointer, n * sizeof(T), std::align_val_t{Alignment});
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return true;
+    }
+};
+}
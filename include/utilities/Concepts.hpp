@@ -1,9 +1,14 @@
 #pragma once
 
 #include <concepts>
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <optional>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <type_traits>
 
 #include "../space/Point.hpp"
 
@@ -40,11 +45,43 @@ concept Schedulable = requires(A a, M m) {
     a.step(m);
 } && ActiveAgent<A>;
 
+template<typename A, typename M, typename P = A*>
+concept BatchSchedulable = requires(std::span<P> agents, M m) {
+    A::stepBatch(agents, m);
+} && Schedulable<A, M>;
+
 template<typename A, typename M>
 concept Advanceable = requires(A a, M m) {
   a.advance(m);
 };
 
+template<typename A, typename M>
+concept RateBased = requires(A a, M m) {
+    { a.rate(m) } -> std::convertible_to<double>;
+};
+
+template<typename T>
+concept SoaAgent = ActiveAgent<T> && std::default_initializable<T> && requires {
+    std::tuple_size<std::remove_cvref_t<decltype(T::members)>>::value;
+};
+
+template<typename M>
+concept Deferring = requires(M m) {
+    m.flushCommands();
+    { m.commands().nextSerial() } -> std::convertible_to<uint64_t>;
+};
+
+template<typename M>
+concept EpochAware = requires(M m, size_t epoch) {
+    m.setEpoch(epoch);
+};
+
+template<typename S>
+concept StencilShape = requires(const S s) {
+    { s.radius() } -> std::convertible_to<int>;
+    { *std::ranges::begin(s.offsets()) } -> std::convertible_to<Point>;
+};
+
 template<typename M>
 concept SimState = requires(M m) {
     m.beforeStep();
@@ -0,0 +1,21 @@
+#pragma once
+
+// Kept apart from Concepts.hpp, since libstdc++ implements parallel policies with TBB when its headers are installed,
+// and programs including <execution> then have to link TBB. Only headers offering policy overloads include it.
+#include <execution>
+#include <type_traits>
+
+namespace agh {
+template<typename P>
+concept ExecutionPolicy = std::is_execution_policy_v<std::remove_cvref_t<P>>;
+
+/**
+ * Checks if the execution policy allows running the work on multiple threads, i.e. it is std::execution::par or
+ * std::execution::par_unseq.
+ * @tparam P Type of the execution policy.
+ */
+template<typename P>
+inline constexpr bool isParallelPolicy =
+    std::is_same_v<std::remove_cvref_t<P>, std::execution::parallel_policy> ||
+    std::is_same_v<std::remove_cvref_t<P>, std::execution::parallel_unsequenced_policy>;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+
+namespace agh {
+/**
+ * Philox4x32-10 counter-based generator. Every 128-bit counter is mapped to four independent 32-bit values by ten
+ * rounds of a keyed bijection, so any part of the sequence can be computed without generating the preceding values.
+ */
+struct Philox {
+    using Counter = std::array<uint32_t, 4>;
+    using Key = std::array<uint32_t, 2>;
+
+    static constexpr uint64_t multiplier0 = 0xD2511F53;
+    static constexpr uint64_t multiplier1 = 0xCD9E8D57;
+    static constexpr uint32_t weyl0 = 0x9E3779B9;
+    static constexpr uint32_t weyl1 = 0xBB67AE85;
+    static constexpr int rounds = 10;
+
+    /**
+     * Computes block of random values for the given counter and key.
+     * @param counter Counter of the block.
+     * @param key Key selecting the permutation.
+     * @return Four random 32-bit values.
+     */
+    static constexpr Counter generate(Counter counter, Key key);
+};
+
+/**
+ * Returns random integer from [0, bound) without modulo bias. Unlike std::uniform_int_distribution, whose results are
+ * implementation-defined, it uses Lemire's multiply-shift method on the 32 low bits of the generated values, so the
+ * results are the same on every platform.
+ * @tparam G Type of the generator. Its values must cover the whole range of 32-bit or 64-bit unsigned integers.
+ * @param rng Generator of the random values.
+ * @param bound Upper bound of the range. It must be positive.
+ * @return Uniformly distributed value.
+ */
+template<std::uniform_random_bit_generator G>
+constexpr uint32_t randomBelow(G& rng, uint32_t bound);
+
+/**
+ * Stream of random values, identified by a seed, a stream id and an epoch. Streams with different identifiers are
+ * statistically independent, and a stream produces the same values regardless of the thread which uses it. It meets
+ * UniformRandomBitGenerator requirements, so it can be used with distributions from the standard library.
+ */
+class RandomStream {
+public:
+    using result_type = uint32_t;
+
+    /**
+     * Number of values produced before the 32-bit block counter wraps and the stream repeats itself. Longer sequences
+     * should continue with the stream of another epoch or id.
+     */
+    static constexpr uint64_t period = uint64_t{4} << 32;
+
+    /**
+     * Creates stream for the given identifiers. Only the lower 32 bits of the epoch are used.
+     * @param seed Seed of the simulation.
+     * @param id Id of the stream, e.g. id of the agent using it.
+     * @param epoch Time step in which the stream is used.
+     */
+    constexpr RandomStream(uint64_t seed, uint64_t id, uint64_t epoch);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    /**
+     * Returns next random value.
+     * @return Uniformly distributed 32-bit value.
+     */
+    constexpr result_type operator()();
+
+    /**
+     * Returns random floating point value from [0, 1), built from two consecutive 32-bit values.
+     * @return Uniformly distributed value with 53 random bits.
+     */
+    constexpr double uniform();
+
+    /**
+     * Returns random floating point value from [low, high).
+     * @param low Lower bound of the range.
+     * @param high Upper bound of the range.
+     * @return Uniformly distributed value.
+     */
+    constexpr double uniform(double low, double high);
+
+    /**
+     * Returns random integer from [0, bound) without modulo bias.
+     * @param bound Upper bound of the range. It must be positive.
+     * @return Uniformly distributed value.
+     */
+    constexpr uint32_t below(uint32_t bound);
+
+    /**
+     * Fills the span with consecutive values of the stream. Values are the same as those returned by subsequent calls
+     * of the call operator, but blocks are generated eight at a time in element-wise loops, which the compiler can
+     * vectorize.
+     * @param out Span to fill.
+     */
+    void fill(std::span<uint32_t> out);
+
+    /**
+     * Fills the span with random floating point values from [0, 1). Values are the same as those returned by
+     * subsequent calls of uniform.
+     * @param out Span to fill.
+     */
+    void fillUniform(std::span<double> out);
+
+private:
+    Philox::Key key;
+    Philox::Counter counter;
+    Philox::Counter buffer{};
+    size_t next{4};
+
+    static constexpr double toUnit(uint32_t high, uint32_t low);
+};
+
+/**
+ * Source of random streams for the whole simulation. It is meant to be stored in the model, and every agent should
+ * draw from its own stream, e.g. model.random.stream(agent.id, epoch). Since streams are computed from their
+ * identifiers instead of a shared state, they can be used by many threads without synchronization, and results don't
+ * depend on the number of threads.
+ */
+class Random {
+public:
+    /**
+     * Creates source with the given seed.
+     * @param pSeed Seed of the simulation.
+     */
+    explicit constexpr Random(const uint64_t pSeed = 0) : seed(pSeed) {}
+
+    /**
+     * Creates stream for the given id and epoch.
+     * @param id Id of the stream, e.g. id of the agent using it.
+     * @param epoch Time step in which the stream is used.
+     * @return Stream of random values.
+     */
+    [[nodiscard]] constexpr RandomStream stream(const uint64_t id, const uint64_t epoch) const {
+        return {seed, id, epoch};
+    }
+
+    /**
+     * Returns seed of the source.
+     * @return Seed of the simulation.
+     */
+    [[nodiscard]] constexpr uint64_t getSeed() const { return seed; }
+
+private:
+    uint64_t seed;
+};
+}
+
+#include "RandomImpl.hpp"
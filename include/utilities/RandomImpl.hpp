@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+
+namespace agh {
+constexpr Philox::Counter Philox::generate(Counter counter, Key key) {
+    for (int round = 0; round < rounds; ++round) {
+        const uint64_t product0 = multiplier0 * counter[0];
+        const uint64_t product1 = multiplier1 * counter[2];
+        counter = {
+            static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+            static_cast<uint32_t>(product1),
+            static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+            static_cast<uint32_t>(product0)
+        };
+        key[0] += weyl0;
+        key[1] += weyl1;
+    }
+    return counter;
+}
+
+constexpr RandomStream::RandomStream(const uint64_t seed, const uint64_t id, const uint64_t epoch)
+    : key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)},
+      counter{0, static_cast<uint32_t>(epoch), static_cast<uint32_t>(id), static_cast<uint32_t>(id >> 32)} {}
+
+constexpr RandomStream::result_type RandomStream::operator()() {
+    if (next == buffer.size()) {
+        buffer = Philox::generate(counter, key);
+        counter[0] += 1;
+        next = 0;
+    }
+    return buffer[next++];
+}
+
+constexpr double RandomStream::uniform() {
+    const uint32_t high = (*this)();
+    return toUnit(high, (*this)());
+}
+
+constexpr double RandomStream::uniform(const double low, const double high) {
+    return low + (high - low) * uniform();
+}
+
+template<std::uniform_random_bit_generator G>
+constexpr uint32_t randomBelow(G& rng, const uint32_t bound) {
+    static_assert(G::min() == 0 && (G::max() == std::numeric_limits<uint32_t>::max() ||
+                                    G::max() == std::numeric_limits<uint64_t>::max()),
+                  "The generator must produce full-range 32-bit or 64-bit values.");
+    // Lemire's multiply-shift method, which rejects only the values falling into the biased remainder.
+    uint64_t product = static_cast<uint64_t>(static_cast<uint32_t>(rng())) * bound;
+    if (static_cast<uint32_t>(product) < bound) {
+        const uint32_t threshold = -bound % bound;
+        while (static_cast<uint32_t>(product) < threshold) {
+            product = static_cast<uint64_t>(static_cast<uint32_t>(rng())) * bound;
+        }
+    }
+    return static_cast<uint32_t>(product >> 32);
+}
+
+constexpr uint32_t RandomStream::below(const uint32_t bound) {
+    return randomBelow(*this, bound);
+}
+
+inline void RandomStream::fill(std::span<uint32_t> out) {
+    size_t i = 0;
+    while (i < out.size() && next < buffer.size()) {
+        out[i++] = buffer[next++];
+    }
+
+    // Lanes of eight blocks are kept in separate arrays, so every round is an element-wise loop the compiler can
+    // turn into vector instructions.
+    constexpr size_t lanes = 8;
+    const size_t groups = (out.size() - i) / (4 * lanes);
+    for (size_t g = 0; g < groups; ++g, i += 4 * lanes) {
+        std::array<uint32_t, lanes> c0, c1, c2, c3;
+        for (size_t l = 0; l < lanes; ++l) {
+            c0[l] = counter[0] + static_cast<uint32_t>(l);
+            c1[l] = counter[1];
+            c2[l] = counter[2];
+            c3[l] = counter[3];
+        }
+        Philox::Key k = key;
+        for (int round = 0; round < Philox::rounds; ++round) {
+            for (size_t l = 0; l < lanes; ++l) {
+                const uint64_t product0 = Philox::multiplier0 * c0[l];
+                const uint64_t product1 = Philox::multiplier1 * c2[l];
+                c0[l] = static_cast<uint32_t>(product1 >> 32) ^ c1[l] ^ k[0];
+                c1[l] = static_cast<uint32_t>(product1);
+                c2[l] = static_cast<uint32_t>(product0 >> 32) ^ c3[l] ^ k[1];
+                c3[l] = static_cast<uint32_t>(product0);
+            }
+            k[0] += Philox::weyl0;
+            k[1] += Philox::weyl1;
+        }
+        for (size_t l = 0; l < lanes; ++l) {
+            out[i + 4 * l] = c0[l];
+            out[i + 4 * l + 1] = c1[l];
+            out[i + 4 * l + 2] = c2[l];
+            out[i + 4 * l + 3] = c3[l];
+        }
+        counter[0] += lanes;
+    }
+
+    while (i < out.size()) {
+        out[i++] = (*this)();
+    }
+}
+
+inline void RandomStream::fillUniform(std::span<double> out) {
+    std::array<uint32_t, 512> bits;
+    for (size_t i = 0; i < out.size();) {
+        const size_t count = std::min(bits.size() / 2, out.size() - i);
+        fill(std::span(bits.data(), 2 * count));
+        for (size_t j = 0; j < count; ++j) {
+            out[i + j] = toUnit(bits[2 * j], bits[2 * j + 1]);
+        }
+        i += count;
+    }
+}
+
+constexpr double RandomStream::toUnit(const uint32_t high, const uint32_t low) {
+    const uint64_t mantissa = (static_cast<uint64_t>(high >> 5) << 26) | (low >> 6);
+    return static_cast<double>(mantissa) * 0x1.0p-53;
+}
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace agh {
+/**
+ * Pointer to an object of one of the given types. Index of the type is kept in the low bits of the address, which are
+ * always zero because of the alignment of the types, so the pointer is stored in a single word. If the alignment of
+ * any type is too low, the index is kept in a separate byte instead. Null pointer is represented by zero.
+ * @tparam Ts Types of the pointed objects. There may be at most 256 of them.
+ */
+template<typename... Ts>
+class TaggedPointer {
+public:
+    /**
+     * Number of the low bits holding index of the type.
+     */
+    static constexpr size_t tagBits = std::bit_width(sizeof...(Ts) - 1);
+
+    static_assert(tagBits <= 8, "index of the type must fit in a byte");
+
+    /**
+     * Checks if index of the type is kept in the low bits of the address, i.e. the alignment of every type leaves
+     * enough of them.
+     */
+    static constexpr bool packed = ((alignof(Ts) >= (size_t{1} << tagBits)) && ...);
+
+    /**
+     * Creates null pointer.
+     */
+    TaggedPointer() = default;
+
+    /**
+     * Creates pointer to the given object.
+     * @tparam T Type of the object.
+     * @param object Pointer to the object. It may be null.
+     */
+    template<typename T> requires (std::is_same_v<T, Ts> || ...)
+    explicit TaggedPointer(T* object) {
+        if constexpr (packed) {
+            bits = object ? reinterpret_cast<uintptr_t>(object) | indexOf<T>() : 0;
+        }
+        else {
+            bits = reinterpret_cast<uintptr_t>(object);
+            tag = object ? static_cast<uint8_t>(indexOf<T>()) : 0;
+        }
+    }
+
+    /**
+     * Creates pointer from the variant of pointers.
+     * @param object Pointer to the object. It may be null.
+     */
+    explicit TaggedPointer(const std::variant<Ts*...>& object)
+        : TaggedPointer(std::visit([](auto* pointer) { return TaggedPointer(pointer); }, object)) {}
+
+    /**
+     * Returns index of the type of the pointed object.
+     * @return Index of the type among Ts.
+     */
+    [[nodiscard]] size_t index() const {
+        if constexpr (packed) return bits & mask;
+        else return tag;
+    }
+
+    /**
+     * Returns pointer to the object, if it is of type T.
+     * @tparam T Type of the object.
+     * @return Pointer to the object, or nullptr if it is null or of another type.
+     */
+    template<typename T> requires (std::is_same_v<T, Ts> || ...)
+    [[nodiscard]] T* get() const {
+        return bits && index() == indexOf<T>() ? reinterpret_cast<T*>(address()) : nullptr;
+    }
+
+    /**
+     * Calls f with pointer of the proper type to the object. The pointer must not be null.
+     * @tparam F Type of the callable. It must be invocable with a pointer to every type.
+     * @param f Callable invoked with the pointer.
+     * @return Value returned by f.
+     */
+    template<typename F>
+    decltype(auto) visit(F&& f) const;
+
+    /**
+     * Converts pointer to the variant of pointers. The pointer must not be null.
+     * @return Variant holding pointer of the proper type.
+     */
+    [[nodiscard]] std::variant<Ts*...> variant() const {
+        return visit([](auto* object) { return std::variant<Ts*...>(object); });
+    }
+
+    explicit operator bool() const { return bits != 0; }
+
+    bool operator==(const TaggedPointer&) const = default;
+
+private:
+    static constexpr uintptr_t mask = packed ? (uintptr_t{1} << tagBits) - 1 : 0;
+
+    struct NoTag {
+        bool operator==(const NoTag&) const = default;
+    };
+
+    uintptr_t bits{};
+    [[no_unique_address]] std::conditional_t<packed, NoTag, uint8_t> tag{};
+
+    [[nodiscard]] uintptr_t address() const { return bits & ~mask; }
+
+    template<typename T>
+    static constexpr uintptr_t indexOf() {
+        uintptr_t index = 0;
+        (void)((std::is_same_v<T, Ts> || (++index, false)) || ...);
+        return index;
+    }
+};
+
+template<typename... Ts>
+template<typename F>
+decltype(auto) TaggedPointer<Ts...>::visit(F&& f) const {
+    using R = std::invoke_result_t<F, std::tuple_element_t<0, std::tuple<Ts*...>>>;
+    if constexpr (sizeof...(Ts) == 1) {
+        return std::invoke(std::forward<F>(f), reinterpret_cast<Ts*>(bits)...);
+    }
+    else {
+        return [&]<size_t... I>(std::index_sequence<I...>) -> R {
+            constexpr R (*dispatch[])(uintptr_t, F&) = {[](const uintptr_t address, F& g) -> R {
+                return std::invoke(g, reinterpret_cast<std::tuple_element_t<I, std::tuple<Ts*...>>>(address));
+            }...};
+            return dispatch[index()](address(), f);
+        }(std::index_sequence_for<Ts...>{});
+    }
+}
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace agh {
+/**
+ * Pool of worker threads executing chunks of index ranges. Every thread has its own queue of chunks, and threads which
+ * run out of work steal chunks from the others. The thread calling parallelFor takes part in the computation, so the
+ * pool of size n starts only n - 1 additional threads.
+ */
+class ThreadPool {
+public:
+    /**
+     * Creates pool with given number of threads, including the calling one.
+     * @param threads Number of threads executing the work. Value 0 is treated like 1.
+     */
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Stops and joins all worker threads.
+     */
+    ~ThreadPool();
+
+    /**
+     * Returns number of threads executing the work, including the calling one.
+     * @return Number of threads.
+     */
+    [[nodiscard]] size_t size() const { return queues.size(); }
+
+    /**
+     * Splits range [begin, end) into chunks of at most grain indices and calls f(chunkBegin, chunkEnd) for every chunk.
+     * Returns after all chunks are processed. If any invocation throws, the first exception is rethrown.
+     * @tparam F Type of the invoked function.
+     * @param begin First index of the range.
+     * @param end One past the last index of the range.
+     * @param grain Maximal number of indices in one chunk. Value 0 is treated like 1.
+     * @param f Function invocable with two indices, bounding processed chunk.
+     */
+    template<typename F>
+    void parallelFor(size_t begin, size_t end, size_t grain, F&& f);
+
+    /**
+     * Returns index of the current thread in the pool that runs it. Threads which do not belong to any pool have index
+     * 0, like the thread calling parallelFor.
+     * @return Index of the current thread, lower than size() of its pool.
+     */
+    [[nodiscard]] static size_t threadIndex() { return currentIndex; }
+
+private:
+    struct Job {
+        void (*invoke)(void*, size_t, size_t);
+        void* function;
+        std::atomic<size_t> remaining;
+        std::exception_ptr error;
+        std::mutex errorMutex;
+    };
+
+    struct Task {
+        Job* job;
+        size_t begin;
+        size_t end;
+    };
+
+    // Chunks are taken from both ends, but the vector is only cleared once it is drained, so its storage is reused by
+    // subsequent calls of parallelFor.
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::vector<Task> tasks;
+        size_t head{};
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::mutex doneMutex;
+    std::condition_variable done;
+    std::atomic<size_t> pending{0};
+    bool stop{false};
+
+    static inline thread_local size_t currentIndex{0};
+    static inline thread_local const ThreadPool* currentPool{nullptr};
+
+    template<typename F>
+    static void invoker(void* function, size_t begin, size_t end);
+
+    void run(Job& job, size_t begin, size_t end, size_t grain, size_t chunks);
+    void work(size_t index);
+    bool tryRun(size_t index);
+    bool pop(size_t index, Task& task);
+    void execute(const Task& task);
+};
+}
+
+#include "ThreadPoolImpl.hpp"
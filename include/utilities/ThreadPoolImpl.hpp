@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+namespace agh {
+inline ThreadPool::ThreadPool(size_t threads) {
+    threads = std::max<size_t>(threads, 1);
+    queues.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+
+    workers.reserve(threads - 1);
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back([this, i] { work(i); });
+    }
+}
+
+inline ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(sleepMutex);
+        stop = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+template<typename F>
+void ThreadPool::parallelFor(const size_t begin, const size_t end, size_t grain, F&& f) {
+    if (begin >= end) {
+        return;
+    }
+
+    grain = std::max<size_t>(grain, 1);
+    const size_t chunks = (end - begin + grain - 1) / grain;
+    if (chunks == 1 || size() == 1) {
+        for (size_t b = begin; b < end; b += std::min(grain, end - b)) {
+            std::invoke(f, b, b + std::min(grain, end - b));
+        }
+        return;
+    }
+
+    Job job{&invoker<std::remove_reference_t<F>>, static_cast<void*>(std::addressof(f)), chunks, nullptr, {}};
+    run(job, begin, end, grain, chunks);
+
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
+
+template<typename F>
+void ThreadPool::invoker(void* function, const size_t begin, const size_t end) {
+    std::invoke(*static_cast<F*>(function), begin, end);
+}
+
+inline void ThreadPool::run(Job& job, const size_t begin, const size_t end, const size_t grain, const size_t chunks) {
+    const size_t self = currentPool == this ? currentIndex : 0;
+
+    // Every thread gets a contiguous block of chunks, starting with the calling one.
+    size_t chunk = 0;
+    for (size_t i = 0; i < size(); ++i) {
+        const size_t last = chunks * (i + 1) / size();
+        auto& queue = *queues[(self + i) % size()];
+        std::lock_guard lock(queue.mutex);
+        for (; chunk < last; ++chunk) {
+            const size_t b = begin + chunk * grain;
+            queue.tasks.push_back(Task{&job, b, std::min(b + grain, end)});
+        }
+    }
+
+    {
+        std::lock_guard lock(sleepMutex);
+        pending += chunks;
+    }
+    wake.notify_all();
+
+    while (job.remaining.load(std::memory_order_acquire) > 0) {
+        if (!tryRun(self)) {
+            std::unique_lock lock(doneMutex);
+            done.wait(lock, [&] { return job.remaining.load(std::memory_order_acquire) == 0; });
+        }
+    }
+}
+
+inline void ThreadPool::work(const size_t index) {
+    currentIndex = index;
+    currentPool = this;
+    while (true) {
+        if (tryRun(index)) {
+            continue;
+        }
+
+        std::unique_lock lock(sleepMutex);
+        wake.wait(lock, [&] { return stop || pending.load() > 0; });
+        if (stop) {
+            return;
+        }
+    }
+}
+
+inline bool ThreadPool::tryRun(const size_t index) {
+    Task task{};
+    if (!pop(index, task)) {
+        return false;
+    }
+    execute(task);
+    return true;
+}
+
+inline bool ThreadPool::pop(const size_t index, Task& task) {
+    for (size_t i = 0; i < size(); ++i) {
+        auto& queue = *queues[(index + i) % size()];
+        std::lock_guard lock(queue.mutex);
+        if (queue.head == queue.tasks.size()) {
+            continue;
+        }
+
+        // Own chunks are taken from the front to keep them in order, stolen ones from the back.
+        if (i == 0) {
+            task = queue.tasks[queue.head];
+            queue.head += 1;
+        }
+        else {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        }
+        if (queue.head == queue.tasks.size()) {
+            queue.tasks.clear();
+            queue.head = 0;
+        }
+        pending -= 1;
+        return true;
+    }
+    return false;
+}
+
+inline void ThreadPool::execute(const Task& task) {
+    Job& job = *task.job;
+    try {
+        job.invoke(job.function, task.begin, task.end);
+    }
+    catch (...) {
+        std::lock_guard lock(job.errorMutex);
+        if (!job.error) {
+            job.error = std::current_exception();
+        }
+    }
+
+    // The job may be destroyed by its owner as soon as the counter drops to zero, so it is not touched afterwards.
+    if (job.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard lock(doneMutex);
+        done.notify_all();
+    }
+}
+}
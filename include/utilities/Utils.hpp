@@ -1,11 +1,19 @@
 #pragma once
 
 #include "Concepts.hpp"
+#include "Execution.hpp"
+#include "ThreadPool.hpp"
+#include "../space/GridGeometry.hpp"
 #include "../space/Point.hpp"
+#include "../space/Stencil.hpp"
 
+#include <array>
 #include <cmath>
 #include <concepts>
 #include <functional>
+#include <optional>
+#include <type_traits>
+#include <variant>
 #include <vector>
 
 namespace agh {
@@ -23,7 +31,49 @@ concept Grid = requires(T t) {
     { t.toToroidal(Point{}) } -> std::same_as<Point>;
 };
 
-template<Grid T, std::invocable<Point> F>
+template<typename T>
+concept SizedGrid = Grid<T> && requires(T t) {
+    { t.getWidth() } -> std::same_as<int>;
+    { t.getHeight() } -> std::same_as<int>;
+};
+
+// Checks if all cells within Chebyshev distance r from the point are inside the grid.
+inline bool isInterior(const Point p, const int r, const int width, const int height) {
+    return p.x >= r && p.x < width - r && p.y >= r && p.y < height - r;
+}
+
+// Wraps coordinate at most one size beyond the grid, which is cheaper than the modulo of convertToToroidal.
+inline int wrapOnce(const int c, const int size) {
+    return c < 0 ? c + size : c >= size ? c - size : c;
+}
+
+// Calls f with every point of the neighborhood in row order. The bounds are checked only if the neighborhood crosses
+// the border of the grid, and points beyond it are wrapped without the modulo if the radius doesn't exceed the grid.
+template<SizedGrid T, std::invocable<Point> F>
+void forEachNeighborhoodPoint(const T& layer, const Point pos, const int r, const bool moore,
+                              const bool center, F&& f) {
+    const int width = layer.getWidth();
+    const int height = layer.getHeight();
+    const bool interior = isInterior(pos, r, width, height);
+    const bool wrap = layer.isToroidal();
+    const bool near = r <= width && r <= height;
+    for (int dy = -r; dy <= r; ++dy) {
+        const int span = moore ? r : r - std::abs(dy);
+        for (int dx = -span; dx <= span; ++dx) {
+            if (!center && dx == 0 && dy == 0) continue;
+
+            Point p = {pos.x + dx, pos.y + dy};
+
+            if (!interior && (p.x < 0 || p.x >= width || p.y < 0 || p.y >= height)) {
+                if (!wrap) continue;
+                p = near ? Point{wrapOnce(p.x, width), wrapOnce(p.y, height)} : layer.toToroidal(p);
+            }
+            std::invoke(f, p);
+        }
+    }
+}
+
+template<SizedGrid T, std::invocable<Point> F>
 auto visitNeighborhood(const T& layer, const Point pos, const int r, const bool moore,
                        const bool center, F&& f) -> std::vector<std::invoke_result_t<F, Point>> {
     std::vector<std::invoke_result_t<F, Point>> result;
@@ -33,30 +83,14 @@ auto visitNeighborhood(const T& layer, const Point pos, const int r, const bool
     else {
         result.reserve(r * r + (r + 1) * (r + 1));
     }
-    for (int dy = -r; dy <= r; ++dy) {
-        for (int dx = -r; dx <= r; ++dx) {
-            if (!moore && std::abs(dx) + std::abs(dy) > r) continue;
-
-            Point p = {pos.x + dx, pos.y + dy};
-
-            if (p == pos && !center) continue;
-
-            if (layer.outOfBounds(p)) {
-                if (layer.isToroidal()) {
-                    p = layer.toToroidal(p);
-                    result.push_back(std::invoke(std::forward<F>(f), p));
-                }
-            }
-            else {
-                result.push_back(std::invoke(std::forward<F>(f), p));
-            }
-        }
-    }
+    forEachNeighborhoodPoint(layer, pos, r, moore, center, [&](const Point p) {
+        result.push_back(std::invoke(f, p));
+    });
 
     return result;
 }
 
-template<Grid T, typename A, std::invocable<Point, std::vector<A>&> F>
+template<SizedGrid T, typename A, std::invocable<Point, std::vector<A>&> F>
 auto visitNeighbors(const T& layer, const Point pos, const int r, const bool moore,
                     const bool center, F&& f) -> std::vector<A> {
     std::vector<A> result;
@@ -66,27 +100,125 @@ auto visitNeighbors(const T& layer, const Point pos, const int r, const bool moo
     else {
         result.reserve(r * r + (r + 1) * (r + 1));
     }
-    for (int dy = -r; dy <= r; ++dy) {
-        for (int dx = -r; dx <= r; ++dx) {
-            if (!moore && std::abs(dx) + std::abs(dy) > r) continue;
+    forEachNeighborhoodPoint(layer, pos, r, moore, center, [&](const Point p) { std::invoke(f, p, result); });
 
-            Point p = {pos.x + dx, pos.y + dy};
+    return result;
+}
 
-            if (p == pos && !center) continue;
+template<typename F, typename... Args>
+bool invokeContinuing(F&& f, Args&&... args) {
+    if constexpr (std::same_as<std::invoke_result_t<F, Args...>, bool>) {
+        return std::invoke(std::forward<F>(f), std::forward<Args>(args)...);
+    }
+    else {
+        std::invoke(std::forward<F>(f), std::forward<Args>(args)...);
+        return true;
+    }
+}
 
-            if (layer.outOfBounds(p)) {
-                if (layer.isToroidal()) {
-                    p = layer.toToroidal(p);
-                    std::invoke(std::forward<F>(f), p, result);
+// Radius of the stencils for which forEachStencilCell computes column parts of the indexes once per call, on the stack.
+inline constexpr int maxCachedRadius = 8;
+
+template<typename G, StencilShape S, std::invocable<Point, size_t> F>
+bool forEachStencilCell(const G& geometry, const Point pos, const S& stencil, F&& f) {
+    const int width = geometry.width();
+    const int height = geometry.height();
+    const int r = stencil.radius();
+    if (isInterior(pos, r, width, height)) {
+        if constexpr (std::same_as<typename G::Layout, RowMajor>) {
+            const ptrdiff_t center = static_cast<ptrdiff_t>(pos.y) * width + pos.x;
+            for (const Point offset : stencil.offsets()) {
+                const size_t cell = center + static_cast<ptrdiff_t>(offset.y) * width + offset.x;
+                if (!invokeContinuing(f, Point{pos.x + offset.x, pos.y + offset.y}, cell)) return false;
+            }
+        }
+        else if (r <= maxCachedRadius) {
+            std::array<size_t, 2 * maxCachedRadius + 1> columns;
+            for (int dx = -r; dx <= r; ++dx) {
+                columns[dx + r] = geometry.column(pos.x + dx);
+            }
+            int y = pos.y - r - 1;
+            size_t row = 0;
+            for (const Point offset : stencil.offsets()) {
+                if (pos.y + offset.y != y) {
+                    y = pos.y + offset.y;
+                    row = geometry.row(y);
                 }
+                if (!invokeContinuing(f, Point{pos.x + offset.x, y}, row + columns[offset.x + r])) return false;
             }
-            else {
-                std::invoke(std::forward<F>(f), p, result);
+        }
+        else {
+            for (const Point offset : stencil.offsets()) {
+                const Point p{pos.x + offset.x, pos.y + offset.y};
+                if (!invokeContinuing(f, p, geometry.indexOf(p))) return false;
             }
         }
+        return true;
     }
 
-    return result;
+    const bool wrap = geometry.toroidal();
+    const bool near = r <= width && r <= height;
+    for (const Point offset : stencil.offsets()) {
+        Point p{pos.x + offset.x, pos.y + offset.y};
+        if (p.x < 0 || p.x >= width || p.y < 0 || p.y >= height) {
+            if (!wrap) continue;
+            p = near ? Point{wrapOnce(p.x, width), wrapOnce(p.y, height)} : geometry.toToroidal(p);
+        }
+        if (!invokeContinuing(f, p, geometry.indexOf(p))) return false;
+    }
+    return true;
+}
+
+template<Grid T, std::predicate<Point> F>
+std::optional<Point> spiralSearch(const T& layer, const Point pos, const int maxRadius, F&& accept) {
+    auto resolve = [&](Point p) -> std::optional<Point> {
+        if (layer.outOfBounds(p)) {
+            if (!layer.isToroidal()) return std::nullopt;
+            p = layer.toToroidal(p);
+        }
+        return std::invoke(accept, p) ? std::optional(p) : std::nullopt;
+    };
+
+    if (auto found = resolve(pos)) return found;
+    for (int r = 1; r <= maxRadius; ++r) {
+        for (int dx = -r; dx <= r; ++dx) {
+            for (const int dy : {-r, r}) {
+                if (auto found = resolve({pos.x + dx, pos.y + dy})) return found;
+            }
+        }
+        for (int dy = -r + 1; dy < r; ++dy) {
+            for (const int dx : {-r, r}) {
+                if (auto found = resolve({pos.x + dx, pos.y + dy})) return found;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+// Number of cells processed by one thread at a time by parallel apply and transform of the grid spaces.
+inline constexpr size_t bulkCells = 16384;
+
+// Calls f(begin, end) for chunks of at most grain indices covering [0, count), concurrently on the pool if it exists
+// and the policy is parallel, or at once on the calling thread otherwise.
+template<ExecutionPolicy P, typename F>
+void forEachChunk(ThreadPool* pool, const size_t count, const size_t grain, F&& f) {
+    if (pool && isParallelPolicy<P>) {
+        pool->parallelFor(0, count, grain, std::forward<F>(f));
+    }
+    else if (count > 0) {
+        std::invoke(f, size_t{0}, count);
+    }
+}
+
+// Calls f with the pointer held by the variant. Variants of a single pointer type skip the dispatch of std::visit.
+template<typename F, typename... Ts>
+decltype(auto) visitPointer(F&& f, const std::variant<Ts*...>& agent) {
+    if constexpr (sizeof...(Ts) == 1) {
+        return std::invoke(std::forward<F>(f), *std::get_if<0>(&agent));
+    }
+    else {
+        return std::visit(std::forward<F>(f), agent);
+    }
 }
 
 template<typename T, std::invocable<T&> F>
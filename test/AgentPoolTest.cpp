@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <vector>
+
+#include "../include/model/AgentPool.hpp"
+#include "../include/model/Model.hpp"
+
+namespace test::agent_pool {
+struct Agent {
+    explicit Agent(const int pId) : id(pId) {}
+    int id;
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+};
+
+struct BigAgent {
+    std::array<char, 600> data{};
+    int id{};
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+};
+
+struct Counted {
+    static inline int alive = 0;
+
+    Counted() { alive += 1; }
+    Counted(const Counted&) { alive += 1; }
+    ~Counted() { alive -= 1; }
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+};
+
+struct PoolModel : agh::Model<Agent, BigAgent> {};
+
+TEST(AgentPoolTest, RemoveAgentReusesAddress) {
+    PoolModel model;
+    model.emplaceAgent<Agent>(1);
+    auto& second = model.emplaceAgent<Agent>(2);
+    model.emplaceAgent<Agent>(3);
+    model.emplaceAgent<BigAgent>();
+
+    model.removeAgent(second);
+    EXPECT_EQ(model.agentCount(), 3);
+    EXPECT_EQ(model.agentCount<Agent>(), 2);
+
+    std::vector<int> ids;
+    for (const auto& agent : model.getAgents<Agent>()) {
+        ids.push_back(agent.id);
+    }
+    EXPECT_EQ(ids, (std::vector<int>{1, 3}));
+
+    auto& fourth = model.emplaceAgent<Agent>(4);
+    EXPECT_EQ(&fourth, &second);
+    EXPECT_EQ(model.getAgents<Agent>()[1].id, 4);
+    EXPECT_EQ(model.agentCount<Agent>(), 3);
+}
+
+TEST(AgentPoolTest, IterationSkipsFreeSlots) {
+    agh::AgentPool<Agent> pool;
+    std::vector<Agent*> agents;
+    for (int i = 0; i < 5000; ++i) {
+        agents.push_back(&pool.emplace(i));
+    }
+    for (int i = 0; i < 5000; ++i) {
+        if (i % 3 != 0 || (i >= 640 && i < 1280)) {
+            pool.erase(*agents[i]);
+        }
+    }
+
+    std::vector<int> expected;
+    for (int i = 0; i < 5000; i += 3) {
+        if (i < 640 || i >= 1280) {
+            expected.push_back(i);
+        }
+    }
+    std::vector<int> ids;
+    for (const auto& agent : std::as_const(pool)) {
+        ids.push_back(agent.id);
+    }
+    EXPECT_EQ(ids, expected);
+    EXPECT_EQ(pool.size(), expected.size());
+    EXPECT_EQ(pool.slots(), 5000);
+    EXPECT_FALSE(pool.occupied(1));
+    EXPECT_TRUE(pool.occupied(3));
+    EXPECT_EQ(pool.occupancy(0) & 0b1111, 0b1001);
+    EXPECT_EQ(pool.occupancy(10), 0);
+}
+
+TEST(AgentPoolTest, SlotOfAgent) {
+    agh::AgentPool<BigAgent> big;
+    agh::AgentPool<Agent> small;
+    for (int i = 0; i < 3000; ++i) {
+        big.emplace().id = i;
+        small.emplace(i);
+    }
+    for (size_t i = 0; i < 3000; ++i) {
+        EXPECT_EQ(big.slotOf(big[i]), i);
+        EXPECT_EQ(big[i].id, i);
+        EXPECT_EQ(small.slotOf(small[i]), i);
+    }
+}
+
+TEST(AgentPoolTest, DestroysOnlyLiveAgents) {
+    {
+        agh::AgentPool<Counted> pool;
+        std::vector<Counted*> agents;
+        for (int i = 0; i < 100; ++i) {
+            agents.push_back(&pool.emplace());
+        }
+        for (int i = 0; i < 100; i += 2) {
+            pool.erase(*agents[i]);
+        }
+        EXPECT_EQ(Counted::alive, 50);
+    }
+    EXPECT_EQ(Counted::alive, 0);
+}
+}
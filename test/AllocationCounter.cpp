@@ -0,0 +1,60 @@
+#include "AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Kept in its own translation unit, so that the replaced operators are never inlined next to the standard ones.
+namespace {
+std::atomic<size_t> allocations{0};
+std::atomic<bool> counting{false};
+
+void* allocate(const std::size_t size) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+}
+
+void* operator new(const std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](const std::size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace test {
+AllocationCounter::AllocationCounter() {
+    allocations.store(0, std::memory_order_relaxed);
+    counting.store(true, std::memory_order_seq_cst);
+}
+
+AllocationCounter::~AllocationCounter() {
+    counting.store(false, std::memory_order_seq_cst);
+}
+
+size_t AllocationCounter::count() const {
+    return allocations.load(std::memory_order_seq_cst);
+}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+namespace test {
+/**
+ * Counts allocations made through global operator new by any thread while the counter exists. The replacement of
+ * operator new is linked only into the allocation test executable, so other tests allocate as usual.
+ */
+class AllocationCounter {
+public:
+    AllocationCounter();
+    ~AllocationCounter();
+
+    AllocationCounter(const AllocationCounter&) = delete;
+    AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+    /**
+     * Returns number of allocations made since the counter was created.
+     * @return Number of allocations.
+     */
+    [[nodiscard]] size_t count() const;
+};
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include "../include/model/Model.hpp"
+#include "../include/schedule/ContinuousSchedule.hpp"
+
+namespace test::continuous_schedule {
+struct Producer {
+    double rateValue{5.};
+    bool active{true};
+    int fired{};
+
+    [[nodiscard]] bool isActive() const {
+        return active;
+    }
+
+    template<typename T>
+    double rate(T&) const {
+        return rateValue;
+    }
+
+    template<typename T>
+    void step(T& model) {
+        model.count += 1;
+        fired += 1;
+    }
+};
+
+struct Consumer {
+    int fired{};
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+
+    template<typename T>
+    double rate(T& model) const {
+        return static_cast<double>(model.count);
+    }
+
+    template<typename T>
+    void step(T& model) {
+        EXPECT_GT(model.count, 0);
+        model.count -= 1;
+        fired += 1;
+    }
+};
+
+struct ReactionModel : agh::Model<Producer, Consumer> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const size_t steps) const {
+        return steps >= 20'000;
+    }
+
+    int count{};
+};
+
+using Schedule = agh::ContinuousSchedule<ReactionModel, Producer, Consumer>;
+
+TEST(ContinuousScheduleTest, ConstantRate) {
+    ReactionModel model;
+    Schedule schedule(model, 3);
+    schedule.add(model.emplaceAgent<Producer>(2.));
+    schedule.execute();
+
+    EXPECT_EQ(schedule.getSteps(), 20'000);
+    EXPECT_NEAR(schedule.getTime(), 10'000., 300.);
+}
+
+TEST(ContinuousScheduleTest, BirthDeathSteadyState) {
+    ReactionModel model;
+    Schedule schedule(model, 5);
+    const size_t birth = schedule.add(model.emplaceAgent<Producer>());
+    const size_t death = schedule.add(model.emplaceAgent<Consumer>());
+    schedule.addDependency(birth, death);
+
+    // Stationary distribution is Poisson with mean equal to the birth rate divided by the death rate per individual.
+    double sum = 0.;
+    for (int t = 1; t <= 2000; ++t) {
+        schedule.executeUntil(t);
+        EXPECT_EQ(schedule.getTime(), t);
+        EXPECT_EQ(schedule.getRate(death), model.count);
+        sum += model.count;
+    }
+    EXPECT_NEAR(sum / 2000., 5., 0.3);
+}
+
+TEST(ContinuousScheduleTest, UpdateRate) {
+    ReactionModel model;
+    Schedule schedule(model);
+    auto& producer = model.emplaceAgent<Producer>(0.);
+    const size_t id = schedule.add(producer);
+
+    EXPECT_FALSE(schedule.step());
+    schedule.executeUntil(10.);
+    EXPECT_EQ(producer.fired, 0);
+
+    producer.rateValue = 100.;
+    schedule.updateRate(id);
+    schedule.executeUntil(11.);
+    EXPECT_NEAR(producer.fired, 100, 40);
+
+    producer.active = false;
+    EXPECT_FALSE(schedule.step());
+}
+
+TEST(ContinuousScheduleTest, Reproducible) {
+    auto run = [](const uint64_t seed) {
+        ReactionModel model;
+        Schedule schedule(model, seed);
+        const size_t birth = schedule.add(model.emplaceAgent<Producer>());
+        schedule.addDependency(birth, schedule.add(model.emplaceAgent<Consumer>()));
+        schedule.executeUntil(50.);
+        return std::make_pair(schedule.getSteps(), model.count);
+    };
+
+    EXPECT_EQ(run(1), run(1));
+    EXPECT_NE(run(1), run(2));
+}
+}
@@ -1,5 +1,11 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <execution>
+#include <thread>
+#include <vector>
+
 #include "../include/space/ContinuousSpace.hpp"
 
 namespace test::continuous {
@@ -44,4 +50,35 @@ TEST(ContinuousSpaceTest, GetNeighbours) {
     nghs = space.getNeighbors(*a.pos, 3.f, false, true);
     EXPECT_EQ(nghs.size(), 2);
 }
+
+TEST(ContinuousSpaceTest, ParallelApply) {
+    agh::ContinuousSpace<Agent> space(100.f, 100.f, 1.f);
+    std::vector<Agent> agents(10000);
+    for (size_t i = 0; i < agents.size(); ++i) {
+        space.addAgent(agents[i], {static_cast<float>(i % 100) + 0.5f, static_cast<float>(i / 100) + 0.5f});
+    }
+
+    // Every row of the discretization is a separate chunk, so the workers of the pool join the calling thread, which
+    // waits for them (at most a second) before visiting its agents.
+    std::atomic<int> visited = 0;
+    std::atomic<bool> shared = false;
+    agh::ThreadPool pool(4);
+    space.setThreadPool(&pool);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    space.apply(std::execution::par, [&](const Agent&) {
+        ++visited;
+        if (agh::ThreadPool::threadIndex() != 0) {
+            shared = true;
+        }
+        while (!shared && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    });
+    EXPECT_EQ(visited, 10000);
+    EXPECT_TRUE(shared);
+
+    space.setThreadPool(nullptr);
+    space.apply(std::execution::seq, [&](const Agent&) { --visited; });
+    EXPECT_EQ(visited, 0);
+}
 }
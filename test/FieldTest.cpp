@@ -1,6 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <execution>
+#include <vector>
+
 #include "../include/space/Field.hpp"
+#include "../include/utilities/Random.hpp"
 
 namespace test::field {
 struct MyAgent {
@@ -8,6 +14,11 @@ struct MyAgent {
     int value{};
 };
 
+struct OtherAgent {
+    std::optional<agh::Point> pos;
+    double weight{};
+};
+
 TEST(FieldTest, MoveAgent) {
     using FieldT = agh::Field<MyAgent>;
     MyAgent agent;
@@ -85,4 +96,230 @@ TEST(FieldTest, ToToroidal) {
     EXPECT_EQ(p.x, 1);
     EXPECT_EQ(p.y, 0);
 }
+
+TEST(FieldTest, TaggedCells) {
+    using FieldT = agh::Field<MyAgent, OtherAgent>;
+    static_assert(sizeof(FieldT::CellT) == sizeof(void*));
+    MyAgent first;
+    OtherAgent second;
+    FieldT field(70, 3);
+    field.addAgent(first, {69, 0});
+    field.addAgent(second, {0, 1});
+    EXPECT_EQ(std::get<MyAgent*>(*field.getAgent({69, 0})), &first);
+    EXPECT_EQ(std::get<OtherAgent*>(*field.getAgent({0, 1})), &second);
+    EXPECT_EQ(field.getEmpty().size(), 70 * 3 - 2);
+
+    std::vector<agh::Point> visited;
+    field.transform([&](agh::Point p, auto&) { visited.push_back(p); });
+    EXPECT_EQ(visited, (std::vector<agh::Point>{{69, 0}, {0, 1}}));
+
+    field.moveAgent(second, {69, 2});
+    EXPECT_TRUE(field.isEmpty({0, 1}));
+    EXPECT_EQ(field.getNeighbors({69, 1}).size(), 2);
+    field.removeAgent({69, 0});
+    EXPECT_FALSE(first.pos.has_value());
+    EXPECT_EQ(field.getEmpty().size(), 70 * 3 - 1);
+}
+
+template<int N>
+struct Kind {
+    std::optional<agh::Point> pos;
+    int value{};
+};
+
+TEST(FieldTest, ManyLowAlignedTypes) {
+    using FieldT = agh::Field<Kind<0>, Kind<1>, Kind<2>, Kind<3>, Kind<4>>;
+    static_assert(alignof(Kind<0>) < 8 && !FieldT::CellT::packed);
+    Kind<0> k0;
+    Kind<1> k1;
+    Kind<2> k2;
+    Kind<3> k3;
+    Kind<4> k4;
+    FieldT field(5, 1);
+    field.addAgent(k0, {0, 0});
+    field.addAgent(k1, {1, 0});
+    field.addAgent(k2, {2, 0});
+    field.addAgent(k3, {3, 0});
+    field.addAgent(k4, {4, 0});
+    EXPECT_EQ(std::get<Kind<3>*>(*field.getAgent({3, 0})), &k3);
+    EXPECT_EQ(std::get<Kind<4>*>(*field.getAgent({4, 0})), &k4);
+
+    int kinds = 0;
+    field.transform([&](const agh::Point p, auto& agent) {
+        agent.value = p.x;
+        kinds += 1;
+    });
+    EXPECT_EQ(kinds, 5);
+    EXPECT_EQ(k4.value, 4);
+    field.removeAgent({2, 0});
+    EXPECT_FALSE(k2.pos.has_value());
+    EXPECT_EQ(field.emptyCount(), 1);
+}
+
+TEST(FieldTest, EmptyCells) {
+    using FieldT = agh::Field<MyAgent>;
+    std::array<MyAgent, 4> agents;
+    FieldT field(3, 2);
+    EXPECT_EQ(field.emptyCount(), 6);
+    field.addAgent(agents[0], {2, 0});
+    EXPECT_EQ(field.getEmpty().size(), 5);
+    EXPECT_EQ(*field.nearestEmpty({2, 0}), agh::Point(1, 1));
+
+    auto random = agh::Random(1).stream(0, 0);
+    for (int i = 1; i < 4; ++i) {
+        const auto p = field.randomEmpty(random);
+        ASSERT_TRUE(p.has_value());
+        EXPECT_TRUE(field.isEmpty(*p));
+        field.addAgent(agents[i], *p);
+    }
+    EXPECT_EQ(field.emptyCount(), 2);
+    field.moveAgent(agents[0], *field.nearestEmpty({0, 0}));
+    EXPECT_EQ(field.emptyCount(), 2);
+    EXPECT_TRUE(field.isEmpty({2, 0}));
+
+    field.removeAgent(agents[1]);
+    const std::vector<agh::Point> empty = field.getEmpty();
+    ASSERT_EQ(empty.size(), 3);
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_NE(std::ranges::find(empty, *field.randomEmpty(random)), empty.end());
+    }
+    for (const agh::Point p : empty) {
+        field.addAgent(agents[1], p);
+    }
+    EXPECT_FALSE(field.randomEmpty(random).has_value());
+    EXPECT_FALSE(field.nearestEmpty({1, 1}).has_value());
+}
+
+TEST(FieldTest, ForEachNeighbor) {
+    using FieldT = agh::Field<MyAgent, OtherAgent>;
+    std::array<MyAgent, 3> agents{MyAgent{{}, 1}, MyAgent{{}, 2}, MyAgent{{}, 3}};
+    OtherAgent other;
+    FieldT field(4, 4);
+    field.addAgent(agents[0], {0, 0});
+    field.addAgent(agents[1], {1, 1});
+    field.addAgent(agents[2], {3, 3});
+    field.addAgent(other, {2, 1});
+
+    const agh::Stencil moore = agh::Stencil::moore();
+    int sum = 0;
+    int others = 0;
+    auto count = [&]<typename A>(A& agent) {
+        if constexpr (std::is_same_v<A, MyAgent>) sum += agent.value;
+        else ++others;
+    };
+    EXPECT_TRUE(field.forEachNeighbor({1, 0}, moore, count));
+    EXPECT_EQ(sum, 3);
+    EXPECT_EQ(others, 1);
+    EXPECT_EQ(field.getNeighbors({1, 0}).size(), 3);
+
+    int visited = 0;
+    EXPECT_FALSE(field.forEachNeighbor({1, 0}, moore, [&](auto&) { return ++visited < 2; }));
+    EXPECT_EQ(visited, 2);
+
+    sum = 0;
+    field.forEachNeighbor({2, 2}, agh::Stencil::moore(1, true), count);
+    EXPECT_EQ(sum, 5);
+}
+
+TEST(FieldTest, StaticGeometry) {
+    agh::BasicField<agh::Extent<8, 8>, agh::Torus, agh::RowMajor, MyAgent> field;
+    std::array<MyAgent, 2> agents{MyAgent{{}, 1}, MyAgent{{}, 2}};
+    EXPECT_EQ(field.getWidth(), 8);
+    EXPECT_TRUE(field.isToroidal());
+    EXPECT_EQ(field.emptyCount(), 64);
+
+    field.addAgent(agents[0], {7, 7});
+    field.addAgent(agents[1], {1, 0});
+    int sum = 0;
+    field.forEachNeighbor({0, 0}, agh::Stencil::fixedMoore<1>(), [&](const MyAgent& agent) { sum += agent.value; });
+    EXPECT_EQ(sum, 3);
+    EXPECT_EQ(field.getNeighbors({0, 0}).size(), 2);
+    EXPECT_EQ(field.getEmpty().size(), 62);
+
+    agh::BasicField<agh::Extent<8, 8>, agh::Bounded, agh::RowMajor, MyAgent> bounded(8, 8);
+    EXPECT_FALSE(bounded.isToroidal());
+    EXPECT_TRUE(bounded.outOfBounds({8, 0}));
+}
+
+template<typename Layout>
+void checkLayout() {
+    using FieldT = agh::BasicField<agh::DynamicExtent, agh::DynamicTopology, Layout, MyAgent>;
+    std::array<MyAgent, 6> agents{};
+    std::array<MyAgent, 6> copies{};
+    agh::Field<MyAgent> reference(10, 7, true);
+    FieldT field(10, 7, true);
+    EXPECT_EQ(field.emptyCount(), 70);
+
+    auto random = agh::Random(3).stream(0, 0);
+    for (size_t i = 0; i < agents.size(); ++i) {
+        agents[i].value = static_cast<int>(i) + 1;
+        const agh::Point p = *field.randomEmpty(random);
+        ASSERT_FALSE(field.outOfBounds(p));
+        field.addAgent(agents[i], p);
+        copies[i].value = agents[i].value;
+        reference.addAgent(copies[i], p);
+    }
+    EXPECT_EQ(field.emptyCount(), 64);
+    EXPECT_EQ(field.getEmpty().size(), 64);
+    for (const agh::Point p : field.getEmpty()) {
+        EXPECT_TRUE(reference.isEmpty(p));
+    }
+
+    for (int y = 0; y < 7; ++y) {
+        for (int x = 0; x < 10; ++x) {
+            EXPECT_EQ(field.getNeighbors({x, y}, 2).size(), reference.getNeighbors({x, y}, 2).size());
+        }
+    }
+    int sum = 0;
+    field.forEachNeighbor(*agents[0].pos, agh::Stencil::moore(3, true), [&](const MyAgent& a) { sum += a.value; });
+    int expected = 0;
+    reference.forEachNeighbor(*agents[0].pos, agh::Stencil::moore(3, true), [&](const MyAgent& a) {
+        expected += a.value;
+    });
+    EXPECT_EQ(sum, expected);
+
+    field.transform([](const agh::Point p, const MyAgent& agent) { EXPECT_EQ(p, *agent.pos); });
+}
+
+TEST(FieldTest, Layouts) {
+    checkLayout<agh::Tiled<4>>();
+    checkLayout<agh::Morton>();
+}
+
+TEST(FieldTest, ParallelApply) {
+    using FieldT = agh::Field<MyAgent, OtherAgent>;
+    std::vector<MyAgent> agents(5000);
+    std::vector<OtherAgent> others(5000);
+    FieldT field(300, 300);
+    for (int i = 0; i < 5000; ++i) {
+        field.addAgent(agents[i], {i % 300, i / 300 * 17});
+        field.addAgent(others[i], {i % 300, i / 300 * 17 + 1});
+    }
+
+    agh::ThreadPool pool(4);
+    field.setThreadPool(&pool);
+    field.apply(std::execution::par, [](auto& a) {
+        if constexpr (std::is_same_v<std::remove_cvref_t<decltype(a)>, MyAgent>) {
+            ++a.value;
+        } else {
+            a.weight += 0.5;
+        }
+    });
+    field.transform(std::execution::par, [](const agh::Point p, auto& a) {
+        if constexpr (std::is_same_v<std::remove_cvref_t<decltype(a)>, MyAgent>) {
+            a.value += p.x;
+        }
+    });
+    field.setThreadPool(nullptr);
+    field.apply(std::execution::par, [](auto& a) {
+        if constexpr (std::is_same_v<std::remove_cvref_t<decltype(a)>, MyAgent>) {
+            ++a.value;
+        }
+    });
+
+    for (int i = 0; i < 5000; ++i) {
+        EXPECT_EQ(agents[i].value, i % 300 + 2);
+        EXPECT_EQ(others[i].weight, 0.5);
+    }
+}
 }
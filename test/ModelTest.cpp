@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <execution>
 #include <optional>
 
 #include "../include/model/Model.hpp"
@@ -25,6 +27,19 @@ struct MyModel : agh::Model<MyAgent> {};
 
 struct MyModel2 : agh::Model<MyAgent, NotMyAgent> {};
 
+struct Person {
+    int wealth{};
+    int region{};
+    bool infected{};
+    bool active{true};
+
+    [[nodiscard]] bool isActive() const {
+        return active;
+    }
+};
+
+struct PersonModel : agh::Model<Person> {};
+
 TEST(ModelTest, AddingAgent) {
     MyModel2 m;
     MyAgent a1{1};
@@ -56,4 +71,200 @@ TEST(ModelTest, AddingAgentDifferentTypes) {
     EXPECT_EQ(m.getAgents<MyAgent>()[0].id, 1);
     EXPECT_EQ(m.getAgents<NotMyAgent>()[0].id, 2);
 }
+
+TEST(ModelTest, AgentHandles) {
+    MyModel2 m;
+    auto& first = m.emplaceAgent<MyAgent>(1);
+    auto& other = m.emplaceAgent<NotMyAgent>(2);
+    const agh::AgentHandle handle = m.handleOf(first);
+    const agh::AgentHandle otherHandle = m.handleOf(other);
+
+    EXPECT_EQ(sizeof(agh::AgentHandle), 8);
+    EXPECT_FALSE(agh::AgentHandle());
+    EXPECT_EQ(handle.type(), 0);
+    EXPECT_EQ(otherHandle.type(), 1);
+    EXPECT_EQ(m.get<MyAgent>(handle), &first);
+    EXPECT_EQ(m.get<NotMyAgent>(handle), nullptr);
+    EXPECT_TRUE(m.isAlive(otherHandle));
+
+    int visited = 0;
+    EXPECT_TRUE(m.visit(otherHandle, [&](auto& agent) { visited = agent.id; }));
+    EXPECT_EQ(visited, 2);
+
+    m.removeAgent(first);
+    auto& second = m.emplaceAgent<MyAgent>(3);
+    EXPECT_EQ(&second, &first);
+    EXPECT_FALSE(m.isAlive(handle));
+    EXPECT_EQ(m.get<MyAgent>(handle), nullptr);
+    EXPECT_FALSE(m.visit(handle, [](auto&) { FAIL(); }));
+    EXPECT_NE(m.handleOf(second), handle);
+    EXPECT_EQ(m.get<MyAgent>(m.handleOf(second))->id, 3);
+}
+
+TEST(ModelTest, BulkOperations) {
+    MyModel2 m;
+    for (int i = 0; i < 10'000; ++i) {
+        m.emplaceAgent<MyAgent>(i);
+        if (i % 4 == 0) {
+            m.emplaceAgent<NotMyAgent>(-i);
+        }
+    }
+    for (int i = 0; i < 10'000; i += 7) {
+        m.removeAgent(m.getAgents<MyAgent>()[i]);
+    }
+
+    auto sumIds = [&](auto&& policy) {
+        return m.transformReduce(policy, int64_t{0}, std::plus<>(), [](const auto& agent) -> int64_t {
+            return agent.id;
+        });
+    };
+    auto meanOfInverse = [&](auto&& policy) {
+        return m.transformReduce<MyAgent>(policy, 0., std::plus<>(), [](const MyAgent& agent) {
+            return 1. / (agent.id + 1);
+        });
+    };
+    const int64_t sequentialSum = sumIds(std::execution::seq);
+    const double sequentialMean = meanOfInverse(std::execution::seq);
+    const size_t sequentialCount = m.countIf(std::execution::seq, [](const auto& agent) { return agent.id % 2 == 0; });
+
+    EXPECT_EQ(m.threadPool(), nullptr);
+    m.setThreads(4);
+    ASSERT_NE(m.threadPool(), nullptr);
+    EXPECT_EQ(m.threadPool()->size(), 4);
+    EXPECT_EQ(sumIds(std::execution::par), sequentialSum);
+    EXPECT_EQ(meanOfInverse(std::execution::par_unseq), sequentialMean);
+    EXPECT_EQ(m.countIf(std::execution::par, [](const auto& agent) { return agent.id % 2 == 0; }), sequentialCount);
+    EXPECT_EQ(m.countIf<NotMyAgent>(std::execution::par, [](const NotMyAgent&) { return true; }), 2500);
+
+    std::atomic<size_t> visited{0};
+    m.forEach(std::execution::par, [&](auto& agent) {
+        agent.id += 1;
+        visited.fetch_add(1, std::memory_order_relaxed);
+    });
+    EXPECT_EQ(visited, m.agentCount());
+    EXPECT_EQ(sumIds(std::execution::seq), sequentialSum + static_cast<int64_t>(m.agentCount()));
+
+    m.forEach<MyAgent>(std::execution::seq, [](MyAgent& agent) { agent.id = 0; });
+    EXPECT_EQ(m.countIf<MyAgent>(std::execution::par, [](const MyAgent& agent) { return agent.id == 0; }),
+              m.agentCount<MyAgent>());
+}
+
+TEST(ModelTest, DeferredCommands) {
+    MyModel2 m;
+    auto& first = m.emplaceAgent<MyAgent>(1);
+    m.spawn<MyAgent>(2);
+    m.spawnWith<NotMyAgent>([&](NotMyAgent& agent) { agent.id *= 10; }, 3);
+    m.kill(first);
+    m.kill(first);
+    std::vector<int> order;
+    m.defer([&](auto& model) { order.push_back(static_cast<int>(model.agentCount())); });
+    EXPECT_EQ(m.commands().size(), 5);
+    EXPECT_EQ(m.agentCount(), 1);
+
+    m.flushCommands();
+    EXPECT_EQ(m.commands().size(), 0);
+    EXPECT_EQ(order, std::vector<int>{2});
+    EXPECT_EQ(m.agentCount<MyAgent>(), 1);
+    EXPECT_EQ(m.getAgents<MyAgent>().begin()->id, 2);
+    EXPECT_EQ(m.getAgents<NotMyAgent>()[0].id, 30);
+
+    {
+        agh::CommandKey::Scope late(2);
+        m.defer([&](auto&) { order.push_back(2); });
+    }
+    {
+        agh::CommandKey::Scope early(1);
+        m.defer([&](auto& model) {
+            order.push_back(1);
+            model.defer([&](auto&) { order.push_back(3); });
+        });
+    }
+    m.flushCommands();
+    EXPECT_EQ(order, (std::vector<int>{2, 1, 2, 3}));
+}
+
+TEST(ModelTest, Compact) {
+    MyModel2 m;
+    std::vector<agh::AgentHandle> handles;
+    for (int i = 0; i < 6; ++i) {
+        handles.push_back(m.handleOf(m.emplaceAgent<MyAgent>(i)));
+    }
+    m.emplaceAgent<NotMyAgent>(10);
+    m.removeAgent(*m.get<MyAgent>(handles[1]));
+    m.removeAgent(*m.get<MyAgent>(handles[3]));
+
+    EXPECT_EQ(m.compact(), 0);
+    EXPECT_EQ(m.agentCount<MyAgent>(), 4);
+    EXPECT_EQ(m.getAgents<MyAgent>().slots(), 4);
+    EXPECT_EQ(m.getAgents<NotMyAgent>()[0].id, 10);
+    std::vector<int> ids;
+    for (auto& agent : m.getAgents<MyAgent>()) {
+        ids.push_back(agent.id);
+    }
+    EXPECT_EQ(ids, (std::vector<int>{0, 5, 2, 4}));
+    EXPECT_TRUE(m.isAlive(handles[0]));
+    EXPECT_FALSE(m.isAlive(handles[5]));
+    EXPECT_FALSE(m.isAlive(handles[4]));
+
+    auto& added = m.emplaceAgent<MyAgent>(6);
+    EXPECT_EQ(m.getAgents<MyAgent>().slotOf(added), 4);
+    EXPECT_EQ(m.compact(), 0);
+}
+
+TEST(ModelTest, SecondaryIndexes) {
+    PersonModel m;
+    for (int i = 0; i < 10; ++i) {
+        m.emplaceAgent<Person>(i * 10, i % 3, i % 4 == 0);
+    }
+    auto& infected = m.addIndex<Person, agh::FlagIndex>([](const Person& p) { return p.infected; });
+    auto& wealth = m.addIndex<Person, agh::SortedIndex>([](const Person& p) { return p.wealth; });
+    auto& regions = m.addIndex<Person, agh::CategoryIndex>(&Person::region);
+    EXPECT_EQ(infected.count(), 3);
+    EXPECT_EQ(wealth.size(), 10);
+    EXPECT_EQ(regions.count(0), 4);
+
+    auto collect = [](auto& result) { return [&](const Person& p) { result.push_back(p.wealth); }; };
+    std::vector<int> richest;
+    wealth.forEachHighest(2, collect(richest));
+    EXPECT_EQ(richest, (std::vector<int>{90, 80}));
+    std::vector<int> middle;
+    wealth.forEachInRange(30, 60, collect(middle));
+    EXPECT_EQ(middle, (std::vector<int>{30, 40, 50}));
+
+    Person& poorest = m.getAgents<Person>()[0];
+    m.update(poorest, [](Person& p) {
+        p.wealth = 1000;
+        p.infected = false;
+        p.region = 2;
+    });
+    m.getAgents<Person>()[1].infected = true;
+    m.reindex(m.getAgents<Person>()[1]);
+    m.removeAgent(m.getAgents<Person>()[4]);
+    m.emplaceAgent<Person>(5, 7, true);
+
+    std::vector<int> sick;
+    infected.forEach(collect(sick));
+    EXPECT_EQ(sick, (std::vector<int>{10, 5, 80}));
+    std::vector<int> lowest;
+    wealth.forEachLowest(3, collect(lowest));
+    EXPECT_EQ(lowest, (std::vector<int>{5, 10, 20}));
+    std::vector<int> highest;
+    wealth.forEachHighest(1, collect(highest));
+    EXPECT_EQ(highest, std::vector<int>{1000});
+    EXPECT_EQ(regions.count(0), 3);
+    EXPECT_EQ(regions.count(2), 4);
+    EXPECT_EQ(regions.count(7), 1);
+
+    m.getAgents<Person>()[2].active = false;
+    m.compact();
+    EXPECT_EQ(wealth.size(), 9);
+    EXPECT_EQ(regions.count(2), 3);
+    std::vector<int> ordered;
+    wealth.forEachInRange(0, 100, collect(ordered));
+    EXPECT_EQ(ordered, (std::vector<int>{5, 10, 30, 50, 60, 70, 80, 90}));
+
+    m.removeIndex<Person>(regions);
+    m.emplaceAgent<Person>(15, 0, false);
+    EXPECT_EQ(wealth.size(), 10);
+}
 }
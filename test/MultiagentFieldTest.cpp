@@ -1,8 +1,12 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <atomic>
+#include <execution>
+#include <vector>
 
 #include "../include/space/MultiagentField.hpp"
+#include "../include/utilities/Random.hpp"
 
 namespace test::multiagent_field {
 struct MyAgent {
@@ -192,4 +196,118 @@ TEST(FieldTest, GetEmpty) {
     field.addAgent(agent, {0, 0});
     EXPECT_EQ(field.getEmpty().size(), 0);
 }
+
+TEST(MultiagentFieldTest, EmptyCells) {
+    using FieldT = agh::MultiagentField<MyAgent>;
+    std::array<MyAgent, 3> agents{MyAgent{1}, MyAgent{2}, MyAgent{3}};
+    FieldT field(3, 1, true);
+    EXPECT_EQ(field.getEmpty().size(), 3);
+    field.addAgent(agents[0], {0, 0});
+    field.addAgent(agents[1], {0, 0});
+    EXPECT_EQ(field.emptyCount(), 2);
+    EXPECT_EQ(*field.nearestEmpty({0, 0}), agh::Point(2, 0));
+
+    auto random = agh::Random(1).stream(0, 0);
+    const auto p = field.randomEmpty(random);
+    ASSERT_TRUE(p.has_value());
+    field.addAgent(agents[2], *p);
+    EXPECT_EQ(field.emptyCount(), 1);
+    field.removeAgent(agents[0]);
+    EXPECT_EQ(field.emptyCount(), 1);
+    field.moveAgent(agents[1], *field.randomEmpty(random));
+    EXPECT_EQ(field.emptyCount(), 1);
+    EXPECT_EQ(field.randomEmpty(random), agh::Point(0, 0));
+    field.removeAgents(*agents[2].pos);
+    EXPECT_EQ(field.emptyCount(), 2);
+}
+
+TEST(MultiagentFieldTest, ForEachNeighbor) {
+    using FieldT = agh::MultiagentField<MyAgent>;
+    std::array<MyAgent, 4> agents{MyAgent{1}, MyAgent{2}, MyAgent{3}, MyAgent{4}};
+    FieldT field(3, 3, true);
+    field.addAgent(agents[0], {0, 0});
+    field.addAgent(agents[1], {0, 0});
+    field.addAgent(agents[2], {2, 2});
+    field.addAgent(agents[3], {1, 1});
+
+    std::vector<int> ids;
+    EXPECT_TRUE(field.forEachNeighbor({0, 0}, agh::Stencil::vonNeumann(1, true), [&](const MyAgent& agent) {
+        ids.push_back(agent.id);
+    }));
+    EXPECT_EQ(ids, (std::vector<int>{1, 2}));
+
+    ids.clear();
+    EXPECT_FALSE(field.forEachNeighbor({2, 2}, agh::Stencil::moore(), [&](const MyAgent& agent) {
+        ids.push_back(agent.id);
+        return agent.id != 1;
+    }));
+    EXPECT_EQ(ids, (std::vector<int>{4, 1}));
+}
+
+TEST(MultiagentFieldTest, StaticGeometry) {
+    agh::BasicMultiagentField<agh::Extent<4, 2>, agh::Torus, agh::RowMajor, MyAgent> field;
+    std::array<MyAgent, 2> agents{MyAgent{1, {}, 1}, MyAgent{2, {}, 2}};
+    field.addAgent(agents[0], {3, 1});
+    field.addAgent(agents[1], {3, 1});
+    EXPECT_EQ(field.agentCount({3, 1}), 2);
+    EXPECT_EQ(field.toToroidal({-1, -1}), (agh::Point{3, 1}));
+
+    int sum = 0;
+    field.forEachNeighbor({0, 0}, agh::Stencil::fixedMoore<1>(), [&](const MyAgent& agent) { sum += agent.value; });
+    EXPECT_EQ(sum, 6);
+    EXPECT_EQ(field.emptyCount(), 7);
+}
+
+TEST(MultiagentFieldTest, Layouts) {
+    agh::BasicMultiagentField<agh::DynamicExtent, agh::DynamicTopology, agh::Morton, MyAgent> field(5, 3);
+    std::array<MyAgent, 3> agents{MyAgent{1, {}, 1}, MyAgent{2, {}, 2}, MyAgent{3, {}, 3}};
+    field.addAgent(agents[0], {4, 2});
+    field.addAgent(agents[1], {4, 2});
+    field.addAgent(agents[2], {0, 1});
+    EXPECT_EQ(field.emptyCount(), 13);
+    const auto empty = field.getEmpty();
+    ASSERT_EQ(empty.size(), 13);
+    // Cells are listed in Morton order, which visits (1, 1) before (2, 0).
+    EXPECT_EQ(empty[0], agh::Point(0, 0));
+    EXPECT_EQ(empty[1], agh::Point(1, 0));
+    EXPECT_EQ(empty[2], agh::Point(1, 1));
+    EXPECT_EQ(empty[3], agh::Point(2, 0));
+
+    auto random = agh::Random(1).stream(0, 0);
+    for (int i = 0; i < 50; ++i) {
+        const agh::Point p = *field.randomEmpty(random);
+        EXPECT_FALSE(field.outOfBounds(p));
+        EXPECT_TRUE(field.isEmpty(p));
+    }
+
+    int sum = 0;
+    field.apply([&](const MyAgent& agent) { sum += agent.value; });
+    EXPECT_EQ(sum, 6);
+    field.transform([](const agh::Point p, const MyAgent& agent) { EXPECT_EQ(p, *agent.pos); });
+    EXPECT_EQ(field.getNeighbors({3, 1}, 1, true, false).size(), 2);
+}
+
+TEST(MultiagentFieldTest, ParallelApply) {
+    using Field = agh::MultiagentField<MyAgent>;
+    std::vector<MyAgent> agents(20000);
+    Field field(300, 300);
+    for (int i = 0; i < 20000; ++i) {
+        agents[i].id = i;
+        field.addAgent(agents[i], {i * 7 % 300, i % 300});
+    }
+
+    agh::ThreadPool pool(4);
+    field.setThreadPool(&pool);
+    field.apply(std::execution::par, [](MyAgent& a) { a.value = a.id; });
+    std::atomic<long> sum = 0;
+    field.transform(std::execution::par_unseq, [&](const agh::Point p, MyAgent& a) {
+        EXPECT_EQ(p, *a.pos);
+        sum += a.value;
+    });
+
+    EXPECT_EQ(sum, 20000L * 19999 / 2);
+    for (int i = 0; i < 20000; ++i) {
+        EXPECT_EQ(agents[i].value, i);
+    }
+}
 }
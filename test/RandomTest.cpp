@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "../include/model/Model.hpp"
+#include "../include/schedule/Schedule.hpp"
+#include "../include/utilities/Random.hpp"
+
+namespace test::random {
+struct RandomAgent {
+    uint64_t id;
+    uint64_t value{};
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+
+    template<typename T>
+    void step(T& model) {
+        auto stream = model.random.stream(id, model.epoch);
+        for (int i = 0; i < 5; ++i) {
+            value = value * 31 + stream.below(1000);
+        }
+    }
+};
+
+struct RandomModel : agh::Model<RandomAgent> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 50;
+    }
+
+    void setEpoch(const size_t pEpoch) {
+        epoch = pEpoch;
+    }
+
+    agh::Random random{42};
+    size_t epoch{};
+};
+
+std::vector<uint64_t> runRandom(const size_t threads) {
+    RandomModel model;
+    agh::Schedule<RandomModel, RandomAgent> schedule(model);
+    schedule.setThreads(threads);
+    schedule.setParallelStep(true, 16);
+    for (uint64_t i = 0; i < 500; ++i) {
+        schedule.scheduleRepeating(model.emplaceAgent<RandomAgent>(i), i % 3, 0, 1 + i % 2);
+    }
+    schedule.execute();
+
+    std::vector<uint64_t> values;
+    for (const auto& agent : model.getAgents<RandomAgent>()) {
+        values.push_back(agent.value);
+    }
+    return values;
+}
+
+TEST(RandomTest, PhiloxKnownAnswers) {
+    using Counter = agh::Philox::Counter;
+    EXPECT_EQ(agh::Philox::generate({0, 0, 0, 0}, {0, 0}),
+              (Counter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+    EXPECT_EQ(agh::Philox::generate({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}),
+              (Counter{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+    EXPECT_EQ(agh::Philox::generate({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}),
+              (Counter{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+TEST(RandomTest, StreamsAreReproducible) {
+    const agh::Random random(7);
+    auto first = random.stream(3, 10);
+    auto second = random.stream(3, 10);
+    auto otherAgent = random.stream(4, 10);
+    auto otherEpoch = random.stream(3, 11);
+
+    size_t differentAgent = 0;
+    size_t differentEpoch = 0;
+    for (int i = 0; i < 100; ++i) {
+        const auto value = first();
+        EXPECT_EQ(value, second());
+        differentAgent += value != otherAgent();
+        differentEpoch += value != otherEpoch();
+    }
+    EXPECT_GT(differentAgent, 95);
+    EXPECT_GT(differentEpoch, 95);
+}
+
+TEST(RandomTest, FillMatchesSequence) {
+    auto scalar = agh::Random(1).stream(2, 3);
+    auto batch = agh::Random(1).stream(2, 3);
+
+    std::vector<uint32_t> expected(103);
+    for (auto& value : expected) {
+        value = scalar();
+    }
+    std::vector<uint32_t> values(103);
+    values[0] = batch();
+    batch.fill(std::span(values).subspan(1, 50));
+    batch.fill(std::span(values).subspan(51));
+    EXPECT_EQ(values, expected);
+
+    std::vector<double> uniforms(300);
+    batch.fillUniform(uniforms);
+    for (const double u : uniforms) {
+        EXPECT_EQ(u, scalar.uniform());
+        EXPECT_GE(u, 0.);
+        EXPECT_LT(u, 1.);
+    }
+}
+
+TEST(RandomTest, BelowIsInRange) {
+    auto stream = agh::Random(5).stream(0, 0);
+    std::vector<int> counts(6);
+    for (int i = 0; i < 6000; ++i) {
+        const auto value = stream.below(6);
+        ASSERT_LT(value, 6);
+        counts[value] += 1;
+    }
+    for (const int count : counts) {
+        EXPECT_GT(count, 800);
+    }
+}
+
+TEST(RandomTest, RandomBelowIsPortable) {
+    auto stream = agh::Random(5).stream(0, 0);
+    auto copy = stream;
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(agh::randomBelow(copy, 1000), stream.below(1000));
+    }
+
+    // The first value of the default std::mt19937 is 3499211612, which is specified by the standard.
+    std::mt19937 twister;
+    EXPECT_EQ(agh::randomBelow(twister, 10), 8);
+}
+
+TEST(RandomTest, IndependentOfThreadCount) {
+    const auto serial = runRandom(1);
+    EXPECT_EQ(runRandom(2), serial);
+    EXPECT_EQ(runRandom(4), serial);
+}
+}
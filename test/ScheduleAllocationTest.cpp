@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "AllocationCounter.hpp"
+#include "../include/model/Model.hpp"
+#include "../include/schedule/Schedule.hpp"
+
+namespace test::schedule_allocation {
+struct MyAgent {
+    explicit MyAgent(const int pId) : id(pId) {}
+    int id;
+    int run{};
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+
+    template<typename T>
+    void step(T&) {
+        run += 1;
+    }
+};
+
+struct MyModel : agh::Model<MyAgent> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 10;
+    }
+};
+
+struct CoModel : agh::Model<MyAgent> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 20;
+    }
+
+    std::vector<int> log;
+};
+
+using CoSchedule = agh::Schedule<CoModel, MyAgent>;
+
+agh::Behavior stages(CoSchedule& schedule, CoModel& model) {
+    model.log.push_back(0);
+    co_await schedule.delay(3);
+    model.log.push_back(1);
+    co_await schedule.delay(7, 2);
+    model.log.push_back(2);
+}
+
+template<typename ScheduleT>
+size_t allocationsInSteadyState(const size_t threads) {
+    MyModel model;
+    ScheduleT schedule(model);
+    schedule.setThreads(threads);
+    schedule.setParallelStep(true, 8);
+    for (int i = 0; i < 1000; ++i) {
+        schedule.scheduleRepeating(model.emplaceAgent<MyAgent>(i), i % 5, i % 3, 1 + i % 7);
+    }
+    schedule.scheduleRepeating(model.emplaceAgent<MyAgent>(-1), 0, 0, 1000);
+
+    // Buffers grow during the first epochs, until every combination of intervals has been seen.
+    for (int i = 0; i < 2000; ++i) {
+        schedule.step();
+    }
+
+    const AllocationCounter counter;
+    for (int i = 0; i < 2000; ++i) {
+        schedule.step();
+    }
+    return counter.count();
+}
+
+TEST(ScheduleAllocationTest, StepDoesNotAllocate) {
+    using Heap = agh::Schedule<MyModel, MyAgent>;
+    using Calendar = agh::BasicSchedule<agh::CalendarBackend<8>, MyModel, MyAgent>;
+    using Profiled = agh::ProfiledSchedule<MyModel, MyAgent>;
+
+    EXPECT_EQ(allocationsInSteadyState<Heap>(1), 0);
+    EXPECT_EQ(allocationsInSteadyState<Calendar>(1), 0);
+    EXPECT_EQ(allocationsInSteadyState<Heap>(4), 0);
+    EXPECT_EQ(allocationsInSteadyState<Calendar>(4), 0);
+    EXPECT_EQ(allocationsInSteadyState<Profiled>(1), 0);
+}
+
+TEST(ScheduleAllocationTest, CoroutineFramesAreReused) {
+    CoModel model;
+    CoSchedule schedule(model);
+    model.log.reserve(100);
+    auto spawnAndRun = [&] {
+        schedule.spawn(stages(schedule, model), schedule.getEpochs() + 1, 0);
+        for (int i = 0; i < 3; ++i) {
+            schedule.step();
+        }
+        model.log.clear();
+    };
+
+    spawnAndRun();
+    const AllocationCounter counter;
+    for (int i = 0; i < 10; ++i) {
+        spawnAndRun();
+    }
+    EXPECT_EQ(counter.count(), 0);
+}
+}
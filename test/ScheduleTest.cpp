@@ -1,7 +1,14 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+
 #include "../include/model/Model.hpp"
 #include "../include/schedule/Schedule.hpp"
+#include "../include/space/Field.hpp"
+#include "../include/space/MultiagentField.hpp"
 
 namespace test::schedule {
 struct MyAgent {
@@ -15,7 +22,7 @@ struct MyAgent {
     }
 
     template<typename T>
-    void step(T& model) {
+    void step(T&) {
         run += 1;
     }
 
@@ -41,6 +48,8 @@ struct MyModel : agh::Model<MyAgent> {
 };
 
 struct AdvAgent {
+    static constexpr const char* profileName = R"(advancing "agent")";
+
     bool active{true};
     int run{};
     int adv{};
@@ -50,12 +59,12 @@ struct AdvAgent {
     }
 
     template<typename T>
-    void step(T& model) {
+    void step(T&) {
         run += 1;
     }
 
     template<typename T>
-    void advance(T& model) {
+    void advance(T&) {
         adv += 1;
     }
 };
@@ -70,6 +79,500 @@ struct SecondModel : agh::Model<AdvAgent> {
     }
 };
 
+struct LogAgent {
+    int order;
+    bool active{true};
+
+    [[nodiscard]] bool isActive() const {
+        return active;
+    }
+
+    template<typename T>
+    void step(T& model) {
+        model.log.emplace_back(model.now, order);
+    }
+};
+
+struct LogModel : agh::Model<LogAgent> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 600;
+    }
+
+    std::vector<std::pair<size_t, int>> log;
+    size_t now{};
+};
+
+struct Producer {
+    bool active{true};
+    unsigned value{1};
+
+    [[nodiscard]] bool isActive() const {
+        return active;
+    }
+
+    template<typename T>
+    void step(T&) {
+        value = value * 1'103'515'245u + 12'345u;
+    }
+};
+
+struct Consumer {
+    bool active{true};
+    const Producer* producer{};
+    unsigned sum{};
+
+    [[nodiscard]] bool isActive() const {
+        return active;
+    }
+
+    template<typename T>
+    void step(T&) {
+        sum = sum * 31u + producer->value;
+    }
+};
+
+struct PipelineModel : agh::Model<Producer, Consumer> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 50;
+    }
+};
+
+std::vector<unsigned> runPipeline(const size_t threads, const bool modelPool = false) {
+    PipelineModel model;
+    agh::Schedule<PipelineModel, Producer, Consumer> schedule(model);
+    if (modelPool) {
+        model.setThreads(threads);
+        schedule.setThreadPool(model.threadPool());
+    }
+    else {
+        schedule.setThreads(threads);
+    }
+    schedule.setParallelStep(true, 16);
+    for (unsigned i = 0; i < 1000; ++i) {
+        auto& producer = model.emplaceAgent<Producer>(true, i);
+        auto& consumer = model.emplaceAgent<Consumer>(true, &producer);
+        schedule.scheduleRepeating(producer, 0, 0, 1 + i % 3);
+        schedule.scheduleRepeating(consumer, 0, 1 + i % 2, 1);
+    }
+    schedule.execute();
+
+    std::vector<unsigned> result;
+    for (const auto& consumer : model.getAgents<Consumer>()) {
+        result.push_back(consumer.sum);
+    }
+    return result;
+}
+
+struct LifeCell {
+    bool active{true};
+    bool alive{};
+    bool next{};
+    std::vector<const LifeCell*> neighbors;
+
+    [[nodiscard]] bool isActive() const {
+        return active;
+    }
+
+    template<typename T>
+    void step(T&) {
+        const auto count = std::ranges::count_if(neighbors, [](const LifeCell* c) { return c->alive; });
+        next = count == 3 || (alive && count == 2);
+    }
+
+    template<typename T>
+    void advance(T&) {
+        alive = next;
+    }
+};
+
+struct LifeModel : agh::Model<LifeCell> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 30;
+    }
+};
+
+std::vector<bool> runLife(const size_t threads) {
+    constexpr int size = 64;
+    LifeModel model;
+    agh::Schedule<LifeModel, LifeCell> schedule(model);
+    schedule.setThreads(threads);
+    schedule.setParallelStep(true);
+    schedule.setParallelAdvance(true, 100);
+
+    std::vector<LifeCell*> cells;
+    for (int i = 0; i < size * size; ++i) {
+        auto& cell = model.emplaceAgent<LifeCell>();
+        cell.alive = (i * 7919) % 5 < 2;
+        cells.push_back(&cell);
+        schedule.scheduleRepeating(cell, 0, 0, 1);
+    }
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    if (dx == 0 && dy == 0) continue;
+                    const int nx = (x + dx + size) % size;
+                    const int ny = (y + dy + size) % size;
+                    cells[y * size + x]->neighbors.push_back(cells[ny * size + nx]);
+                }
+            }
+        }
+    }
+    schedule.execute();
+
+    std::vector<bool> result;
+    for (const auto* cell : cells) {
+        result.push_back(cell->alive);
+    }
+    return result;
+}
+
+struct BatchAgent {
+    bool active{true};
+    int run{};
+
+    [[nodiscard]] bool isActive() const {
+        return active;
+    }
+
+    template<typename T>
+    void step(T&) {
+        run += 100;
+    }
+
+    template<typename T>
+    static void stepBatch(std::span<BatchAgent*> agents, T& model) {
+        model.batches.push_back(agents.size());
+        for (auto* agent : agents) {
+            agent->run += 1;
+        }
+    }
+};
+
+struct BatchModel : agh::Model<BatchAgent, MyAgent> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 3;
+    }
+
+    std::vector<size_t> batches;
+};
+
+struct BreederModel;
+
+struct Breeder {
+    int id{};
+    int age{};
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+
+    void step(BreederModel& model);
+};
+
+struct BreederModel : agh::Model<Breeder> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 20;
+    }
+
+    std::function<void(Breeder&)> scheduleChild;
+    int nextId{};
+};
+
+void Breeder::step(BreederModel& model) {
+    age += 1;
+    if ((id * 31 + age) % 4 == 0) {
+        model.spawnWith<Breeder>([&model](Breeder& child) {
+            child.id = model.nextId++;
+            model.scheduleChild(child);
+        });
+    }
+    if ((id * 17 + age) % 9 == 0) {
+        model.kill(*this);
+        model.kill(*this);
+    }
+}
+
+std::vector<int> runBreeders(const size_t threads) {
+    BreederModel model;
+    agh::HandleSchedule<BreederModel, Breeder> schedule(model);
+    model.scheduleChild = [&](Breeder& child) { schedule.scheduleRepeating(child, schedule.getEpochs() + 1, 0); };
+    schedule.setThreads(threads);
+    schedule.setParallelStep(true, 8);
+    for (int i = 0; i < 200; ++i) {
+        auto& breeder = model.emplaceAgent<Breeder>(model.nextId++);
+        schedule.scheduleRepeating(breeder, 1, 0);
+    }
+    schedule.execute();
+
+    std::vector<int> ids;
+    for (const auto& breeder : model.getAgents<Breeder>()) {
+        ids.push_back(breeder.id);
+    }
+    return ids;
+}
+
+struct SeedingModel : agh::Model<MyAgent> {
+    void beforeStep() {
+        if (!seeded) {
+            seeded = true;
+            spawnWith<MyAgent>([this](MyAgent& agent) { scheduleAgent(agent); }, 0);
+        }
+    }
+
+    void afterStep() {
+        spawnWith<MyAgent>([](MyAgent&) {}, 1);
+    }
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 5;
+    }
+
+    std::function<void(MyAgent&)> scheduleAgent;
+    bool seeded{};
+};
+
+struct Mortal {
+    int id{};
+    int run{};
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+
+    template<typename T>
+    void step(T& model) {
+        run += 1;
+        if (id == 0) {
+            model.kill(*this);
+        }
+    }
+};
+
+struct MortalModel : agh::Model<Mortal> {
+    void beforeStep() {}
+
+    void afterStep() {
+        if (!newborn) {
+            spawnWith<Mortal>([this](Mortal& agent) {
+                agent.id = 1;
+                newborn = &agent;
+            });
+        }
+    }
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 5;
+    }
+
+    Mortal* newborn{};
+};
+
+template<typename ScheduleT>
+void checkHandles() {
+    MyModel model;
+    ScheduleT schedule(model);
+    auto& once = model.emplaceAgent<MyAgent>(0);
+    auto& cancelled = model.emplaceAgent<MyAgent>(1);
+    auto& moved = model.emplaceAgent<MyAgent>(2);
+    auto& slowed = model.emplaceAgent<MyAgent>(3);
+
+    auto onceHandle = schedule.scheduleOnce(once, 1, 0);
+    auto cancelledHandle = schedule.scheduleRepeating(cancelled, 1, 0, 1);
+    auto movedHandle = schedule.scheduleOnce(moved, 2, 0);
+    auto slowedHandle = schedule.scheduleRepeating(slowed, 1, 0, 1);
+    EXPECT_EQ(schedule.actionCount(), 4);
+
+    EXPECT_TRUE(cancelledHandle.cancel());
+    EXPECT_FALSE(cancelledHandle.isScheduled());
+    EXPECT_FALSE(cancelledHandle.cancel());
+    EXPECT_TRUE(movedHandle.reschedule(5, 0));
+    EXPECT_TRUE(slowedHandle.changeInterval(3));
+    EXPECT_EQ(schedule.actionCount(), 3);
+
+    schedule.execute();
+    EXPECT_EQ(once.run, 1);
+    EXPECT_EQ(cancelled.run, 0);
+    EXPECT_EQ(moved.run, 1);
+    EXPECT_EQ(slowed.run, 4);
+    EXPECT_FALSE(onceHandle.isScheduled());
+    EXPECT_FALSE(onceHandle.reschedule(20, 0));
+    EXPECT_TRUE(slowedHandle.isScheduled());
+
+    // Ids of finished actions are reused, but old handles must not refer to new actions.
+    auto reused = schedule.scheduleOnce(once, 20, 0);
+    EXPECT_TRUE(reused.isScheduled());
+    EXPECT_FALSE(onceHandle.cancel());
+    EXPECT_TRUE(reused.isScheduled());
+}
+
+struct SelfCancellingAgent {
+    bool active{true};
+    int run{};
+    std::function<void()> cancel;
+
+    [[nodiscard]] bool isActive() const {
+        return active;
+    }
+
+    template<typename T>
+    void step(T&) {
+        run += 1;
+        if (run == 3) {
+            cancel();
+        }
+    }
+};
+
+struct SelfCancellingModel : agh::Model<SelfCancellingAgent> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 10;
+    }
+};
+
+struct ShuffledAgent {
+    int id;
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+
+    template<typename T>
+    void step(T& model) {
+        model.log.push_back(id);
+    }
+};
+
+struct OtherShuffledAgent : ShuffledAgent {};
+
+struct ShuffledModel : agh::Model<ShuffledAgent, OtherShuffledAgent> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 4;
+    }
+
+    std::vector<int> log;
+};
+
+std::vector<int> runShuffled(const uint64_t seed) {
+    ShuffledModel model;
+    agh::Schedule<ShuffledModel, ShuffledAgent, OtherShuffledAgent> schedule(model);
+    schedule.setRandomActivation(true, seed);
+    for (int i = 0; i < 40; ++i) {
+        if (i % 4 == 0) {
+            schedule.scheduleRepeating(model.emplaceAgent<OtherShuffledAgent>(OtherShuffledAgent{{i}}), 0, i % 2, 1);
+        }
+        else {
+            schedule.scheduleRepeating(model.emplaceAgent<ShuffledAgent>(i), 0, i % 2, 1);
+        }
+    }
+    schedule.execute();
+    return model.log;
+}
+
+struct CoModel;
+
+struct CoAgent {
+    int tag;
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+
+    template<typename T>
+    void step(T& model);
+};
+
+struct CoModel : agh::Model<CoAgent> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 20;
+    }
+
+    void setEpoch(const size_t pEpoch) {
+        epoch = pEpoch;
+    }
+
+    std::vector<std::pair<size_t, int>> log;
+    size_t epoch{};
+};
+
+template<typename T>
+void CoAgent::step(T& model) {
+    model.log.emplace_back(model.epoch, tag);
+}
+
+using CoSchedule = agh::Schedule<CoModel, CoAgent>;
+
+agh::Behavior stages(CoSchedule& schedule, CoModel& model, const int tag) {
+    model.log.emplace_back(model.epoch, tag);
+    co_await schedule.delay(3);
+    model.log.emplace_back(model.epoch, tag);
+    co_await schedule.delay(7, 2);
+    model.log.emplace_back(model.epoch, tag);
+}
+
+agh::Behavior failing(CoSchedule& schedule) {
+    co_await schedule.delay(1);
+    throw std::runtime_error("failure");
+}
+
+agh::Behavior spawning(CoSchedule& schedule, CoModel& model, const int count) {
+    for (int i = 0; i < count; ++i) {
+        schedule.spawn(stages(schedule, model, i), schedule.getEpochs() + 1, 0);
+    }
+    co_await schedule.delay(1);
+    model.log.emplace_back(model.epoch, -2);
+}
+
+template<typename ScheduleT>
+std::vector<std::pair<size_t, int>> runLogged() {
+    LogModel model;
+    ScheduleT schedule(model);
+    for (int i = 0; i < 20; ++i) {
+        auto& agent = model.emplaceAgent<LogAgent>((7 * i) % 5);
+        schedule.scheduleRepeating(agent, i % 3, agent.order, 1 + i % 4);
+    }
+    schedule.scheduleRepeating(model.emplaceAgent<LogAgent>(0), 2, 0, 300);
+    schedule.scheduleOnce(model.emplaceAgent<LogAgent>(1), 450, 1);
+    // Agent 0 runs at every time step, so epochs are never skipped.
+    for (size_t time = 0; schedule.isActive(); ++time) {
+        model.now = time;
+        schedule.step();
+    }
+    return model.log;
+}
+
 TEST(ActionTest, CreateAction) {
     MyAgent a{1};
     MyModel m;
@@ -99,4 +602,410 @@ TEST(SchedulerTest, AgentWithAdvance) {
     schedule.execute();
     EXPECT_EQ(agent.adv, 10);
 }
+
+TEST(SchedulerTest, CalendarScheduleEvent) {
+    MyModel model;
+    agh::CalendarSchedule<MyModel, MyAgent> schedule(model);
+    schedule.scheduleRepeating(model.emplaceAgent<MyAgent>(0), 1, 1, 1);
+    schedule.scheduleRepeating(model.emplaceAgent<MyAgent>(1), 1, 1, 1);
+    schedule.execute();
+    EXPECT_EQ(model.run, 10);
+    for (const auto& agent : model.getAgents<MyAgent>()) {
+        EXPECT_EQ(agent.run, 10);
+    }
+    EXPECT_EQ(schedule.getEpochs(), 10);
+}
+
+TEST(SchedulerTest, CalendarMatchesHeapOrdering) {
+    using Heap = agh::Schedule<LogModel, LogAgent>;
+    using Calendar = agh::BasicSchedule<agh::CalendarBackend<4>, LogModel, LogAgent>;
+
+    const auto expected = runLogged<Heap>();
+    const auto actual = runLogged<Calendar>();
+
+    // Actions with the same (time, order) may run in any order, so only the sequence of pairs is compared.
+    EXPECT_EQ(expected, actual);
+}
+
+TEST(SchedulerTest, ParallelStepMatchesSerial) {
+    const auto serial = runPipeline(1);
+    EXPECT_EQ(serial, runPipeline(2));
+    EXPECT_EQ(serial, runPipeline(8));
+    EXPECT_EQ(serial, runPipeline(4, true));
+}
+
+TEST(SchedulerTest, ParallelAdvanceMatchesSerial) {
+    const auto serial = runLife(1);
+    EXPECT_EQ(serial, runLife(3));
+    EXPECT_EQ(serial, runLife(8));
+}
+
+TEST(SchedulerTest, DeferredCommandsAreDeterministic) {
+    const auto serial = runBreeders(1);
+    EXPECT_GT(serial.size(), 200);
+    EXPECT_EQ(serial, runBreeders(2));
+    EXPECT_EQ(serial, runBreeders(8));
+}
+
+TEST(SchedulerTest, ModelHooksCommandsAreFlushed) {
+    SeedingModel model;
+    agh::HandleSchedule<SeedingModel, MyAgent> schedule(model);
+    model.scheduleAgent = [&](MyAgent& agent) { schedule.scheduleRepeating(agent, schedule.getEpochs(), 0); };
+    schedule.step();
+    EXPECT_EQ(schedule.getEpochs(), 0);
+    EXPECT_EQ(model.agentCount(), 2);
+    for (const auto& agent : model.getAgents<MyAgent>()) {
+        EXPECT_EQ(agent.run, agent.id == 0 ? 1 : 0);
+    }
+
+    SeedingModel idle;
+    idle.seeded = true;
+    agh::HandleSchedule<SeedingModel, MyAgent> empty(idle);
+    empty.step();
+    EXPECT_EQ(idle.agentCount(), 1);
+}
+
+TEST(SchedulerTest, KilledAgentsAreUnscheduled) {
+    MortalModel model;
+    agh::Schedule<MortalModel, Mortal> schedule(model);
+    model.attach(schedule);
+    auto& dead = model.emplaceAgent<Mortal>();
+    const Mortal* address = &dead;
+    schedule.scheduleRepeating(dead, 1, 0, 1);
+    schedule.execute();
+
+    ASSERT_EQ(model.newborn, address);
+    EXPECT_EQ(model.newborn->run, 0);
+    EXPECT_EQ(model.agentCount(), 1);
+    EXPECT_EQ(schedule.actionCount(), 0);
+    model.detach(schedule);
+}
+
+TEST(SchedulerTest, BatchDispatch) {
+    static_assert(agh::BatchSchedulable<BatchAgent, BatchModel>);
+    static_assert(!agh::BatchSchedulable<MyAgent, BatchModel>);
+
+    BatchModel model;
+    agh::Schedule<BatchModel, BatchAgent, MyAgent> schedule(model);
+    for (int i = 0; i < 10; ++i) {
+        schedule.scheduleRepeating(model.emplaceAgent<BatchAgent>(), 1, i % 2, 1);
+        schedule.scheduleRepeating(model.emplaceAgent<MyAgent>(i), 1, i % 2, 1);
+    }
+    schedule.execute();
+
+    // One call per type for each of two order groups in each of three epochs.
+    EXPECT_EQ(model.batches, std::vector<size_t>(6, 5));
+    for (const auto& agent : model.getAgents<BatchAgent>()) {
+        EXPECT_EQ(agent.run, 3);
+    }
+    for (const auto& agent : model.getAgents<MyAgent>()) {
+        EXPECT_EQ(agent.run, 3);
+    }
+}
+
+TEST(SchedulerTest, ActionHandles) {
+    checkHandles<agh::Schedule<MyModel, MyAgent>>();
+    checkHandles<agh::BasicSchedule<agh::CalendarBackend<2>, MyModel, MyAgent>>();
+}
+
+TEST(SchedulerTest, CancelRunningAction) {
+    SelfCancellingModel model;
+    agh::Schedule<SelfCancellingModel, SelfCancellingAgent> schedule(model);
+    auto& agent = model.emplaceAgent<SelfCancellingAgent>();
+    auto handle = schedule.scheduleRepeating(agent, 1, 0, 1);
+    agent.cancel = [&] { EXPECT_TRUE(handle.cancel()); };
+    schedule.execute();
+    EXPECT_EQ(agent.run, 3);
+    EXPECT_FALSE(handle.isScheduled());
+}
+
+TEST(SchedulerTest, CancelActionDueLaterInStep) {
+    SelfCancellingModel model;
+    agh::Schedule<SelfCancellingModel, SelfCancellingAgent> schedule(model);
+    auto& hunter = model.emplaceAgent<SelfCancellingAgent>();
+    auto& prey = model.emplaceAgent<SelfCancellingAgent>();
+    auto& moved = model.emplaceAgent<SelfCancellingAgent>();
+    auto& other = model.emplaceAgent<SelfCancellingAgent>();
+    schedule.scheduleRepeating(hunter, 1, 0, 1);
+    auto preyHandle = schedule.scheduleRepeating(prey, 1, 1, 1);
+    auto movedHandle = schedule.scheduleRepeating(moved, 1, 1, 1);
+    schedule.scheduleRepeating(other, 1, 1, 1);
+    hunter.cancel = [&] {
+        EXPECT_TRUE(preyHandle.cancel());
+        EXPECT_TRUE(movedHandle.reschedule(9, 2));
+    };
+    prey.cancel = moved.cancel = other.cancel = [] {};
+
+    schedule.step();
+    schedule.step();
+    schedule.step();
+    EXPECT_EQ(schedule.getEpochs(), 3);
+    EXPECT_EQ(prey.run, 2);
+    EXPECT_EQ(moved.run, 2);
+    EXPECT_EQ(other.run, 3);
+    EXPECT_FALSE(preyHandle.isScheduled());
+
+    schedule.execute();
+    EXPECT_EQ(moved.run, 4);
+    EXPECT_EQ(other.run, 10);
+}
+
+TEST(SchedulerTest, CompactsInactiveActions) {
+    MyModel model;
+    agh::Schedule<MyModel, MyAgent> schedule(model);
+    for (int i = 0; i < 1024; ++i) {
+        schedule.scheduleRepeating(model.emplaceAgent<MyAgent>(i), 100, 0, 1);
+    }
+    for (auto& agent : model.getAgents<MyAgent>()) {
+        agent.active = false;
+    }
+    EXPECT_EQ(schedule.actionCount(), 1024);
+
+    for (int i = 0; i < 1025; ++i) {
+        schedule.scheduleRepeating(model.emplaceAgent<MyAgent>(i), 100, 0, 1);
+    }
+    EXPECT_EQ(schedule.actionCount(), 1025);
+
+    model.getAgents<MyAgent>()[2048].active = false;
+    schedule.compact();
+    EXPECT_EQ(schedule.actionCount(), 1024);
+}
+
+TEST(SchedulerTest, ProfilerRecordsPhases) {
+    using agh::profiling::Phase;
+
+    SecondModel model;
+    agh::ProfiledSchedule<SecondModel, AdvAgent> schedule(model);
+    schedule.getProfiler().setCapacity(4);
+    schedule.scheduleRepeating(model.emplaceAgent<AdvAgent>(), 0, 0, 1);
+    schedule.execute();
+
+    const auto& profiler = schedule.getProfiler();
+    ASSERT_EQ(profiler.recordedEpochs(), 4);
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(profiler.epoch(i).epoch, 7 + i);
+        EXPECT_EQ(profiler.epoch(i).actions, 1);
+    }
+    EXPECT_LE(profiler.epoch(3).steps[0].duration, profiler.epoch(3).phases[static_cast<size_t>(Phase::Step)].duration);
+    EXPECT_GE(profiler.totalStep(0), profiler.epoch(3).steps[0].duration);
+    EXPECT_GT(profiler.total(Phase::Step).count(), 0);
+
+    std::ostringstream trace;
+    profiler.writeChromeTrace(trace);
+    EXPECT_NE(trace.str().find(R"("traceEvents":[)"), std::string::npos);
+    EXPECT_NE(trace.str().find(R"("name":"reschedule")"), std::string::npos);
+    EXPECT_NE(trace.str().find(R"("cat":"advance")"), std::string::npos);
+    EXPECT_EQ(trace.str().find(R"("epoch":6,)"), std::string::npos);
+    EXPECT_NE(trace.str().find(R"("name":"advancing \"agent\"","cat":"step")"), std::string::npos);
+    EXPECT_EQ(agh::profiling::typeName<MyAgent>(2), "type 2");
+}
+
+TEST(SchedulerTest, RandomActivation) {
+    const auto log = runShuffled(1);
+    ASSERT_EQ(log.size(), 5 * 40);
+
+    std::vector<std::vector<int>> groups;
+    for (auto it = log.begin(); it != log.end(); it += 20) {
+        groups.emplace_back(it, it + 20);
+        for (const int id : groups.back()) {
+            EXPECT_EQ(id % 2, static_cast<int>(groups.size() - 1) % 2);
+        }
+    }
+    EXPECT_NE(groups[0], groups[2]);
+    EXPECT_TRUE(std::ranges::is_permutation(groups[0], groups[2]));
+
+    // Agents of both types are interleaved, instead of being stepped type by type.
+    const auto other = std::ranges::find_if(groups[0], [](const int id) { return id % 4 == 0; });
+    EXPECT_FALSE(std::all_of(other, groups[0].end(), [](const int id) { return id % 4 == 0; }));
+
+    EXPECT_EQ(runShuffled(1), log);
+    EXPECT_NE(runShuffled(2), log);
+}
+
+TEST(SchedulerTest, ProfiledRandomActivation) {
+    using agh::profiling::Phase;
+    ShuffledModel model;
+    agh::ProfiledSchedule<ShuffledModel, ShuffledAgent, OtherShuffledAgent> schedule(model);
+    schedule.setRandomActivation(true, 1);
+    for (int i = 0; i < 40; ++i) {
+        if (i % 4 == 0) {
+            schedule.scheduleRepeating(model.emplaceAgent<OtherShuffledAgent>(OtherShuffledAgent{{i}}), 0, i % 2, 1);
+        }
+        else {
+            schedule.scheduleRepeating(model.emplaceAgent<ShuffledAgent>(i), 0, i % 2, 1);
+        }
+    }
+    schedule.execute();
+
+    // Interleaved agents are stepped one by one, and their time is still recorded for both types.
+    const auto& profiler = schedule.getProfiler();
+    const auto& last = profiler.epoch(profiler.recordedEpochs() - 1);
+    EXPECT_GT(last.steps[0].duration.count(), 0);
+    EXPECT_GT(last.steps[1].duration.count(), 0);
+    EXPECT_LE(last.steps[0].duration + last.steps[1].duration, last.phases[static_cast<size_t>(Phase::Step)].duration);
+    EXPECT_GE(profiler.totalStep(0), last.steps[0].duration);
+    EXPECT_GE(profiler.totalStep(1), last.steps[1].duration);
+}
+
+TEST(SchedulerTest, CoroutineBehaviors) {
+    CoModel model;
+    CoSchedule schedule(model);
+    schedule.spawn(stages(schedule, model, 10), 1, 0);
+    schedule.spawn(stages(schedule, model, 11), 1, 1);
+    schedule.scheduleRepeating(model.emplaceAgent<CoAgent>(-1), 1, 1, 10);
+    EXPECT_EQ(schedule.behaviorCount(), 2);
+
+    schedule.step();
+    schedule.step();
+    EXPECT_EQ(schedule.getEpochs(), 4);
+    schedule.step();
+    EXPECT_EQ(schedule.getEpochs(), 11);
+    EXPECT_EQ(schedule.behaviorCount(), 0);
+
+    const std::vector<std::pair<size_t, int>> expected{
+        {1, 10}, {1, -1}, {1, 11}, {4, 10}, {4, 11}, {11, -1}, {11, 10}, {11, 11}
+    };
+    EXPECT_EQ(model.log, expected);
+}
+
+TEST(SchedulerTest, CoroutineExceptionIsRethrown) {
+    CoModel model;
+    CoSchedule schedule(model);
+    schedule.spawn(failing(schedule), 0, 0);
+    schedule.spawn(stages(schedule, model, 10), 1, 1);
+    schedule.scheduleRepeating(model.emplaceAgent<CoAgent>(-1), 1, 2, 1);
+    schedule.step();
+    EXPECT_THROW(schedule.step(), std::runtime_error);
+
+    // The step is completed before rethrowing, so the schedule keeps running the remaining actions and behaviors.
+    EXPECT_EQ(schedule.behaviorCount(), 1);
+    EXPECT_EQ(schedule.actionCount(), 1);
+    for (int i = 0; i < 3; ++i) {
+        schedule.step();
+    }
+    const std::vector<std::pair<size_t, int>> expected{
+        {1, 10}, {1, -1}, {2, -1}, {3, -1}, {4, 10}, {4, -1}
+    };
+    EXPECT_EQ(model.log, expected);
+}
+
+TEST(SchedulerTest, CoroutineSpawnsBehaviors) {
+    CoModel model;
+    CoSchedule schedule(model);
+    schedule.spawn(spawning(schedule, model, 100), 0, 0);
+    schedule.step();
+    EXPECT_EQ(schedule.behaviorCount(), 101);
+    EXPECT_EQ(model.log.size(), 0);
+
+    schedule.step();
+    EXPECT_EQ(schedule.behaviorCount(), 100);
+    EXPECT_EQ(model.log.size(), 101);
+    EXPECT_EQ(std::ranges::count(model.log, std::pair<size_t, int>{1, -2}), 1);
+}
+
+static_assert(sizeof(agh::Schedule<MyModel, MyAgent>) < sizeof(agh::ProfiledSchedule<MyModel, MyAgent>));
+
+TEST(SchedulerTest, HandleScheduleDropsRemovedAgents) {
+    using HandleSchedule = agh::HandleSchedule<BatchModel, BatchAgent, MyAgent>;
+    using PointerSchedule = agh::Schedule<BatchModel, BatchAgent, MyAgent>;
+    static_assert(sizeof(HandleSchedule::ActionItem) < sizeof(PointerSchedule::ActionItem));
+
+    BatchModel model;
+    HandleSchedule schedule(model);
+    auto& batched = model.emplaceAgent<BatchAgent>();
+    auto& kept = model.emplaceAgent<MyAgent>(0);
+    auto& removed = model.emplaceAgent<MyAgent>(1);
+    schedule.scheduleRepeating(batched, 1, 0);
+    schedule.scheduleRepeating(kept, 1, 0);
+    schedule.scheduleRepeating(removed, 1, 1);
+    schedule.step();
+
+    model.removeAgent(removed);
+    auto& replacement = model.emplaceAgent<MyAgent>(2);
+    ASSERT_EQ(&replacement, &removed);
+    schedule.execute();
+
+    EXPECT_EQ(batched.run, 3);
+    EXPECT_EQ(kept.run, 3);
+    EXPECT_EQ(replacement.run, 0);
+    EXPECT_EQ(schedule.actionCount(), 2);
+}
+
+struct Walker {
+    explicit Walker(const int pId) : id(pId) {}
+    int id;
+    bool active{true};
+    int run{};
+    std::optional<agh::Point> pos;
+
+    [[nodiscard]] bool isActive() const {
+        return active;
+    }
+
+    template<typename T>
+    void step(T&) {
+        run += 1;
+    }
+
+    bool operator==(const Walker& rhs) const {
+        return id == rhs.id;
+    }
+};
+
+struct WalkerModel : agh::Model<Walker> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 10;
+    }
+};
+
+TEST(SchedulerTest, CompactRelocatesAttachedReferences) {
+    WalkerModel model;
+    agh::Schedule<WalkerModel, Walker> schedule(model);
+    agh::Field<Walker> field(4, 4);
+    agh::MultiagentField<Walker> crowd(4, 4);
+    model.attach(schedule);
+    model.attach(field);
+    model.attach(crowd);
+
+    for (int i = 0; i < 8; ++i) {
+        auto& walker = model.emplaceAgent<Walker>(i);
+        schedule.scheduleRepeating(walker, 1, 0);
+        field.addAgent(walker, {i % 4, i / 4});
+        crowd.addAgent(walker, {0, 0});
+    }
+    schedule.step();
+    for (auto& walker : model.getAgents<Walker>()) {
+        walker.active = walker.id % 3 != 0;
+    }
+
+    EXPECT_EQ(model.compact(), 3);
+    EXPECT_EQ(model.getAgents<Walker>().slots(), 5);
+    EXPECT_EQ(schedule.actionCount(), 5);
+    EXPECT_EQ(crowd.agentCount({0, 0}), 5);
+    for (auto agent : crowd.getAgents({0, 0})) {
+        EXPECT_EQ(std::get<Walker*>(agent)->id % 3 != 0, true);
+    }
+    for (int i = 0; i < 8; ++i) {
+        const agh::Point p{i % 4, i / 4};
+        if (i % 3 == 0) {
+            EXPECT_TRUE(field.isEmpty(p));
+        }
+        else {
+            ASSERT_FALSE(field.isEmpty(p));
+            EXPECT_EQ(std::get<Walker*>(*field.getAgent(p))->id, i);
+        }
+    }
+
+    schedule.step();
+    for (auto& walker : model.getAgents<Walker>()) {
+        EXPECT_EQ(walker.run, 2);
+    }
+    model.detach(crowd);
+    model.detach(field);
+    model.detach(schedule);
+}
 }
@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "../include/model/Model.hpp"
+#include "../include/model/SoaPool.hpp"
+#include "../include/schedule/Schedule.hpp"
+
+namespace test::soa_pool {
+struct Particle {
+    double x{};
+    double energy{};
+    int id{};
+
+    static constexpr auto members = std::tuple{&Particle::x, &Particle::energy, &Particle::id};
+
+    [[nodiscard]] bool isActive() const {
+        return energy > 0.;
+    }
+
+    template<typename T>
+    void step(T& model) {
+        x += 1.;
+        energy -= model.cost;
+    }
+};
+
+struct Observer {
+    int seen{};
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+};
+
+struct SoaModel : agh::Model<Particle, Observer> {
+    double cost{0.5};
+};
+
+struct Tracer {
+    double x{};
+    double speed{};
+    int steps{};
+
+    static constexpr auto members = std::tuple{&Tracer::x, &Tracer::speed, &Tracer::steps};
+    static constexpr auto activeMembers = std::tuple{&Tracer::speed};
+
+    [[nodiscard]] bool isActive() const {
+        return speed > 0.;
+    }
+
+    template<typename T>
+    void step(T&) {
+        x += speed;
+        steps += 1;
+    }
+
+    // Tracer is incomplete here, so the proxy type is deduced instead of being spelled as SoaReference<Tracer>.
+    template<typename R, typename T>
+    static void stepBatch(const std::span<R> tracers, T& model) {
+        model.batchCalls += 1;
+        for (const R tracer : tracers) {
+            tracer.template get<&Tracer::x>() += tracer.template get<&Tracer::speed>();
+            tracer.template get<&Tracer::steps>() += 1;
+        }
+    }
+};
+
+struct ScheduledModel : agh::Model<Particle, Tracer> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 10;
+    }
+
+    double cost{0.5};
+    int batchCalls{};
+};
+
+struct Fuse {
+    int timer{};
+
+    static constexpr auto members = std::tuple{&Fuse::timer};
+
+    [[nodiscard]] bool isActive() const {
+        return true;
+    }
+
+    template<typename T>
+    void step(T&) {}
+
+    // Step of the proxy would run on a copy, which is not in the model, so the fuse kills itself through its proxy.
+    template<typename R, typename T>
+    static void stepBatch(const std::span<R> fuses, T& model) {
+        for (const R fuse : fuses) {
+            if (--fuse.template get<&Fuse::timer>() == 0) {
+                model.kill(fuse);
+            }
+        }
+    }
+};
+
+struct FuseModel : agh::Model<Fuse> {
+    void beforeStep() {}
+
+    void afterStep() {}
+
+    [[nodiscard]] bool shouldEnd(const int epochs) const {
+        return epochs >= 10;
+    }
+};
+
+TEST(SoaPoolTest, ColumnsAreContiguousAndAligned) {
+    agh::SoaPool<Particle> pool;
+    for (int i = 0; i < 100; ++i) {
+        pool.emplace(static_cast<double>(i), 1., i);
+    }
+
+    const auto x = pool.column<&Particle::x>();
+    const auto ids = pool.column<&Particle::id>();
+    ASSERT_EQ(x.size(), 100);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(x.data()) % 64, 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ids.data()) % 64, 0);
+    EXPECT_EQ(std::accumulate(x.begin(), x.end(), 0.), 4950.);
+    EXPECT_EQ(ids[42], 42);
+    EXPECT_EQ(pool[7].get<&Particle::x>(), 7.);
+}
+
+TEST(SoaPoolTest, ProxyReferences) {
+    agh::SoaPool<Particle> pool;
+    const auto first = pool.emplace(1., 2., 3);
+    const auto second = pool.emplace(4., 5., 6);
+
+    first.get<&Particle::energy>() = 10.;
+    const Particle loaded = first.load();
+    EXPECT_EQ(loaded.x, 1.);
+    EXPECT_EQ(loaded.energy, 10.);
+    EXPECT_EQ(loaded.id, 3);
+
+    second.store(Particle{7., 8., 9});
+    EXPECT_EQ(pool.column<&Particle::x>()[1], 7.);
+    EXPECT_EQ(static_cast<Particle>(second).id, 9);
+
+    pool.erase(first);
+    EXPECT_EQ(pool.size(), 1);
+    std::vector<int> ids;
+    for (const auto agent : pool) {
+        ids.push_back(agent.get<&Particle::id>());
+    }
+    EXPECT_EQ(ids, std::vector<int>{9});
+
+    const auto third = pool.emplace(0., 1., 11);
+    EXPECT_EQ(third.slot(), first.slot());
+    EXPECT_EQ(pool.slots(), 2);
+}
+
+TEST(SoaPoolTest, ModelStoresSoaAgents) {
+    SoaModel model;
+    static_assert(std::is_same_v<decltype(model.getAgents<Particle>()), agh::SoaPool<Particle>&>);
+    static_assert(std::is_same_v<decltype(model.getAgents<Observer>()), agh::AgentPool<Observer>&>);
+
+    const auto particle = model.emplaceAgent<Particle>(0., 1., 1);
+    model.emplaceAgent<Particle>(0., 2., 2);
+    model.emplaceAgent<Observer>();
+    EXPECT_EQ(model.agentCount(), 3);
+
+    for (const auto agent : model.getAgents<Particle>()) {
+        agent.step(model);
+    }
+    EXPECT_EQ(particle.get<&Particle::x>(), 1.);
+    EXPECT_EQ(particle.get<&Particle::energy>(), 0.5);
+    EXPECT_TRUE(particle.isActive());
+
+    const agh::AgentHandle handle = model.handleOf(particle);
+    EXPECT_EQ(model.get<Particle>(handle), particle);
+    int visited = 0;
+    EXPECT_TRUE(model.visit(handle, [&]<typename R>(R agent) {
+        if constexpr (std::is_same_v<R, agh::SoaReference<Particle>>) {
+            visited = agent.template get<&Particle::id>();
+        }
+    }));
+    EXPECT_EQ(visited, 1);
+
+    model.removeAgent(particle);
+    EXPECT_FALSE(model.isAlive(handle));
+    EXPECT_FALSE(model.get<Particle>(handle));
+    EXPECT_EQ(model.agentCount<Particle>(), 1);
+}
+
+TEST(SoaPoolTest, HandleScheduleStepsSoaAgents) {
+    using Schedule = agh::HandleSchedule<ScheduledModel, Particle, Tracer>;
+    static_assert(std::is_same_v<Schedule::AgentPointer<Tracer>, agh::SoaReference<Tracer>>);
+
+    ScheduledModel model;
+    Schedule schedule(model);
+    const auto particle = model.emplaceAgent<Particle>(0., 1., 1);
+    schedule.scheduleRepeating(particle, 0, 0);
+    std::vector<agh::SoaReference<Tracer>> tracers;
+    for (int i = 0; i < 3; ++i) {
+        tracers.push_back(model.emplaceAgent<Tracer>(0., 1. + i, 0));
+        schedule.scheduleRepeating(tracers.back(), 0, 1);
+    }
+    schedule.scheduleRepeating(model.emplaceAgent<Tracer>(0., 0., 0), 0, 1);
+
+    for (int i = 0; i < 3; ++i) {
+        schedule.step();
+    }
+    // The particle runs out of energy after two steps, and the tracer without speed is never stepped.
+    EXPECT_EQ(particle.get<&Particle::x>(), 2.);
+    EXPECT_EQ(particle.get<&Particle::energy>(), 0.);
+    EXPECT_EQ(schedule.actionCount(), 3);
+    EXPECT_EQ(model.batchCalls, 3);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(tracers[i].get<&Tracer::x>(), 3. * (1. + i));
+        EXPECT_EQ(tracers[i].get<&Tracer::steps>(), 3);
+    }
+
+    model.removeAgent(tracers[1]);
+    schedule.step();
+    EXPECT_EQ(schedule.actionCount(), 2);
+    EXPECT_EQ(tracers[0].get<&Tracer::steps>(), 4);
+    EXPECT_EQ(tracers[2].get<&Tracer::steps>(), 4);
+}
+
+TEST(SoaPoolTest, SoaAgentKillsItself) {
+    FuseModel model;
+    agh::HandleSchedule<FuseModel, Fuse> schedule(model);
+    std::vector<agh::SoaReference<Fuse>> fuses;
+    for (int i = 0; i < 4; ++i) {
+        fuses.push_back(model.emplaceAgent<Fuse>(i + 1));
+        schedule.scheduleRepeating(fuses.back(), 0, 0);
+    }
+
+    schedule.step();
+    schedule.step();
+    EXPECT_EQ(model.agentCount(), 2);
+    EXPECT_EQ(schedule.actionCount(), 2);
+    EXPECT_EQ(fuses[2].get<&Fuse::timer>(), 1);
+
+    schedule.execute();
+    EXPECT_EQ(model.agentCount(), 0);
+    EXPECT_EQ(schedule.actionCount(), 0);
+}
+}
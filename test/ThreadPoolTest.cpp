@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <stdexcept>
+
+#include "../include/utilities/ThreadPool.hpp"
+
+namespace test::thread_pool {
+TEST(ThreadPoolTest, VisitsEveryIndexOnce) {
+    agh::ThreadPool pool(4);
+    std::vector<int> visits(10'000);
+    pool.parallelFor(0, visits.size(), 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            visits[i] += 1;
+        }
+    });
+    for (const int v : visits) {
+        EXPECT_EQ(v, 1);
+    }
+}
+
+TEST(ThreadPoolTest, RespectsGrain) {
+    agh::ThreadPool pool(3);
+    std::atomic<size_t> chunks{0};
+    pool.parallelFor(5, 105, 10, [&](size_t begin, size_t end) {
+        EXPECT_LE(end - begin, 10);
+        chunks += 1;
+    });
+    EXPECT_EQ(chunks, 10);
+}
+
+TEST(ThreadPoolTest, SingleThread) {
+    agh::ThreadPool pool(1);
+    EXPECT_EQ(pool.size(), 1);
+    size_t sum = 0;
+    pool.parallelFor(0, 100, 7, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            sum += i;
+        }
+    });
+    EXPECT_EQ(sum, 4950);
+}
+
+TEST(ThreadPoolTest, NestedParallelFor) {
+    agh::ThreadPool pool(4);
+    std::vector<std::atomic<int>> counts(16);
+    pool.parallelFor(0, 16, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            pool.parallelFor(0, 100, 10, [&](size_t b, size_t e) { counts[i] += static_cast<int>(e - b); });
+        }
+    });
+    for (const auto& c : counts) {
+        EXPECT_EQ(c, 100);
+    }
+}
+
+TEST(ThreadPoolTest, PropagatesException) {
+    agh::ThreadPool pool(4);
+    EXPECT_THROW(pool.parallelFor(0, 100, 1, [](size_t begin, size_t) {
+                     if (begin == 42) throw std::runtime_error("failure");
+                 }),
+                 std::runtime_error);
+
+    std::atomic<size_t> sum{0};
+    pool.parallelFor(0, 10, 1, [&](size_t begin, size_t) { sum += begin; });
+    EXPECT_EQ(sum, 45);
+}
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <execution>
+
 #include "../include/space/ValueLayer.hpp"
 
 namespace test::value_layer {
@@ -72,4 +74,123 @@ TEST(ValueLayerTest, GetNeighborhood) {
     EXPECT_EQ(vonNeumann.size(), 4);
     EXPECT_EQ(vonNeumannCenter.size(), 5);
 }
+
+TEST(ValueLayerTest, ForEachNeighbor) {
+    agh::IntValueLayer layer(3, 3, true);
+    for (int y = 0; y < 3; ++y) {
+        for (int x = 0; x < 3; ++x) {
+            layer.setOnRead({x, y}, y * 3 + x);
+        }
+    }
+
+    const agh::Stencil vonNeumann = agh::Stencil::vonNeumann();
+    std::vector<int> values;
+    EXPECT_TRUE(layer.forEachNeighbor({0, 0}, vonNeumann, [&](agh::Point, const int value) {
+        values.push_back(value);
+    }));
+    EXPECT_EQ(values, (std::vector<int>{6, 2, 1, 3}));
+
+    int visited = 0;
+    EXPECT_FALSE(layer.forEachNeighbor({1, 1}, agh::Stencil::moore(1, true), [&](const agh::Point p, int) {
+        ++visited;
+        return p != agh::Point{1, 1};
+    }));
+    EXPECT_EQ(visited, 5);
+
+    const agh::Stencil disc = agh::Stencil::custom(2, [](const agh::Point d) { return d.x * d.x + d.y * d.y <= 4; });
+    EXPECT_EQ(disc.offsets().size(), 13);
+    EXPECT_EQ(disc.radius(), 2);
+}
+
+TEST(ValueLayerTest, StaticGeometry) {
+    agh::ValueLayer<int, agh::Extent<4, 4>, agh::Torus> layer(1);
+    agh::IntValueLayer dynamic(4, 4, true, 1);
+    EXPECT_EQ(layer.getWidth(), 4);
+    EXPECT_EQ(layer.getHeight(), 4);
+    EXPECT_TRUE(layer.isToroidal());
+    EXPECT_EQ(layer.toToroidal({-1, 5}), (agh::Point{3, 1}));
+    EXPECT_EQ(layer.toToroidal({-5, -4}), dynamic.toToroidal({-5, -4}));
+
+    layer.setOnRead({3, 3}, 5);
+    dynamic.setOnRead({3, 3}, 5);
+    EXPECT_EQ(layer.getNeighbors({0, 0}, 1, true, false), dynamic.getNeighbors({0, 0}, 1, true, false));
+
+    constexpr auto moore = agh::Stencil::fixedMoore<1>();
+    static_assert(moore.offsets().size() == 8 && moore.radius() == 1);
+    static_assert(agh::Stencil::fixedVonNeumann<2, true>().offsets().size() == 13);
+    int sum = 0;
+    layer.forEachNeighbor({0, 0}, moore, [&](agh::Point, const int value) { sum += value; });
+    EXPECT_EQ(sum, 12);
+
+    const agh::ValueLayer<int, agh::Extent<3, 5>, agh::Torus> odd;
+    EXPECT_EQ(odd.toToroidal({-1, -6}), (agh::Point{2, 4}));
+    const agh::ValueLayer<int, agh::DynamicExtent, agh::Bounded> bounded(3, 3);
+    EXPECT_FALSE(bounded.isToroidal());
+    EXPECT_EQ(bounded.getNeighbors({0, 0}, 1, true, false).size(), 3);
+}
+
+template<typename Layout>
+void checkLayout() {
+    agh::ValueLayer<int, agh::DynamicExtent, agh::DynamicTopology, Layout> layer(10, 7, true);
+    agh::IntValueLayer reference(10, 7, true);
+    int cells = 0;
+    layer.transform([&](const agh::Point p, int& value) {
+        value = p.y * 10 + p.x;
+        ++cells;
+    });
+    reference.transform([](const agh::Point p, int& value) { value = p.y * 10 + p.x; });
+    layer.apply([](int& value) { value += 1; });
+    reference.apply([](int& value) { value += 1; });
+    layer.swap();
+    reference.swap();
+    EXPECT_EQ(cells, 70);
+
+    const agh::Stencil disc = agh::Stencil::custom(3, [](const agh::Point d) { return d.x * d.x + d.y * d.y <= 9; });
+    for (int y = 0; y < 7; ++y) {
+        for (int x = 0; x < 10; ++x) {
+            EXPECT_EQ(layer.get({x, y}), y * 10 + x + 1);
+            EXPECT_EQ(layer.getNeighbors({x, y}, 2, false, true), reference.getNeighbors({x, y}, 2, false, true));
+            std::vector<int> values;
+            std::vector<int> expected;
+            layer.forEachNeighbor({x, y}, disc, [&](agh::Point, const int value) { values.push_back(value); });
+            reference.forEachNeighbor({x, y}, disc, [&](agh::Point, const int value) { expected.push_back(value); });
+            EXPECT_EQ(values, expected);
+        }
+    }
+}
+
+TEST(ValueLayerTest, Layouts) {
+    checkLayout<agh::Tiled<4>>();
+    checkLayout<agh::Morton>();
+}
+
+TEST(ValueLayerTest, ParallelTransform) {
+    agh::ValueLayer<int> layer(300, 200);
+    agh::ValueLayer<int, agh::DynamicExtent, agh::DynamicTopology, agh::Tiled<8>> tiled(300, 200);
+    agh::ThreadPool pool(4);
+    layer.setThreadPool(&pool);
+    tiled.setThreadPool(&pool);
+
+    layer.transform(std::execution::par, [](const agh::Point p, int& v) { v = p.x + 1000 * p.y; });
+    tiled.transform(std::execution::par, [](const agh::Point p, int& v) { v = p.x + 1000 * p.y; });
+    layer.apply(std::execution::par, [](int& v) { v *= 2; });
+    tiled.apply(std::execution::par, [](int& v) { v *= 2; });
+
+    for (int y = 0; y < 200; ++y) {
+        for (int x = 0; x < 300; ++x) {
+            EXPECT_EQ(layer.getFromWrite({x, y}), 2 * (x + 1000 * y));
+            EXPECT_EQ(tiled.getFromWrite({x, y}), 2 * (x + 1000 * y));
+        }
+    }
+}
+
+TEST(ValueLayerTest, EmptyGrid) {
+    agh::ValueLayer<int> layer(0, 5);
+    int calls = 0;
+    layer.apply([&calls](int&) { calls += 1; });
+    layer.transform([&calls](agh::Point, int&) { calls += 1; });
+    layer.apply(std::execution::par, [&calls](int&) { calls += 1; });
+    layer.transform(std::execution::par, [&calls](agh::Point, int&) { calls += 1; });
+    EXPECT_EQ(calls, 0);
+}
 }